@@ -36,6 +36,7 @@
 ******************************************************************************/
 
 #include "omx_buffer_handle.h"
+#include <cassert>
 
 OMXBufferHandle::OMXBufferHandle(OMX_BUFFERHEADERTYPE* header) : BufferHandleInterface((char*)header->pBuffer, header->nAllocLen), header(header)
 {
@@ -45,3 +46,18 @@ OMXBufferHandle::OMXBufferHandle(OMX_BUFFERHEADERTYPE* header) : BufferHandleInt
 
 OMXBufferHandle::~OMXBufferHandle() = default;
 
+void OMXBufferHandle::Reset()
+{
+  offset = header->nOffset;
+  payload = header->nFilledLen;
+}
+
+OMXBufferHandle* GetBufferHandle(OMX_BUFFERHEADERTYPE* header)
+{
+  auto handle = static_cast<OMXBufferHandle*>(header->pPlatformPrivate);
+  assert(handle);
+  assert(handle->header == header);
+  handle->Reset();
+  return handle;
+}
+
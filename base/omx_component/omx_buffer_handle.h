@@ -49,6 +49,14 @@ struct OMXBufferHandle : BufferHandleInterface
   OMXBufferHandle(OMX_BUFFERHEADERTYPE* header);
   ~OMXBufferHandle() override;
 
+  void Reset();
+
   OMX_BUFFERHEADERTYPE* const header;
 };
 
+/**
+ * @brief Gets the handle owned by the header (created with it, stored in
+ * pPlatformPrivate) and resets its offset and payload from the header.
+ */
+OMXBufferHandle* GetBufferHandle(OMX_BUFFERHEADERTYPE* header);
+
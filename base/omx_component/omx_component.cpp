@@ -70,11 +70,55 @@ static Task* CreateTask(Command cmd, OMX_U32 data, shared_ptr<void> opt)
   return task;
 }
 
+Task* Component::CreateBufferTask(Command cmd, int index, OMX_BUFFERHEADERTYPE* header)
+{
+  auto task = taskPool.Acquire();
+  task->cmd = cmd;
+  task->data = reinterpret_cast<uintptr_t*>(index);
+  task->header = header;
+  return task;
+}
+
+void Component::DeleteTask(Task* task)
+{
+  taskPool.Release(task);
+}
+
+void Component::QueueMain(Task* task)
+{
+  mainPending.fetch_add(1);
+  processorMain->queue(task);
+}
+
+/* Buffers skip the main processor when nothing is queued on it: no command
+ * can then be ordered before them. directDispatchers and mainPending are
+ * checked in opposite order by the main processor (see WaitDirectDispatchers)
+ * so a buffer can never be queued directly while a command is being treated */
+void Component::DispatchBuffer(Task* task, unique_ptr<ProcessorFifo>& processor)
+{
+  directDispatchers.fetch_add(1);
+
+  if(mainPending.load() == 0)
+  {
+    processor->queue(task);
+    directDispatchers.fetch_sub(1);
+    return;
+  }
+
+  directDispatchers.fetch_sub(1);
+  QueueMain(task);
+}
+
+void Component::WaitDirectDispatchers()
+{
+  while(directDispatchers.load() != 0)
+    this_thread::yield();
+}
+
 void Component::EmptyThisBufferCallBack(BufferHandleInterface* handle)
 {
   auto emptied = ((OMXBufferHandle*)(handle))->header;
   ReturnEmptiedBuffer(emptied);
-  delete handle;
 }
 
 void Component::AssociateCallBack(BufferHandleInterface* empty, BufferHandleInterface* fill)
@@ -109,14 +153,12 @@ void Component::ReturnFilledBuffer(OMX_BUFFERHEADERTYPE* filled, int offset, int
 void Component::FillThisBufferCallBack(BufferHandleInterface* filled, int offset, int size)
 {
   auto header = ((OMXBufferHandle*)filled)->header;
-  delete filled;
   ReturnFilledBuffer(header, offset, size);
 }
 
 void Component::ReleaseCallBack(bool isInput, BufferHandleInterface* released)
 {
   auto header = ((OMXBufferHandle*)released)->header;
-  delete released;
 
   if(isInput)
     ReturnEmptiedBuffer(header);
@@ -151,7 +193,7 @@ void Component::EventCallBack(CallbackEventType type, void* data)
   case CALLBACK_EVENT_ERROR:
   {
     ErrorType errorCode = (ErrorType)(uintptr_t)data;
-    processorMain->queue(CreateTask(SetState, OMX_StateInvalid, shared_ptr<void>((uintptr_t*)ToOmxError(errorCode), nullDeleter)));
+    QueueMain(CreateTask(SetState, OMX_StateInvalid, shared_ptr<void>((uintptr_t*)ToOmxError(errorCode), nullDeleter)));
     break;
   }
   default:
@@ -176,6 +218,11 @@ Port* Component::GetPort(int index)
   return IsInputPort(index) ? &input : &output;
 }
 
+/* Each buffer can be queued again by the client before the processor which
+ * treated it has released its task, hence two tasks per buffer */
+static int const TASKS_PER_BUFFER = 2;
+static size_t const MAX_POOLED_TASKS = 256;
+
 static void AssociateSpecVersion(OMX_VERSIONTYPE& spec)
 {
   spec.s.nVersionMajor = OMX_VERSION_MAJOR;
@@ -189,7 +236,8 @@ Component::Component(OMX_HANDLETYPE component, shared_ptr<MediatypeInterface> me
   media(media),
   module(move(module)),
   expertise(move(expertise)),
-  input(0, this->module->GetBufferRequirements().input.min), output(1, this->module->GetBufferRequirements().output.min)
+  input(0, this->module->GetBufferRequirements().input.min), output(1, this->module->GetBufferRequirements().output.min),
+  taskPool(MAX_POOLED_TASKS)
 {
   assert(name);
   assert(role);
@@ -214,6 +262,8 @@ Component::Component(OMX_HANDLETYPE component, shared_ptr<MediatypeInterface> me
   processorFill.reset(new ProcessorFifo(p2, d2));
   processorEmpty.reset(new ProcessorFifo(p3, d2));
   pausePromise = nullptr;
+  mainPending = 0;
+  directDispatchers = 0;
 
   transientState = TransientMax;
   state = OMX_StateLoaded;
@@ -291,7 +341,7 @@ void Component::CreateCommand(OMX_COMMANDTYPE command, OMX_U32 param, OMX_PTR da
     if(param == OMX_ALL)
     {
       for(auto i = videoPortParams.nStartPortNumber; i < videoPortParams.nPorts; i++)
-        processorMain->queue(CreateTask(Flush, i, shared_ptr<void>(data, nullDeleter)));
+        QueueMain(CreateTask(Flush, i, shared_ptr<void>(data, nullDeleter)));
 
       return;
     }
@@ -310,7 +360,7 @@ void Component::CreateCommand(OMX_COMMANDTYPE command, OMX_U32 param, OMX_PTR da
         GetPort(i)->enable = false;
         GetPort(i)->isTransientToDisable = true;
         isSettingsInit = false;
-        processorMain->queue(CreateTask(DisablePort, i, shared_ptr<void>(data, nullDeleter)));
+        QueueMain(CreateTask(DisablePort, i, shared_ptr<void>(data, nullDeleter)));
       }
 
       return;
@@ -334,7 +384,7 @@ void Component::CreateCommand(OMX_COMMANDTYPE command, OMX_U32 param, OMX_PTR da
         GetPort(i)->enable = true;
         GetPort(i)->isTransientToEnable = true;
         isSettingsInit = true;
-        processorMain->queue(CreateTask(EnablePort, i, shared_ptr<void>(data, nullDeleter)));
+        QueueMain(CreateTask(EnablePort, i, shared_ptr<void>(data, nullDeleter)));
       }
 
       return;
@@ -361,7 +411,7 @@ void Component::CreateCommand(OMX_COMMANDTYPE command, OMX_U32 param, OMX_PTR da
     throw OMX_ErrorBadParameter;
   }
 
-  processorMain->queue(CreateTask(taskCommand, param, shared_ptr<void>(data, nullDeleter)));
+  QueueMain(CreateTask(taskCommand, param, shared_ptr<void>(data, nullDeleter)));
 }
 
 OMX_ERRORTYPE Component::SendCommand(OMX_IN OMX_COMMANDTYPE cmd, OMX_IN OMX_U32 param, OMX_IN OMX_PTR data)
@@ -613,6 +663,12 @@ OMX_ERRORTYPE Component::GetParameter(OMX_IN OMX_INDEXTYPE index, OMX_INOUT OMX_
     auto la = static_cast<OMX_ALG_VIDEO_PARAM_LOOKAHEAD*>(param);
     return ConstructVideoLookAhead(*la, *port, media);
   }
+  case OMX_ALG_IndexParamVideoSceneChangeDetection:
+  {
+    auto port = getCurrentPort(param);
+    auto scd = static_cast<OMX_ALG_VIDEO_PARAM_SCENE_CHANGE_DETECTION*>(param);
+    return ConstructVideoSceneChangeDetection(*scd, *port, media);
+  }
   // only decoder
   case OMX_ALG_IndexParamPreallocation:
   {
@@ -814,6 +870,11 @@ OMX_ERRORTYPE Component::SetParameter(OMX_IN OMX_INDEXTYPE index, OMX_IN OMX_PTR
     auto la = static_cast<OMX_ALG_VIDEO_PARAM_LOOKAHEAD*>(param);
     return SetVideoLookAhead(*la, *port, media);
   }
+  case OMX_ALG_IndexParamVideoSceneChangeDetection:
+  {
+    auto scd = static_cast<OMX_ALG_VIDEO_PARAM_SCENE_CHANGE_DETECTION*>(param);
+    return SetVideoSceneChangeDetection(*scd, *port, media);
+  }
   // only decoder
   case OMX_ALG_IndexParamPreallocation:
   {
@@ -858,6 +919,7 @@ static OMX_BUFFERHEADERTYPE* AllocateHeader(OMX_PTR app, int size, OMX_U8* buffe
   header->pAppPrivate = app;
   header->pInputPortPrivate = new bool(isBufferAllocatedByModule);
   header->pOutputPortPrivate = new bool(isBufferAllocatedByModule);
+  header->pPlatformPrivate = new OMXBufferHandle(header);
   auto& p = IsInputPort(index) ? header->nInputPortIndex : header->nOutputPortIndex;
   p = index;
 
@@ -879,6 +941,7 @@ static void DeleteHeader(OMX_BUFFERHEADERTYPE* header)
 {
   delete (bool*)header->pInputPortPrivate;
   delete (bool*)header->pOutputPortPrivate;
+  delete (OMXBufferHandle*)header->pPlatformPrivate;
   delete header;
 }
 
@@ -986,7 +1049,7 @@ OMX_ERRORTYPE Component::EmptyThisBuffer(OMX_IN OMX_BUFFERHEADERTYPE* header)
   OMXChecker::CheckStateOperation(AL_EmptyThisBuffer, state);
   CheckPortIndex(header->nInputPortIndex);
 
-  processorMain->queue(CreateTask(EmptyBuffer, static_cast<OMX_U32>(input.index), shared_ptr<void>(header, nullDeleter)));
+  DispatchBuffer(CreateBufferTask(EmptyBuffer, input.index, header), processorEmpty);
 
   return OMX_ErrorNone;
   OMX_CATCH();
@@ -1004,7 +1067,7 @@ OMX_ERRORTYPE Component::FillThisBuffer(OMX_IN OMX_BUFFERHEADERTYPE* header)
   header->pMarkData = NULL;
   header->nFlags = 0;
 
-  processorMain->queue(CreateTask(FillBuffer, static_cast<OMX_U32>(output.index), shared_ptr<void>(header, nullDeleter)));
+  DispatchBuffer(CreateBufferTask(FillBuffer, output.index, header), processorFill);
 
   return OMX_ErrorNone;
   OMX_CATCH();
@@ -1090,7 +1153,7 @@ OMX_ERRORTYPE Component::SetConfig(OMX_IN OMX_INDEXTYPE index, OMX_IN OMX_PTR co
     if(bitrate->nEncodeBitrate == 0)
       throw OMX_ErrorBadParameter;
 
-    processorMain->queue(CreateTask(SetDynamic, OMX_IndexConfigVideoBitrate, shared_ptr<void>(bitrate)));
+    QueueMain(CreateTask(SetDynamic, OMX_IndexConfigVideoBitrate, shared_ptr<void>(bitrate)));
 
     return OMX_ErrorNone;
   }
@@ -1099,7 +1162,7 @@ OMX_ERRORTYPE Component::SetConfig(OMX_IN OMX_INDEXTYPE index, OMX_IN OMX_PTR co
     OMX_CONFIG_FRAMERATETYPE* framerate = new OMX_CONFIG_FRAMERATETYPE;
     memcpy(framerate, static_cast<OMX_CONFIG_FRAMERATETYPE*>(config), sizeof(OMX_CONFIG_FRAMERATETYPE));
 
-    processorMain->queue(CreateTask(SetDynamic, OMX_IndexConfigVideoFramerate, shared_ptr<void>(framerate)));
+    QueueMain(CreateTask(SetDynamic, OMX_IndexConfigVideoFramerate, shared_ptr<void>(framerate)));
 
     return OMX_ErrorNone;
   }
@@ -1107,42 +1170,42 @@ OMX_ERRORTYPE Component::SetConfig(OMX_IN OMX_INDEXTYPE index, OMX_IN OMX_PTR co
   {
     OMX_ALG_VIDEO_CONFIG_INSERT* idr = new OMX_ALG_VIDEO_CONFIG_INSERT;
     memcpy(idr, static_cast<OMX_ALG_VIDEO_CONFIG_INSERT*>(config), sizeof(OMX_ALG_VIDEO_CONFIG_INSERT));
-    processorMain->queue(CreateTask(SetDynamic, OMX_ALG_IndexConfigVideoInsertInstantaneousDecodingRefresh, shared_ptr<void>(idr)));
+    QueueMain(CreateTask(SetDynamic, OMX_ALG_IndexConfigVideoInsertInstantaneousDecodingRefresh, shared_ptr<void>(idr)));
     return OMX_ErrorNone;
   }
   case OMX_ALG_IndexConfigVideoGroupOfPictures:
   {
     OMX_ALG_VIDEO_CONFIG_GROUP_OF_PICTURES* gop = new OMX_ALG_VIDEO_CONFIG_GROUP_OF_PICTURES;
     memcpy(gop, static_cast<OMX_ALG_VIDEO_CONFIG_GROUP_OF_PICTURES*>(config), sizeof(OMX_ALG_VIDEO_CONFIG_GROUP_OF_PICTURES));
-    processorMain->queue(CreateTask(SetDynamic, OMX_ALG_IndexConfigVideoGroupOfPictures, shared_ptr<void>(gop)));
+    QueueMain(CreateTask(SetDynamic, OMX_ALG_IndexConfigVideoGroupOfPictures, shared_ptr<void>(gop)));
     return OMX_ErrorNone;
   }
   case OMX_ALG_IndexConfigVideoRegionOfInterest:
   {
     OMX_ALG_VIDEO_CONFIG_REGION_OF_INTEREST* roi = new OMX_ALG_VIDEO_CONFIG_REGION_OF_INTEREST;
     memcpy(roi, static_cast<OMX_ALG_VIDEO_CONFIG_REGION_OF_INTEREST*>(config), sizeof(OMX_ALG_VIDEO_CONFIG_REGION_OF_INTEREST));
-    processorMain->queue(CreateTask(SetDynamic, OMX_ALG_IndexConfigVideoRegionOfInterest, shared_ptr<void>(roi)));
+    QueueMain(CreateTask(SetDynamic, OMX_ALG_IndexConfigVideoRegionOfInterest, shared_ptr<void>(roi)));
     return OMX_ErrorNone;
   }
   case OMX_ALG_IndexConfigVideoNotifySceneChange:
   {
     OMX_ALG_VIDEO_CONFIG_NOTIFY_SCENE_CHANGE* notifySceneChange = new OMX_ALG_VIDEO_CONFIG_NOTIFY_SCENE_CHANGE;
     memcpy(notifySceneChange, static_cast<OMX_ALG_VIDEO_CONFIG_NOTIFY_SCENE_CHANGE*>(config), sizeof(OMX_ALG_VIDEO_CONFIG_NOTIFY_SCENE_CHANGE));
-    processorMain->queue(CreateTask(SetDynamic, OMX_ALG_IndexConfigVideoNotifySceneChange, shared_ptr<void>(notifySceneChange)));
+    QueueMain(CreateTask(SetDynamic, OMX_ALG_IndexConfigVideoNotifySceneChange, shared_ptr<void>(notifySceneChange)));
     return OMX_ErrorNone;
   }
   case OMX_ALG_IndexConfigVideoInsertLongTerm:
   {
     OMX_ALG_VIDEO_CONFIG_INSERT* lt = new OMX_ALG_VIDEO_CONFIG_INSERT;
     memcpy(lt, static_cast<OMX_ALG_VIDEO_CONFIG_INSERT*>(config), sizeof(OMX_ALG_VIDEO_CONFIG_INSERT));
-    processorMain->queue(CreateTask(SetDynamic, OMX_ALG_IndexConfigVideoInsertLongTerm, shared_ptr<void>(lt)));
+    QueueMain(CreateTask(SetDynamic, OMX_ALG_IndexConfigVideoInsertLongTerm, shared_ptr<void>(lt)));
     return OMX_ErrorNone;
   }
   case OMX_ALG_IndexConfigVideoUseLongTerm:
   {
     OMX_ALG_VIDEO_CONFIG_INSERT* lt = new OMX_ALG_VIDEO_CONFIG_INSERT;
     memcpy(lt, static_cast<OMX_ALG_VIDEO_CONFIG_INSERT*>(config), sizeof(OMX_ALG_VIDEO_CONFIG_INSERT));
-    processorMain->queue(CreateTask(SetDynamic, OMX_ALG_IndexConfigVideoUseLongTerm, shared_ptr<void>(lt)));
+    QueueMain(CreateTask(SetDynamic, OMX_ALG_IndexConfigVideoUseLongTerm, shared_ptr<void>(lt)));
     return OMX_ErrorNone;
   }
 
@@ -1258,6 +1321,8 @@ void Component::PopulatingPorts()
       throw OMX_ErrorInsufficientResources;
     }
   }
+
+  taskPool.Reserve(TASKS_PER_BUFFER * (input.expected + output.expected));
 }
 
 void Component::UnpopulatingPorts()
@@ -1370,7 +1435,10 @@ void Component::TreatSetStateCommand(Task* task)
     }
 
     if(isTransitionToStop(state, newState))
+    {
       module->Stop();
+      LOGI("Task allocations per buffer : %f", taskPool.AllocationsPerAcquisition());
+    }
 
     if(newState == OMX_StatePause)
       BlockFillEmptyBuffers();
@@ -1452,6 +1520,7 @@ void Component::TreatEnablePortCommand(Task* task)
     port->isTransientToEnable = false;
   }
 
+  taskPool.Reserve(TASKS_PER_BUFFER * (input.expected + output.expected));
   callbacks.EventHandler(component, app, OMX_EventCmdComplete, OMX_CommandPortEnable, index, nullptr);
 }
 
@@ -1471,10 +1540,10 @@ void Component::TreatEmptyBufferCommand(Task* task)
   assert(task);
   assert(task->cmd == EmptyBuffer);
   assert(static_cast<int>((uintptr_t)task->data) == input.index);
-  auto header = static_cast<OMX_BUFFERHEADERTYPE*>(task->opt.get());
+  auto header = task->header;
   assert(header);
   AttachMark(header);
-  auto handle = new OMXBufferHandle(header);
+  auto handle = GetBufferHandle(header);
   auto success = module->Empty(handle);
   assert(success);
 }
@@ -1484,7 +1553,7 @@ void Component::TreatFillBufferCommand(Task* task)
   assert(task);
   assert(task->cmd == FillBuffer);
   assert(static_cast<int>((uintptr_t)task->data) == output.index);
-  auto header = static_cast<OMX_BUFFERHEADERTYPE*>(task->opt.get());
+  auto header = task->header;
   assert(header);
 
   if(state == OMX_StateInvalid)
@@ -1493,7 +1562,7 @@ void Component::TreatFillBufferCommand(Task* task)
     return;
   }
 
-  auto handle = new OMXBufferHandle(header);
+  auto handle = GetBufferHandle(header);
   auto success = module->Fill(handle);
   assert(success);
 }
@@ -1604,6 +1673,10 @@ void Component::_ProcessMain(void* data)
 {
   auto task = static_cast<Task*>(data);
   assert(task);
+
+  if(task->cmd != EmptyBuffer && task->cmd != FillBuffer)
+    WaitDirectDispatchers();
+
   switch(task->cmd)
   {
   case SetState:
@@ -1669,13 +1742,17 @@ void Component::_ProcessMain(void* data)
     assert(0 == "bad command");
   }
 
-  delete task;
+  if(task)
+    DeleteTask(task);
+
+  mainPending.fetch_sub(1);
 }
 
 void Component::_Delete(void* data)
 {
   auto task = static_cast<Task*>(data);
-  delete task;
+  DeleteTask(task);
+  mainPending.fetch_sub(1);
 }
 
 void Component::_DeleteFillEmpty(void* data)
@@ -1686,18 +1763,18 @@ void Component::_DeleteFillEmpty(void* data)
   if(task->cmd == FillBuffer)
   {
     assert(static_cast<int>((uintptr_t)task->data) == output.index);
-    auto header = static_cast<OMX_BUFFERHEADERTYPE*>(task->opt.get());
+    auto header = task->header;
     assert(header);
     callbacks.FillBufferDone(component, app, header);
   }
   else if(task->cmd == EmptyBuffer)
   {
     assert(static_cast<int>((uintptr_t)task->data) == input.index);
-    auto header = static_cast<OMX_BUFFERHEADERTYPE*>(task->opt.get());
+    auto header = task->header;
     assert(header);
     callbacks.EmptyBufferDone(component, app, header);
   }
-  delete task;
+  DeleteTask(task);
 }
 
 void Component::_ProcessFillBuffer(void* data)
@@ -1712,7 +1789,7 @@ void Component::_ProcessFillBuffer(void* data)
     TreatSignalCommand(task);
   else
     assert(0 == "bad command");
-  delete task;
+  DeleteTask(task);
 }
 
 void Component::_ProcessEmptyBuffer(void* data)
@@ -1727,6 +1804,6 @@ void Component::_ProcessEmptyBuffer(void* data)
     TreatSignalCommand(task);
   else
     assert(0 == "bad command");
-  delete task;
+  DeleteTask(task);
 }
 
@@ -48,10 +48,12 @@
 #include "omx_expertise.h"
 
 #include <algorithm>
+#include <atomic>
 #include <condition_variable>
 #include <mutex>
 #include <memory>
 #include <future>
+#include <queue>
 
 #define ALLEGRODVT_OMX_VERSION 3
 
@@ -145,16 +147,25 @@ protected:
   OMX_PORT_PARAM_TYPE videoPortParams;
   std::queue<OMX_MARKTYPE*> marks;
 
+  TaskPool taskPool;
   std::unique_ptr<ProcessorFifo> processorMain;
   std::unique_ptr<ProcessorFifo> processorEmpty;
   std::unique_ptr<ProcessorFifo> processorFill;
   std::shared_ptr<std::promise<void>> pausePromise;
+  std::atomic<int> mainPending;
+  std::atomic<int> directDispatchers;
+  void QueueMain(Task* task);
+  void DispatchBuffer(Task* task, std::unique_ptr<ProcessorFifo>& processor);
+  void WaitDirectDispatchers();
   void _ProcessMain(void* data);
   void _ProcessFillBuffer(void* data);
   void _ProcessEmptyBuffer(void* data);
   void _Delete(void* data);
   void _DeleteFillEmpty(void* data);
 
+  Task* CreateBufferTask(Command cmd, int index, OMX_BUFFERHEADERTYPE* header);
+  void DeleteTask(Task* task);
+
   void CreateName(OMX_STRING name);
   void CreateRole(OMX_STRING role);
 
@@ -66,7 +66,6 @@ DecComponent::~DecComponent() = default;
 void DecComponent::EmptyThisBufferCallBack(BufferHandleInterface* handle)
 {
   auto header = (OMX_BUFFERHEADERTYPE*)((OMXBufferHandle*)handle)->header;
-  delete handle;
   ClearPropagatedData(header);
 
   if(callbacks.EmptyBufferDone)
@@ -102,7 +101,6 @@ void DecComponent::FillThisBufferCallBack(BufferHandleInterface* filled, int off
 {
   assert(filled);
   auto header = (OMX_BUFFERHEADERTYPE*)((OMXBufferHandle*)filled)->header;
-  delete filled;
 
   header->nOffset = offset;
   header->nFilledLen = size;
@@ -173,6 +171,7 @@ static OMX_BUFFERHEADERTYPE* AllocateHeader(OMX_PTR app, int size, OMX_U8* buffe
   header->pAppPrivate = app;
   header->pInputPortPrivate = new bool(isBufferAllocatedByModule);
   header->pOutputPortPrivate = new bool(isBufferAllocatedByModule);
+  header->pPlatformPrivate = new OMXBufferHandle(header);
   auto& p = IsInputPort(index) ? header->nInputPortIndex : header->nOutputPortIndex;
   p = index;
 
@@ -194,6 +193,7 @@ static void DeleteHeader(OMX_BUFFERHEADERTYPE* header)
 {
   delete static_cast<bool*>(header->pInputPortPrivate);
   delete static_cast<bool*>(header->pOutputPortPrivate);
+  delete static_cast<OMXBufferHandle*>(header->pPlatformPrivate);
   delete header;
 }
 
@@ -264,7 +264,7 @@ void DecComponent::TreatEmptyBufferCommand(Task* task)
   assert(task);
   assert(task->cmd == EmptyBuffer);
   assert(static_cast<int>((intptr_t)task->data) == input.index);
-  auto header = static_cast<OMX_BUFFERHEADERTYPE*>(task->opt.get());
+  auto header = task->header;
   assert(header);
 
   if(state == OMX_StateInvalid)
@@ -278,7 +278,7 @@ void DecComponent::TreatEmptyBufferCommand(Task* task)
   if(header->nFlags & OMX_BUFFERFLAG_ENDOFFRAME)
     transmit.push_back(PropagatedData(header->hMarkTargetComponent, header->pMarkData, header->nTimeStamp, header->nFlags));
 
-  auto handle = new OMXBufferHandle(header);
+  auto handle = GetBufferHandle(header);
   auto success = module->Empty(handle);
   assert(success);
 }
@@ -66,16 +66,9 @@ EncComponent::~EncComponent() = default;
 void EncComponent::EmptyThisBufferCallBack(BufferHandleInterface* handle)
 {
   auto header = ((OMXBufferHandle*)(handle))->header;
-  delete handle;
 
   ClearPropagatedData(header);
 
-  if(roiMap.Exist(header))
-  {
-    auto roiBuffer = roiMap.Pop(header);
-    roiFreeBuffers.push(roiBuffer);
-  }
-
   if(callbacks.EmptyBufferDone)
     callbacks.EmptyBufferDone(component, app, header);
 }
@@ -115,7 +108,6 @@ void EncComponent::FillThisBufferCallBack(BufferHandleInterface* filled, int off
 {
   assert(filled);
   auto header = (OMX_BUFFERHEADERTYPE*)(((OMXBufferHandle*)(filled))->header);
-  delete filled;
 
   header->nOffset = offset;
   header->nFilledLen = size;
@@ -146,6 +138,7 @@ static OMX_BUFFERHEADERTYPE* AllocateHeader(OMX_PTR app, int size, OMX_U8* buffe
   header->pAppPrivate = app;
   header->pInputPortPrivate = new bool(isBufferAllocatedByModule);
   header->pOutputPortPrivate = new bool(isBufferAllocatedByModule);
+  header->pPlatformPrivate = new OMXBufferHandle(header);
   auto& p = IsInputPort(index) ? header->nInputPortIndex : header->nOutputPortIndex;
   p = index;
 
@@ -167,16 +160,10 @@ static void DeleteHeader(OMX_BUFFERHEADERTYPE* header)
 {
   delete static_cast<bool*>(header->pInputPortPrivate);
   delete static_cast<bool*>(header->pOutputPortPrivate);
+  delete static_cast<OMXBufferHandle*>(header->pPlatformPrivate);
   delete header;
 }
 
-uint8_t* EncComponent::AllocateROIBuffer()
-{
-  int roiSize;
-  module->GetDynamic(DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_BUFFER_SIZE, &roiSize);
-  return static_cast<uint8_t*>(calloc(roiSize, sizeof(uint8_t)));
-}
-
 OMX_ERRORTYPE EncComponent::UseBuffer(OMX_OUT OMX_BUFFERHEADERTYPE** header, OMX_IN OMX_U32 index, OMX_IN OMX_PTR app, OMX_IN OMX_U32 size, OMX_IN OMX_U8* buffer)
 {
   OMX_TRY();
@@ -195,17 +182,12 @@ OMX_ERRORTYPE EncComponent::UseBuffer(OMX_OUT OMX_BUFFERHEADERTYPE** header, OMX
 
   if(IsInputPort(index))
   {
-    auto roiBuffer = AllocateROIBuffer();
-    roiFreeBuffers.push(roiBuffer);
-    roiDestroyMap.Add(*header, roiBuffer);
-
     auto bufferHandlePort = IsInputPort(index) ? ToEncModule(*module).GetBufferHandles().input : ToEncModule(*module).GetBufferHandles().output;
     bool dmaOnPort = (bufferHandlePort == BufferHandleType::BUFFER_HANDLE_FD);
 
     if(dmaOnPort)
     {
-      auto handle = OMXBufferHandle(*header);
-      syncIp->addBuffer(&handle);
+      syncIp->addBuffer(GetBufferHandle(*header));
     }
   }
 
@@ -243,17 +225,9 @@ OMX_ERRORTYPE EncComponent::AllocateBuffer(OMX_INOUT OMX_BUFFERHEADERTYPE** head
   assert(*header);
   port->Add(*header);
 
-  if(IsInputPort(index))
+  if(IsInputPort(index) && dmaOnPort)
   {
-    auto roiBuffer = AllocateROIBuffer();
-    roiFreeBuffers.push(roiBuffer);
-    roiDestroyMap.Add(*header, roiBuffer);
-
-    if(dmaOnPort)
-    {
-      auto handle = OMXBufferHandle(*header);
-      syncIp->addBuffer(&handle);
-    }
+    syncIp->addBuffer(GetBufferHandle(*header));
   }
 
   if(port->playable && IsInputPort(index))
@@ -267,11 +241,6 @@ OMX_ERRORTYPE EncComponent::AllocateBuffer(OMX_INOUT OMX_BUFFERHEADERTYPE** head
   });
 }
 
-void EncComponent::DestroyROIBuffer(uint8_t* roiBuffer)
-{
-  free(roiBuffer);
-}
-
 OMX_ERRORTYPE EncComponent::FreeBuffer(OMX_IN OMX_U32 index, OMX_IN OMX_BUFFERHEADERTYPE* header)
 {
   OMX_TRY();
@@ -283,6 +252,8 @@ OMX_ERRORTYPE EncComponent::FreeBuffer(OMX_IN OMX_U32 index, OMX_IN OMX_BUFFERHE
   if((transientState != TransientIdleToLoaded) && (!port->isTransientToDisable))
     callbacks.EventHandler(component, app, OMX_EventError, OMX_ErrorPortUnpopulated, 0, nullptr);
 
+  ToEncModule(*module).InvalidateBuffer(static_cast<OMXBufferHandle*>(header->pPlatformPrivate));
+
   if(isBufferAllocatedByModule(header))
   {
     auto bufferHandlePort = IsInputPort(index) ? ToEncModule(*module).GetBufferHandles().input : ToEncModule(*module).GetBufferHandles().output;
@@ -290,15 +261,6 @@ OMX_ERRORTYPE EncComponent::FreeBuffer(OMX_IN OMX_U32 index, OMX_IN OMX_BUFFERHE
     dmaOnPort ? ToEncModule(*module).FreeDMA(static_cast<int>((intptr_t)header->pBuffer)) : module->Free(header->pBuffer);
   }
 
-  if(IsInputPort(index))
-  {
-    if(roiDestroyMap.Exist(header))
-    {
-      auto roiBuffer = roiDestroyMap.Pop(header);
-      DestroyROIBuffer(roiBuffer);
-    }
-  }
-
   port->Remove(header);
   DeleteHeader(header);
 
@@ -306,24 +268,72 @@ OMX_ERRORTYPE EncComponent::FreeBuffer(OMX_IN OMX_U32 index, OMX_IN OMX_BUFFERHE
   OMX_CATCH();
 }
 
+OMX_ERRORTYPE EncComponent::GetConfig(OMX_IN OMX_INDEXTYPE index, OMX_INOUT OMX_PTR config)
+{
+  if(static_cast<OMX_U32>(index) != OMX_ALG_IndexConfigVideoQuantizationParameterTable)
+    return Component::GetConfig(index, config);
+
+  OMX_TRY();
+  OMXChecker::CheckNotNull(config);
+  OMXChecker::CheckHeaderVersion(GetVersion(config));
+  OMXChecker::CheckStateOperation(AL_GetConfig, state);
+
+  QuantizationParameterTableLayout layout;
+  module->GetDynamic(DYNAMIC_INDEX_QUANTIZATION_PARAMETER_TABLE, &layout);
+  auto& qpTable = *(static_cast<OMX_ALG_VIDEO_CONFIG_QUANTIZATION_PARAMETER_TABLE*>(config));
+  qpTable.nFilledLen = layout.size;
+  qpTable.nAllocLen = layout.dmaSize;
+  qpTable.nOffset = layout.offset;
+  return OMX_ErrorNone;
+  OMX_CATCH_CONFIG();
+}
+
+OMX_ERRORTYPE EncComponent::SetConfig(OMX_IN OMX_INDEXTYPE index, OMX_IN OMX_PTR config)
+{
+  if(static_cast<OMX_U32>(index) != OMX_ALG_IndexConfigVideoQuantizationParameterTable)
+    return Component::SetConfig(index, config);
+
+  OMX_TRY();
+  OMXChecker::CheckNotNull(config);
+  OMXChecker::CheckHeaderVersion(GetVersion(config));
+  OMXChecker::CheckStateOperation(AL_SetConfig, state);
+
+  // not queued: the table has to be pending before its buffer is emptied
+  auto& qpTable = *(static_cast<OMX_ALG_VIDEO_CONFIG_QUANTIZATION_PARAMETER_TABLE*>(config));
+  QuantizationParameterTable table;
+  table.handle = qpTable.pBufferHeader ? GetBufferHandle(qpTable.pBufferHeader) : nullptr;
+  table.table = qpTable.pTable;
+  table.size = qpTable.nFilledLen;
+  table.fd = qpTable.bUseFd ? qpTable.nFd : -1; // a zeroed config must not import fd 0
+
+  if(qpTable.bUseFd && qpTable.nFd < 0)
+    throw OMX_ErrorBadParameter;
+
+  auto error = module->SetDynamic(DYNAMIC_INDEX_QUANTIZATION_PARAMETER_TABLE, &table);
+
+  if(error == ERROR_UNDEFINED)
+    throw OMX_ErrorIncorrectStateOperation;
+
+  if(error != SUCCESS)
+    throw OMX_ErrorBadParameter;
+
+  return OMX_ErrorNone;
+  OMX_CATCH_CONFIG();
+}
+
 void EncComponent::TreatEmptyBufferCommand(Task* task)
 {
   assert(task);
   assert(task->cmd == EmptyBuffer);
   assert(static_cast<int>((intptr_t)task->data) == input.index);
-  auto header = static_cast<OMX_BUFFERHEADERTYPE*>(task->opt.get());
+  auto header = task->header;
   assert(header);
   AttachMark(header);
 
   if(shouldPushROI && header->nFilledLen)
-  {
-    auto roiBuffer = roiFreeBuffers.pop();
-    module->GetDynamic(DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_BUFFER_FILL, roiBuffer);
-    module->SetDynamic(DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_BUFFER_EMPTY, roiBuffer);
-    roiMap.Add(header, roiBuffer);
-  }
+    module->SetDynamic(DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_BUFFER_PUSH, nullptr);
 
-  auto handle = new OMXBufferHandle(header);
+  auto handle = GetBufferHandle(header);
   auto success = module->Empty(handle);
 
   shouldClearROI = true;
@@ -51,17 +51,14 @@ struct EncComponent : public Component
   OMX_ERRORTYPE AllocateBuffer(OMX_INOUT OMX_BUFFERHEADERTYPE** header, OMX_IN OMX_U32 index, OMX_IN OMX_PTR app, OMX_IN OMX_U32 size) override;
   OMX_ERRORTYPE UseBuffer(OMX_OUT OMX_BUFFERHEADERTYPE** header, OMX_IN OMX_U32 index, OMX_IN OMX_PTR app, OMX_IN OMX_U32 size, OMX_IN OMX_U8* buffer) override;
   OMX_ERRORTYPE FreeBuffer(OMX_IN OMX_U32 index, OMX_IN OMX_BUFFERHEADERTYPE* header) override;
+  OMX_ERRORTYPE GetConfig(OMX_IN OMX_INDEXTYPE index, OMX_INOUT OMX_PTR config) override;
+  OMX_ERRORTYPE SetConfig(OMX_IN OMX_INDEXTYPE index, OMX_IN OMX_PTR config) override;
 
 private:
-  uint8_t* AllocateROIBuffer();
-  void DestroyROIBuffer(uint8_t* roiBuffer);
   void EmptyThisBufferCallBack(BufferHandleInterface* handle) override;
   void AssociateCallBack(BufferHandleInterface* empty, BufferHandleInterface* fill) override;
   void FillThisBufferCallBack(BufferHandleInterface* filled, int offset, int size) override;
   void TreatEmptyBufferCommand(Task* task) override;
   std::shared_ptr<SyncIpInterface> syncIp;
-  locked_queue<uint8_t*> roiFreeBuffers;
-  ThreadSafeMap<OMX_BUFFERHEADERTYPE*, uint8_t*> roiMap;
-  ThreadSafeMap<OMX_BUFFERHEADERTYPE*, uint8_t*> roiDestroyMap;
 };
 
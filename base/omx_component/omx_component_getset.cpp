@@ -407,6 +407,40 @@ OMX_ERRORTYPE SetVideoLookAhead(OMX_ALG_VIDEO_PARAM_LOOKAHEAD const& la, Port co
   return OMX_ErrorNone;
 }
 
+OMX_ERRORTYPE ConstructVideoSceneChangeDetection(OMX_ALG_VIDEO_PARAM_SCENE_CHANGE_DETECTION& scd, Port const& port, shared_ptr<MediatypeInterface> media)
+{
+  OMXChecker::SetHeaderVersion(scd);
+  scd.nPortIndex = port.index;
+  bool isSceneChangeDetectionEnabled;
+  auto ret = media->Get(SETTINGS_INDEX_SCENE_CHANGE_DETECTION, &isSceneChangeDetectionEnabled);
+  OMX_CHECK_MEDIA_GET(ret);
+  scd.bEnableSceneChangeDetection = ConvertMediaToOMXBool(isSceneChangeDetectionEnabled);
+  return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE SetSceneChangeDetection(OMX_BOOL enableSceneChangeDetection, shared_ptr<MediatypeInterface> media)
+{
+  auto enabled = ConvertOMXToMediaBool(enableSceneChangeDetection);
+  auto ret = media->Set(SETTINGS_INDEX_SCENE_CHANGE_DETECTION, &enabled);
+  OMX_CHECK_MEDIA_SET(ret);
+  return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE SetVideoSceneChangeDetection(OMX_ALG_VIDEO_PARAM_SCENE_CHANGE_DETECTION const& sceneChangeDetection, Port const& port, shared_ptr<MediatypeInterface> media)
+{
+  OMX_ALG_VIDEO_PARAM_SCENE_CHANGE_DETECTION rollback;
+  ConstructVideoSceneChangeDetection(rollback, port, media);
+
+  auto ret = SetSceneChangeDetection(sceneChangeDetection.bEnableSceneChangeDetection, media);
+
+  if(ret != OMX_ErrorNone)
+  {
+    SetVideoSceneChangeDetection(rollback, port, media);
+    throw ret;
+  }
+  return OMX_ErrorNone;
+}
+
 // Encoder
 
 OMX_ERRORTYPE ConstructVideoBitrate(OMX_VIDEO_PARAM_BITRATETYPE& b, Port const& port, shared_ptr<MediatypeInterface> media)
@@ -149,6 +149,9 @@ OMX_ERRORTYPE SetTargetBitrate(OMX_U32 bitrate, std::shared_ptr<MediatypeInterfa
 OMX_ERRORTYPE ConstructVideoLookAhead(OMX_ALG_VIDEO_PARAM_LOOKAHEAD& la, Port const& port, std::shared_ptr<MediatypeInterface> media);
 OMX_ERRORTYPE SetLookAhead(OMX_U32 nLookAhead, std::shared_ptr<MediatypeInterface> media);
 OMX_ERRORTYPE SetVideoLookAhead(OMX_ALG_VIDEO_PARAM_LOOKAHEAD const& la, Port const& port, std::shared_ptr<MediatypeInterface> media);
+OMX_ERRORTYPE ConstructVideoSceneChangeDetection(OMX_ALG_VIDEO_PARAM_SCENE_CHANGE_DETECTION& scd, Port const& port, std::shared_ptr<MediatypeInterface> media);
+OMX_ERRORTYPE SetSceneChangeDetection(OMX_BOOL enableSceneChangeDetection, std::shared_ptr<MediatypeInterface> media);
+OMX_ERRORTYPE SetVideoSceneChangeDetection(OMX_ALG_VIDEO_PARAM_SCENE_CHANGE_DETECTION const& sceneChangeDetection, Port const& port, std::shared_ptr<MediatypeInterface> media);
 
 // Decoder
 
@@ -38,11 +38,14 @@
 #pragma once
 
 #include "base/omx_utils/processor_fifo.h"
+#include "base/omx_utils/lockfree_queue.h"
 #include "omx_buffer_handle.h"
 
 #include <algorithm>
+#include <atomic>
 #include <mutex>
 #include <memory>
+#include <vector>
 
 enum Command
 {
@@ -76,13 +79,93 @@ enum TransientState
 struct Task
 {
   Task() :
-    cmd(), data(nullptr), opt(nullptr)
+    cmd(), data(nullptr), header(nullptr), opt(nullptr), pooled(false)
   {
   }
 
   Command cmd;
   void* data;
+  OMX_BUFFERHEADERTYPE* header;
   std::shared_ptr<void> opt;
+  bool pooled;
+};
+
+/**
+ * @brief Fixed-capacity set of Tasks used by the buffer path. Acquire and
+ * Release can be called from any thread. Reserve must only be called by the
+ * main processor. When the pool is exhausted, tasks are allocated on the heap
+ * and counted in allocations.
+ */
+struct TaskPool
+{
+  TaskPool(size_t capacity) :
+    capacity(capacity), freeTasks(capacity), reserved(0), acquisitions(0), allocations(0)
+  {
+  }
+
+  void Reserve(size_t count)
+  {
+    count = std::min(count, capacity);
+
+    if(count <= reserved)
+      return;
+
+    auto size = count - reserved;
+    auto chunk = new Task[size];
+    chunks.push_back(std::unique_ptr<Task[]>(chunk));
+
+    for(size_t i = 0; i < size; ++i)
+    {
+      auto task = &chunk[i];
+      task->pooled = true;
+      freeTasks.push(task);
+    }
+
+    reserved = count;
+  }
+
+  Task* Acquire()
+  {
+    acquisitions.fetch_add(1, std::memory_order_relaxed);
+    Task* task;
+
+    if(freeTasks.try_pop(task))
+      return task;
+
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return new Task();
+  }
+
+  void Release(Task* task)
+  {
+    if(!task->pooled)
+    {
+      delete task;
+      return;
+    }
+
+    task->header = nullptr;
+    task->opt = nullptr;
+    freeTasks.push(task);
+  }
+
+  float AllocationsPerAcquisition() const
+  {
+    auto count = acquisitions.load(std::memory_order_relaxed);
+
+    if(!count)
+      return 0.0f;
+
+    return static_cast<float>(allocations.load(std::memory_order_relaxed)) / count;
+  }
+
+private:
+  size_t const capacity;
+  lockfree_queue<Task*> freeTasks;
+  std::vector<std::unique_ptr<Task[]>> chunks;
+  size_t reserved;
+  std::atomic<uint64_t> acquisitions;
+  std::atomic<uint64_t> allocations;
 };
 
 struct Port
@@ -133,84 +133,86 @@ static ProfileLevelType CreateProfileLevel(AL_TDecSettings settings)
   return CreateAVCProfileLevel(static_cast<AL_EProfile>(stream.iProfileIdc), stream.iLevel);
 }
 
-MediatypeInterface::ErrorSettingsType DecMediatypeAVC::Get(std::string index, void* settings) const
+MediatypeInterface::ErrorSettingsType DecMediatypeAVC::Get(SettingsIndex index, void* settings) const
 {
   if(!settings)
     return ERROR_SETTINGS_BAD_PARAMETER;
 
-  if(index == "SETTINGS_INDEX_MIMES")
+  switch(index)
+  {
+  case SETTINGS_INDEX_MIMES:
   {
     *(static_cast<Mimes*>(settings)) = CreateMimes();
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_CLOCK")
+  case SETTINGS_INDEX_CLOCK:
   {
     *(static_cast<Clock*>(settings)) = CreateClock(this->settings);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_STRIDE_ALIGNMENT")
+  case SETTINGS_INDEX_STRIDE_ALIGNMENT:
   {
     *(static_cast<Stride*>(settings)) = this->strideAlignment;
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_INTERNAL_ENTROPY_BUFFER")
+  case SETTINGS_INDEX_INTERNAL_ENTROPY_BUFFER:
   {
     *(static_cast<int*>(settings)) = CreateInternalEntropyBuffer(this->settings);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_LATENCY")
+  case SETTINGS_INDEX_LATENCY:
   {
     *(static_cast<int*>(settings)) = CreateLatency(this->settings);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_SEQUENCE_PICTURE_MODE")
+  case SETTINGS_INDEX_SEQUENCE_PICTURE_MODE:
   {
     *(static_cast<SequencePictureModeType*>(settings)) = CreateSequenceMode(this->settings);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_SEQUENCE_PICTURE_MODES_SUPPORTED")
+  case SETTINGS_INDEX_SEQUENCE_PICTURE_MODES_SUPPORTED:
   {
     *(static_cast<vector<SequencePictureModeType>*>(settings)) = this->sequenceModes;
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_BUFFER_HANDLES")
+  case SETTINGS_INDEX_BUFFER_HANDLES:
   {
     *(static_cast<BufferHandles*>(settings)) = this->bufferHandles;
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_BUFFER_COUNTS")
+  case SETTINGS_INDEX_BUFFER_COUNTS:
   {
     *(static_cast<BufferCounts*>(settings)) = CreateBufferCounts(this->settings);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_PROFILE_LEVEL")
+  case SETTINGS_INDEX_PROFILE_LEVEL:
   {
     *(static_cast<ProfileLevelType*>(settings)) = CreateProfileLevel(this->settings);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_PROFILES_LEVELS_SUPPORTED")
+  case SETTINGS_INDEX_PROFILES_LEVELS_SUPPORTED:
   {
     *(static_cast<vector<ProfileLevelType>*>(settings)) = CreateAVCProfileLevelSupported(profiles, levels);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_FORMAT")
+  case SETTINGS_INDEX_FORMAT:
   {
     *(static_cast<Format*>(settings)) = CreateFormat(this->settings);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_FORMATS_SUPPORTED")
+  case SETTINGS_INDEX_FORMATS_SUPPORTED:
   {
     SupportedFormats supported;
     supported.input = CreateFormatsSupported(colors, bitdepths);
@@ -219,23 +221,26 @@ MediatypeInterface::ErrorSettingsType DecMediatypeAVC::Get(std::string index, vo
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_SUBFRAME")
+  case SETTINGS_INDEX_SUBFRAME:
   {
     *(static_cast<bool*>(settings)) = (this->settings.eDecUnit == AL_VCL_NAL_UNIT);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_RESOLUTION")
+  case SETTINGS_INDEX_RESOLUTION:
   {
     *(static_cast<Resolution*>(settings)) = CreateResolution(this->settings, stride, sliceHeight);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_DECODED_PICTURE_BUFFER")
+  case SETTINGS_INDEX_DECODED_PICTURE_BUFFER:
   {
     *(static_cast<DecodedPictureBufferType*>(settings)) = CreateDecodedPictureBuffer(this->settings);
     return ERROR_SETTINGS_NONE;
   }
+  default:
+    break;
+  }
 
   return ERROR_SETTINGS_BAD_INDEX;
 }
@@ -267,12 +272,14 @@ static bool UpdateProfileLevel(AL_TDecSettings& settings, ProfileLevelType profi
   return true;
 }
 
-MediatypeInterface::ErrorSettingsType DecMediatypeAVC::Set(std::string index, void const* settings)
+MediatypeInterface::ErrorSettingsType DecMediatypeAVC::Set(SettingsIndex index, void const* settings)
 {
   if(!settings)
     return ERROR_SETTINGS_BAD_PARAMETER;
 
-  if(index == "SETTINGS_INDEX_CLOCK")
+  switch(index)
+  {
+  case SETTINGS_INDEX_CLOCK:
   {
     auto clock = *(static_cast<Clock const*>(settings));
 
@@ -281,7 +288,7 @@ MediatypeInterface::ErrorSettingsType DecMediatypeAVC::Set(std::string index, vo
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_INTERNAL_ENTROPY_BUFFER")
+  case SETTINGS_INDEX_INTERNAL_ENTROPY_BUFFER:
   {
     auto internalEntropyBuffer = *(static_cast<int const*>(settings));
 
@@ -290,7 +297,7 @@ MediatypeInterface::ErrorSettingsType DecMediatypeAVC::Set(std::string index, vo
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_SEQUENCE_PICTURE_MODE")
+  case SETTINGS_INDEX_SEQUENCE_PICTURE_MODE:
   {
     auto sequenceMode = *(static_cast<SequencePictureModeType const*>(settings));
 
@@ -299,7 +306,7 @@ MediatypeInterface::ErrorSettingsType DecMediatypeAVC::Set(std::string index, vo
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_FORMAT")
+  case SETTINGS_INDEX_FORMAT:
   {
     auto format = *(static_cast<Format const*>(settings));
 
@@ -308,7 +315,7 @@ MediatypeInterface::ErrorSettingsType DecMediatypeAVC::Set(std::string index, vo
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_PROFILE_LEVEL")
+  case SETTINGS_INDEX_PROFILE_LEVEL:
   {
     auto profilelevel = *(static_cast<ProfileLevelType const*>(settings));
 
@@ -317,7 +324,7 @@ MediatypeInterface::ErrorSettingsType DecMediatypeAVC::Set(std::string index, vo
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_BUFFER_HANDLES")
+  case SETTINGS_INDEX_BUFFER_HANDLES:
   {
     auto bufferHandles = *(static_cast<BufferHandles const*>(settings));
 
@@ -326,7 +333,7 @@ MediatypeInterface::ErrorSettingsType DecMediatypeAVC::Set(std::string index, vo
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_SUBFRAME")
+  case SETTINGS_INDEX_SUBFRAME:
   {
     auto isEnabledSubFrame = *(static_cast<bool const*>(settings));
 
@@ -335,7 +342,7 @@ MediatypeInterface::ErrorSettingsType DecMediatypeAVC::Set(std::string index, vo
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_DECODED_PICTURE_BUFFER")
+  case SETTINGS_INDEX_DECODED_PICTURE_BUFFER:
   {
     auto decodedPictureBuffer = *(static_cast<DecodedPictureBufferType const*>(settings));
 
@@ -344,7 +351,7 @@ MediatypeInterface::ErrorSettingsType DecMediatypeAVC::Set(std::string index, vo
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_RESOLUTION")
+  case SETTINGS_INDEX_RESOLUTION:
   {
     auto resolution = *(static_cast<Resolution const*>(settings));
 
@@ -352,6 +359,9 @@ MediatypeInterface::ErrorSettingsType DecMediatypeAVC::Set(std::string index, vo
       return ERROR_SETTINGS_BAD_PARAMETER;
     return ERROR_SETTINGS_NONE;
   }
+  default:
+    break;
+  }
 
   return ERROR_SETTINGS_BAD_INDEX;
 }
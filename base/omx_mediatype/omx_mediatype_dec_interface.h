@@ -52,8 +52,8 @@ struct DecMediatypeInterface : public MediatypeInterface
   }
 
   virtual void Reset() = 0;
-  virtual ErrorSettingsType Get(std::string index, void* settings) const = 0;
-  virtual ErrorSettingsType Set(std::string index, void const* settings) = 0;
+  virtual ErrorSettingsType Get(SettingsIndex index, void* settings) const = 0;
+  virtual ErrorSettingsType Set(SettingsIndex index, void const* settings) = 0;
 
   AL_TDecSettings settings;
   int stride;
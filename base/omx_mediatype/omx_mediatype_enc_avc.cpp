@@ -96,6 +96,7 @@ void EncMediatypeAVC::Reset()
 
   stride = RoundUp(AL_EncGetMinPitch(channel.uWidth, AL_GET_BITDEPTH(channel.ePicFormat), AL_FB_RASTER), strideAlignment.widthStride);
   sliceHeight = RoundUp(channel.uHeight, strideAlignment.heightStride);
+  sceneChangeDetection = false;
 }
 
 static Mimes CreateMimes()
@@ -190,144 +191,146 @@ static ProfileLevelType CreateProfileLevel(AL_TEncSettings settings)
   return CreateAVCProfileLevel(channel.eProfile, channel.uLevel);
 }
 
-MediatypeInterface::ErrorSettingsType EncMediatypeAVC::Get(std::string index, void* settings) const
+MediatypeInterface::ErrorSettingsType EncMediatypeAVC::Get(SettingsIndex index, void* settings) const
 {
   if(!settings)
     return ERROR_SETTINGS_BAD_PARAMETER;
 
-  if(index == "SETTINGS_INDEX_MIMES")
+  switch(index)
+  {
+  case SETTINGS_INDEX_MIMES:
   {
     *(static_cast<Mimes*>(settings)) = CreateMimes();
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_CLOCK")
+  case SETTINGS_INDEX_CLOCK:
   {
     *(static_cast<Clock*>(settings)) = CreateClock(this->settings);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_STRIDE_ALIGNMENT")
+  case SETTINGS_INDEX_STRIDE_ALIGNMENT:
   {
     *(static_cast<Stride*>(settings)) = this->strideAlignment;
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_GROUP_OF_PICTURES")
+  case SETTINGS_INDEX_GROUP_OF_PICTURES:
   {
     *(static_cast<Gop*>(settings)) = CreateGroupOfPictures(this->settings);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_LATENCY")
+  case SETTINGS_INDEX_LATENCY:
   {
     *(static_cast<int*>(settings)) = CreateLatency(this->settings);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_LOW_BANDWIDTH")
+  case SETTINGS_INDEX_LOW_BANDWIDTH:
   {
     *(static_cast<bool*>(settings)) = CreateLowBandwidth(this->settings);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_CONSTRAINED_INTRA_PREDICTION")
+  case SETTINGS_INDEX_CONSTRAINED_INTRA_PREDICTION:
   {
     *(static_cast<bool*>(settings)) = CreateConstrainedIntraPrediction(this->settings);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_ENTROPY_CODING")
+  case SETTINGS_INDEX_ENTROPY_CODING:
   {
     *(static_cast<EntropyCodingType*>(settings)) = CreateEntropyCoding(this->settings);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_VIDEO_MODE")
+  case SETTINGS_INDEX_VIDEO_MODE:
   {
     *(static_cast<VideoModeType*>(settings)) = CreateVideoMode(this->settings);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_VIDEO_MODES_SUPPORTED")
+  case SETTINGS_INDEX_VIDEO_MODES_SUPPORTED:
   {
     *(static_cast<vector<VideoModeType>*>(settings)) = this->videoModes;
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_BITRATE")
+  case SETTINGS_INDEX_BITRATE:
   {
     *(static_cast<Bitrate*>(settings)) = CreateBitrate(this->settings);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_CACHE_LEVEL2")
+  case SETTINGS_INDEX_CACHE_LEVEL2:
   {
     *(static_cast<bool*>(settings)) = CreateCacheLevel2(this->settings);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_BUFFER_HANDLES")
+  case SETTINGS_INDEX_BUFFER_HANDLES:
   {
     *(static_cast<BufferHandles*>(settings)) = this->bufferHandles;
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_BUFFER_COUNTS")
+  case SETTINGS_INDEX_BUFFER_COUNTS:
   {
     *(static_cast<BufferCounts*>(settings)) = CreateBufferCounts(this->settings);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_FILLER_DATA")
+  case SETTINGS_INDEX_FILLER_DATA:
   {
     *(static_cast<bool*>(settings)) = CreateFillerData(this->settings);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_ASPECT_RATIO")
+  case SETTINGS_INDEX_ASPECT_RATIO:
   {
     *(static_cast<AspectRatioType*>(settings)) = CreateAspectRatio(this->settings);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_SCALING_LIST")
+  case SETTINGS_INDEX_SCALING_LIST:
   {
     *(static_cast<ScalingListType*>(settings)) = CreateScalingList(this->settings);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_QUANTIZATION_PARAMETER")
+  case SETTINGS_INDEX_QUANTIZATION_PARAMETER:
   {
     *(static_cast<QPs*>(settings)) = CreateQuantizationParameter(this->settings);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_LOOP_FILTER")
+  case SETTINGS_INDEX_LOOP_FILTER:
   {
     *(static_cast<LoopFilterType*>(settings)) = CreateLoopFilter(this->settings);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_PROFILE_LEVEL")
+  case SETTINGS_INDEX_PROFILE_LEVEL:
   {
     *(static_cast<ProfileLevelType*>(settings)) = CreateProfileLevel(this->settings);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_PROFILES_LEVELS_SUPPORTED")
+  case SETTINGS_INDEX_PROFILES_LEVELS_SUPPORTED:
   {
     *(static_cast<vector<ProfileLevelType>*>(settings)) = CreateAVCProfileLevelSupported(profiles, levels);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_FORMAT")
+  case SETTINGS_INDEX_FORMAT:
   {
     *(static_cast<Format*>(settings)) = CreateFormat(this->settings);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_FORMATS_SUPPORTED")
+  case SETTINGS_INDEX_FORMATS_SUPPORTED:
   {
     SupportedFormats supported;
     supported.input = CreateFormatsSupported(colors, bitdepths);
@@ -336,19 +339,19 @@ MediatypeInterface::ErrorSettingsType EncMediatypeAVC::Get(std::string index, vo
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_SLICE_PARAMETER")
+  case SETTINGS_INDEX_SLICE_PARAMETER:
   {
     *(static_cast<Slices*>(settings)) = CreateSlicesParameter(this->settings);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_SUBFRAME")
+  case SETTINGS_INDEX_SUBFRAME:
   {
     *(static_cast<bool*>(settings)) = (this->settings.tChParam[0].bSubframeLatency);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_RESOLUTION")
+  case SETTINGS_INDEX_RESOLUTION:
   {
     *(static_cast<Resolution*>(settings)) = CreateResolution(this->settings, stride, sliceHeight);
     return ERROR_SETTINGS_NONE;
@@ -356,13 +359,23 @@ MediatypeInterface::ErrorSettingsType EncMediatypeAVC::Get(std::string index, vo
 
 #if AL_ENABLE_TWOPASS
 
-  if(index == "SETTINGS_INDEX_LOOKAHEAD")
+  case SETTINGS_INDEX_LOOKAHEAD:
   {
     *(static_cast<LookAhead*>(settings)) = CreateLookAhead(this->settings);
     return ERROR_SETTINGS_NONE;
   }
 #endif
 
+  case SETTINGS_INDEX_SCENE_CHANGE_DETECTION:
+  {
+    *(static_cast<bool*>(settings)) = sceneChangeDetection;
+    return ERROR_SETTINGS_NONE;
+  }
+
+  default:
+    break;
+  }
+
   return ERROR_SETTINGS_BAD_INDEX;
 }
 
@@ -441,12 +454,14 @@ static bool UpdateProfileLevel(AL_TEncSettings& settings, ProfileLevelType profi
   return true;
 }
 
-MediatypeInterface::ErrorSettingsType EncMediatypeAVC::Set(std::string index, void const* settings)
+MediatypeInterface::ErrorSettingsType EncMediatypeAVC::Set(SettingsIndex index, void const* settings)
 {
   if(!settings)
     return ERROR_SETTINGS_BAD_PARAMETER;
 
-  if(index == "SETTINGS_INDEX_CLOCK")
+  switch(index)
+  {
+  case SETTINGS_INDEX_CLOCK:
   {
     auto clock = *(static_cast<Clock const*>(settings));
 
@@ -455,7 +470,7 @@ MediatypeInterface::ErrorSettingsType EncMediatypeAVC::Set(std::string index, vo
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_GROUP_OF_PICTURES")
+  case SETTINGS_INDEX_GROUP_OF_PICTURES:
   {
     auto gop = *(static_cast<Gop const*>(settings));
 
@@ -464,7 +479,7 @@ MediatypeInterface::ErrorSettingsType EncMediatypeAVC::Set(std::string index, vo
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_LOW_BANDWIDTH")
+  case SETTINGS_INDEX_LOW_BANDWIDTH:
   {
     auto isLowBandwidthEnabled = *(static_cast<bool const*>(settings));
 
@@ -473,7 +488,7 @@ MediatypeInterface::ErrorSettingsType EncMediatypeAVC::Set(std::string index, vo
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_CONSTRAINED_INTRA_PREDICTION")
+  case SETTINGS_INDEX_CONSTRAINED_INTRA_PREDICTION:
   {
     auto isConstrainedIntraPredictionEnabled = *(static_cast<bool const*>(settings));
 
@@ -482,7 +497,7 @@ MediatypeInterface::ErrorSettingsType EncMediatypeAVC::Set(std::string index, vo
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_ENTROPY_CODING")
+  case SETTINGS_INDEX_ENTROPY_CODING:
   {
     auto entropyCoding = *(static_cast<EntropyCodingType const*>(settings));
 
@@ -491,7 +506,7 @@ MediatypeInterface::ErrorSettingsType EncMediatypeAVC::Set(std::string index, vo
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_VIDEO_MODE")
+  case SETTINGS_INDEX_VIDEO_MODE:
   {
     auto videoMode = *(static_cast<VideoModeType const*>(settings));
 
@@ -500,7 +515,7 @@ MediatypeInterface::ErrorSettingsType EncMediatypeAVC::Set(std::string index, vo
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_BITRATE")
+  case SETTINGS_INDEX_BITRATE:
   {
     auto bitrate = *(static_cast<Bitrate const*>(settings));
 
@@ -509,7 +524,7 @@ MediatypeInterface::ErrorSettingsType EncMediatypeAVC::Set(std::string index, vo
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_CACHE_LEVEL2")
+  case SETTINGS_INDEX_CACHE_LEVEL2:
   {
     auto isCacheLevel2Enabled = *(static_cast<bool const*>(settings));
 
@@ -518,7 +533,7 @@ MediatypeInterface::ErrorSettingsType EncMediatypeAVC::Set(std::string index, vo
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_FILLER_DATA")
+  case SETTINGS_INDEX_FILLER_DATA:
   {
     auto isFillerDataEnabled = *(static_cast<bool const*>(settings));
 
@@ -527,7 +542,7 @@ MediatypeInterface::ErrorSettingsType EncMediatypeAVC::Set(std::string index, vo
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_ASPECT_RATIO")
+  case SETTINGS_INDEX_ASPECT_RATIO:
   {
     auto aspectRatio = *(static_cast<AspectRatioType const*>(settings));
 
@@ -536,7 +551,7 @@ MediatypeInterface::ErrorSettingsType EncMediatypeAVC::Set(std::string index, vo
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_SCALING_LIST")
+  case SETTINGS_INDEX_SCALING_LIST:
   {
     auto scalingList = *(static_cast<ScalingListType const*>(settings));
 
@@ -545,7 +560,7 @@ MediatypeInterface::ErrorSettingsType EncMediatypeAVC::Set(std::string index, vo
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_QUANTIZATION_PARAMETER")
+  case SETTINGS_INDEX_QUANTIZATION_PARAMETER:
   {
     auto qps = *(static_cast<QPs const*>(settings));
 
@@ -554,7 +569,7 @@ MediatypeInterface::ErrorSettingsType EncMediatypeAVC::Set(std::string index, vo
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_LOOP_FILTER")
+  case SETTINGS_INDEX_LOOP_FILTER:
   {
     auto loopFilter = *(static_cast<LoopFilterType const*>(settings));
 
@@ -564,7 +579,7 @@ MediatypeInterface::ErrorSettingsType EncMediatypeAVC::Set(std::string index, vo
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_PROFILE_LEVEL")
+  case SETTINGS_INDEX_PROFILE_LEVEL:
   {
     auto profilelevel = *(static_cast<ProfileLevelType const*>(settings));
 
@@ -573,7 +588,7 @@ MediatypeInterface::ErrorSettingsType EncMediatypeAVC::Set(std::string index, vo
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_FORMAT")
+  case SETTINGS_INDEX_FORMAT:
   {
     auto format = *(static_cast<Format const*>(settings));
 
@@ -582,7 +597,7 @@ MediatypeInterface::ErrorSettingsType EncMediatypeAVC::Set(std::string index, vo
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_SLICE_PARAMETER")
+  case SETTINGS_INDEX_SLICE_PARAMETER:
   {
     auto slices = *(static_cast<Slices const*>(settings));
 
@@ -592,7 +607,7 @@ MediatypeInterface::ErrorSettingsType EncMediatypeAVC::Set(std::string index, vo
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_BUFFER_HANDLES")
+  case SETTINGS_INDEX_BUFFER_HANDLES:
   {
     auto bufferHandles = *(static_cast<BufferHandles const*>(settings));
 
@@ -601,7 +616,7 @@ MediatypeInterface::ErrorSettingsType EncMediatypeAVC::Set(std::string index, vo
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_SUBFRAME")
+  case SETTINGS_INDEX_SUBFRAME:
   {
     auto isEnabledSubFrame = *(static_cast<bool const*>(settings));
 
@@ -610,7 +625,7 @@ MediatypeInterface::ErrorSettingsType EncMediatypeAVC::Set(std::string index, vo
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_RESOLUTION")
+  case SETTINGS_INDEX_RESOLUTION:
   {
     auto resolution = *(static_cast<Resolution const*>(settings));
 
@@ -621,7 +636,7 @@ MediatypeInterface::ErrorSettingsType EncMediatypeAVC::Set(std::string index, vo
 
 #if AL_ENABLE_TWOPASS
 
-  if(index == "SETTINGS_INDEX_LOOKAHEAD")
+  case SETTINGS_INDEX_LOOKAHEAD:
   {
     auto la = *(static_cast<LookAhead const*>(settings));
 
@@ -632,6 +647,16 @@ MediatypeInterface::ErrorSettingsType EncMediatypeAVC::Set(std::string index, vo
   }
 #endif
 
+  case SETTINGS_INDEX_SCENE_CHANGE_DETECTION:
+  {
+    sceneChangeDetection = *(static_cast<bool const*>(settings));
+    return ERROR_SETTINGS_NONE;
+  }
+
+  default:
+    break;
+  }
+
   return ERROR_SETTINGS_BAD_INDEX;
 }
 
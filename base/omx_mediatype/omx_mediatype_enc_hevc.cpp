@@ -94,6 +94,7 @@ void EncMediatypeHEVC::Reset()
 
   stride = RoundUp(AL_EncGetMinPitch(channel.uWidth, AL_GET_BITDEPTH(channel.ePicFormat), AL_FB_RASTER), strideAlignment.widthStride);
   sliceHeight = RoundUp(channel.uHeight, strideAlignment.heightStride);
+  sceneChangeDetection = false;
 }
 
 static bool IsHighTier(uint8_t tier)
@@ -184,138 +185,140 @@ static ProfileLevelType CreateProfileLevel(AL_TEncSettings settings)
   return IsHighTier(channel.uTier) ? CreateHEVCHighTierProfileLevel(channel.eProfile, channel.uLevel) : CreateHEVCMainTierProfileLevel(channel.eProfile, channel.uLevel);
 }
 
-MediatypeInterface::ErrorSettingsType EncMediatypeHEVC::Get(std::string index, void* settings) const
+MediatypeInterface::ErrorSettingsType EncMediatypeHEVC::Get(SettingsIndex index, void* settings) const
 {
   if(!settings)
     return ERROR_SETTINGS_BAD_PARAMETER;
 
-  if(index == "SETTINGS_INDEX_MIMES")
+  switch(index)
+  {
+  case SETTINGS_INDEX_MIMES:
   {
     *(static_cast<Mimes*>(settings)) = CreateMimes();
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_CLOCK")
+  case SETTINGS_INDEX_CLOCK:
   {
     *(static_cast<Clock*>(settings)) = CreateClock(this->settings);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_STRIDE_ALIGNMENT")
+  case SETTINGS_INDEX_STRIDE_ALIGNMENT:
   {
     *(static_cast<Stride*>(settings)) = this->strideAlignment;
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_GROUP_OF_PICTURES")
+  case SETTINGS_INDEX_GROUP_OF_PICTURES:
   {
     *(static_cast<Gop*>(settings)) = CreateGroupOfPictures(this->settings);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_LATENCY")
+  case SETTINGS_INDEX_LATENCY:
   {
     *(static_cast<int*>(settings)) = CreateLatency(this->settings);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_LOW_BANDWIDTH")
+  case SETTINGS_INDEX_LOW_BANDWIDTH:
   {
     *(static_cast<bool*>(settings)) = CreateLowBandwidth(this->settings);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_CONSTRAINED_INTRA_PREDICTION")
+  case SETTINGS_INDEX_CONSTRAINED_INTRA_PREDICTION:
   {
     *(static_cast<bool*>(settings)) = CreateConstrainedIntraPrediction(this->settings);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_VIDEO_MODE")
+  case SETTINGS_INDEX_VIDEO_MODE:
   {
     *(static_cast<VideoModeType*>(settings)) = CreateVideoMode(this->settings);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_VIDEO_MODES_SUPPORTED")
+  case SETTINGS_INDEX_VIDEO_MODES_SUPPORTED:
   {
     *(static_cast<vector<VideoModeType>*>(settings)) = this->videoModes;
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_BITRATE")
+  case SETTINGS_INDEX_BITRATE:
   {
     *(static_cast<Bitrate*>(settings)) = CreateBitrate(this->settings);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_CACHE_LEVEL2")
+  case SETTINGS_INDEX_CACHE_LEVEL2:
   {
     *(static_cast<bool*>(settings)) = CreateCacheLevel2(this->settings);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_BUFFER_HANDLES")
+  case SETTINGS_INDEX_BUFFER_HANDLES:
   {
     *(static_cast<BufferHandles*>(settings)) = this->bufferHandles;
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_BUFFER_COUNTS")
+  case SETTINGS_INDEX_BUFFER_COUNTS:
   {
     *(static_cast<BufferCounts*>(settings)) = CreateBufferCounts(this->settings);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_FILLER_DATA")
+  case SETTINGS_INDEX_FILLER_DATA:
   {
     *(static_cast<bool*>(settings)) = CreateFillerData(this->settings);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_ASPECT_RATIO")
+  case SETTINGS_INDEX_ASPECT_RATIO:
   {
     *(static_cast<AspectRatioType*>(settings)) = CreateAspectRatio(this->settings);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_SCALING_LIST")
+  case SETTINGS_INDEX_SCALING_LIST:
   {
     *(static_cast<ScalingListType*>(settings)) = CreateScalingList(this->settings);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_QUANTIZATION_PARAMETER")
+  case SETTINGS_INDEX_QUANTIZATION_PARAMETER:
   {
     *(static_cast<QPs*>(settings)) = CreateQuantizationParameter(this->settings);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_LOOP_FILTER")
+  case SETTINGS_INDEX_LOOP_FILTER:
   {
     *(static_cast<LoopFilterType*>(settings)) = CreateLoopFilter(this->settings);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_PROFILE_LEVEL")
+  case SETTINGS_INDEX_PROFILE_LEVEL:
   {
     *(static_cast<ProfileLevelType*>(settings)) = CreateProfileLevel(this->settings);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_PROFILES_LEVELS_SUPPORTED")
+  case SETTINGS_INDEX_PROFILES_LEVELS_SUPPORTED:
   {
     *(static_cast<vector<ProfileLevelType>*>(settings)) = CreateHEVCProfileLevelSupported(profiles, levels);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_FORMAT")
+  case SETTINGS_INDEX_FORMAT:
   {
     *(static_cast<Format*>(settings)) = CreateFormat(this->settings);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_FORMATS_SUPPORTED")
+  case SETTINGS_INDEX_FORMATS_SUPPORTED:
   {
     SupportedFormats supported;
     supported.input = CreateFormatsSupported(colors, bitdepths);
@@ -324,19 +327,19 @@ MediatypeInterface::ErrorSettingsType EncMediatypeHEVC::Get(std::string index, v
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_SLICE_PARAMETER")
+  case SETTINGS_INDEX_SLICE_PARAMETER:
   {
     *(static_cast<Slices*>(settings)) = CreateSlicesParameter(this->settings);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_SUBFRAME")
+  case SETTINGS_INDEX_SUBFRAME:
   {
     *(static_cast<bool*>(settings)) = (this->settings.tChParam[0].bSubframeLatency);
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_RESOLUTION")
+  case SETTINGS_INDEX_RESOLUTION:
   {
     *(static_cast<Resolution*>(settings)) = CreateResolution(this->settings, stride, sliceHeight);
     return ERROR_SETTINGS_NONE;
@@ -344,13 +347,23 @@ MediatypeInterface::ErrorSettingsType EncMediatypeHEVC::Get(std::string index, v
 
 #if AL_ENABLE_TWOPASS
 
-  if(index == "SETTINGS_INDEX_LOOKAHEAD")
+  case SETTINGS_INDEX_LOOKAHEAD:
   {
     *(static_cast<LookAhead*>(settings)) = CreateLookAhead(this->settings);
     return ERROR_SETTINGS_NONE;
   }
 #endif
 
+  case SETTINGS_INDEX_SCENE_CHANGE_DETECTION:
+  {
+    *(static_cast<bool*>(settings)) = sceneChangeDetection;
+    return ERROR_SETTINGS_NONE;
+  }
+
+  default:
+    break;
+  }
+
   return ERROR_SETTINGS_BAD_INDEX;
 }
 
@@ -409,12 +422,14 @@ static bool UpdateProfileLevel(AL_TEncSettings& settings, ProfileLevelType profi
   return true;
 }
 
-MediatypeInterface::ErrorSettingsType EncMediatypeHEVC::Set(std::string index, void const* settings)
+MediatypeInterface::ErrorSettingsType EncMediatypeHEVC::Set(SettingsIndex index, void const* settings)
 {
   if(!settings)
     return ERROR_SETTINGS_BAD_PARAMETER;
 
-  if(index == "SETTINGS_INDEX_CLOCK")
+  switch(index)
+  {
+  case SETTINGS_INDEX_CLOCK:
   {
     auto clock = *(static_cast<Clock const*>(settings));
 
@@ -423,7 +438,7 @@ MediatypeInterface::ErrorSettingsType EncMediatypeHEVC::Set(std::string index, v
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_GROUP_OF_PICTURES")
+  case SETTINGS_INDEX_GROUP_OF_PICTURES:
   {
     auto gop = *(static_cast<Gop const*>(settings));
 
@@ -432,7 +447,7 @@ MediatypeInterface::ErrorSettingsType EncMediatypeHEVC::Set(std::string index, v
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_LOW_BANDWIDTH")
+  case SETTINGS_INDEX_LOW_BANDWIDTH:
   {
     auto isLowBandwidthEnabled = *(static_cast<bool const*>(settings));
 
@@ -441,7 +456,7 @@ MediatypeInterface::ErrorSettingsType EncMediatypeHEVC::Set(std::string index, v
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_CONSTRAINED_INTRA_PREDICTION")
+  case SETTINGS_INDEX_CONSTRAINED_INTRA_PREDICTION:
   {
     auto isConstrainedIntraPredictionEnabled = *(static_cast<bool const*>(settings));
 
@@ -450,7 +465,7 @@ MediatypeInterface::ErrorSettingsType EncMediatypeHEVC::Set(std::string index, v
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_VIDEO_MODE")
+  case SETTINGS_INDEX_VIDEO_MODE:
   {
     auto videoMode = *(static_cast<VideoModeType const*>(settings));
 
@@ -459,7 +474,7 @@ MediatypeInterface::ErrorSettingsType EncMediatypeHEVC::Set(std::string index, v
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_BITRATE")
+  case SETTINGS_INDEX_BITRATE:
   {
     auto bitrate = *(static_cast<Bitrate const*>(settings));
 
@@ -468,7 +483,7 @@ MediatypeInterface::ErrorSettingsType EncMediatypeHEVC::Set(std::string index, v
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_CACHE_LEVEL2")
+  case SETTINGS_INDEX_CACHE_LEVEL2:
   {
     auto isCacheLevel2Enabled = *(static_cast<bool const*>(settings));
 
@@ -477,7 +492,7 @@ MediatypeInterface::ErrorSettingsType EncMediatypeHEVC::Set(std::string index, v
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_FILLER_DATA")
+  case SETTINGS_INDEX_FILLER_DATA:
   {
     auto isFillerDataEnabled = *(static_cast<bool const*>(settings));
 
@@ -486,7 +501,7 @@ MediatypeInterface::ErrorSettingsType EncMediatypeHEVC::Set(std::string index, v
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_ASPECT_RATIO")
+  case SETTINGS_INDEX_ASPECT_RATIO:
   {
     auto aspectRatio = *(static_cast<AspectRatioType const*>(settings));
 
@@ -495,7 +510,7 @@ MediatypeInterface::ErrorSettingsType EncMediatypeHEVC::Set(std::string index, v
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_SCALING_LIST")
+  case SETTINGS_INDEX_SCALING_LIST:
   {
     auto scalingList = *(static_cast<ScalingListType const*>(settings));
 
@@ -504,7 +519,7 @@ MediatypeInterface::ErrorSettingsType EncMediatypeHEVC::Set(std::string index, v
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_QUANTIZATION_PARAMETER")
+  case SETTINGS_INDEX_QUANTIZATION_PARAMETER:
   {
     auto qps = *(static_cast<QPs const*>(settings));
 
@@ -513,7 +528,7 @@ MediatypeInterface::ErrorSettingsType EncMediatypeHEVC::Set(std::string index, v
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_LOOP_FILTER")
+  case SETTINGS_INDEX_LOOP_FILTER:
   {
     auto loopFilter = *(static_cast<LoopFilterType const*>(settings));
 
@@ -523,7 +538,7 @@ MediatypeInterface::ErrorSettingsType EncMediatypeHEVC::Set(std::string index, v
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_PROFILE_LEVEL")
+  case SETTINGS_INDEX_PROFILE_LEVEL:
   {
     auto profilelevel = *(static_cast<ProfileLevelType const*>(settings));
 
@@ -532,7 +547,7 @@ MediatypeInterface::ErrorSettingsType EncMediatypeHEVC::Set(std::string index, v
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_FORMAT")
+  case SETTINGS_INDEX_FORMAT:
   {
     auto format = *(static_cast<Format const*>(settings));
 
@@ -541,7 +556,7 @@ MediatypeInterface::ErrorSettingsType EncMediatypeHEVC::Set(std::string index, v
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_SLICE_PARAMETER")
+  case SETTINGS_INDEX_SLICE_PARAMETER:
   {
     auto slices = *(static_cast<Slices const*>(settings));
 
@@ -551,7 +566,7 @@ MediatypeInterface::ErrorSettingsType EncMediatypeHEVC::Set(std::string index, v
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_BUFFER_HANDLES")
+  case SETTINGS_INDEX_BUFFER_HANDLES:
   {
     auto bufferHandles = *(static_cast<BufferHandles const*>(settings));
 
@@ -560,7 +575,7 @@ MediatypeInterface::ErrorSettingsType EncMediatypeHEVC::Set(std::string index, v
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_SUBFRAME")
+  case SETTINGS_INDEX_SUBFRAME:
   {
     auto isEnabledSubFrame = *(static_cast<bool const*>(settings));
 
@@ -569,7 +584,7 @@ MediatypeInterface::ErrorSettingsType EncMediatypeHEVC::Set(std::string index, v
     return ERROR_SETTINGS_NONE;
   }
 
-  if(index == "SETTINGS_INDEX_RESOLUTION")
+  case SETTINGS_INDEX_RESOLUTION:
   {
     auto resolution = *(static_cast<Resolution const*>(settings));
 
@@ -580,7 +595,7 @@ MediatypeInterface::ErrorSettingsType EncMediatypeHEVC::Set(std::string index, v
 
 #if AL_ENABLE_TWOPASS
 
-  if(index == "SETTINGS_INDEX_LOOKAHEAD")
+  case SETTINGS_INDEX_LOOKAHEAD:
   {
     auto la = *(static_cast<LookAhead const*>(settings));
 
@@ -590,6 +605,17 @@ MediatypeInterface::ErrorSettingsType EncMediatypeHEVC::Set(std::string index, v
     return ERROR_SETTINGS_NONE;
   }
 #endif
+
+  case SETTINGS_INDEX_SCENE_CHANGE_DETECTION:
+  {
+    sceneChangeDetection = *(static_cast<bool const*>(settings));
+    return ERROR_SETTINGS_NONE;
+  }
+
+  default:
+    break;
+  }
+
   return ERROR_SETTINGS_BAD_INDEX;
 }
 
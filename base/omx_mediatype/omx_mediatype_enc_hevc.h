@@ -47,8 +47,8 @@ struct EncMediatypeHEVC : EncMediatypeInterface
   ~EncMediatypeHEVC() override;
 
   void Reset() override;
-  ErrorSettingsType Get(std::string index, void* settings) const override;
-  ErrorSettingsType Set(std::string index, void const* settings) override;
+  ErrorSettingsType Get(SettingsIndex index, void* settings) const override;
+  ErrorSettingsType Set(SettingsIndex index, void const* settings) override;
 
 private:
   Stride strideAlignment;
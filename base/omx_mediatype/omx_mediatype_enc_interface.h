@@ -53,11 +53,12 @@ struct EncMediatypeInterface : public MediatypeInterface
   }
 
   virtual void Reset() = 0;
-  virtual ErrorSettingsType Get(std::string index, void* settings) const = 0;
-  virtual ErrorSettingsType Set(std::string index, void const* settings) = 0;
+  virtual ErrorSettingsType Get(SettingsIndex index, void* settings) const = 0;
+  virtual ErrorSettingsType Set(SettingsIndex index, void const* settings) = 0;
 
   AL_TEncSettings settings;
   int stride;
   int sliceHeight;
+  bool sceneChangeDetection; // done by the module on the input frames, not part of the encoder settings
 };
 
@@ -39,37 +39,42 @@
 
 #include <string>
 
-#define SETTINGS_INDEX_MIMES "SETTINGS_INDEX_MIMES"
-#define SETTINGS_INDEX_CLOCK "SETTINGS_INDEX_CLOCK"
-#define SETTINGS_INDEX_STRIDE_ALIGNMENT "SETTINGS_INDEX_STRIDE_ALIGNMENT"
-#define SETTINGS_INDEX_GROUP_OF_PICTURES "SETTINGS_INDEX_GROUP_OF_PICTURES"
-#define SETTINGS_INDEX_INTERNAL_ENTROPY_BUFFER "SETTINGS_INDEX_INTERNAL_ENTROPY_BUFFER"
-#define SETTINGS_INDEX_LATENCY "SETTINGS_INDEX_LATENCY"
-#define SETTINGS_INDEX_LOW_BANDWIDTH "SETTINGS_INDEX_LOW_BANDWIDTH"
-#define SETTINGS_INDEX_CONSTRAINED_INTRA_PREDICTION "SETTINGS_INDEX_CONSTRAINED_INTRA_PREDICTION"
-#define SETTINGS_INDEX_ENTROPY_CODING "SETTINGS_INDEX_ENTROPY_CODING"
-#define SETTINGS_INDEX_VIDEO_MODE "SETTINGS_INDEX_VIDEO_MODE"
-#define SETTINGS_INDEX_VIDEO_MODES_SUPPORTED "SETTINGS_INDEX_VIDEO_MODES_SUPPORTED"
-#define SETTINGS_INDEX_SEQUENCE_PICTURE_MODE "SETTINGS_INDEX_SEQUENCE_PICTURE_MODE"
-#define SETTINGS_INDEX_SEQUENCE_PICTURE_MODES_SUPPORTED "SETTINGS_INDEX_SEQUENCE_PICTURE_MODES_SUPPORTED"
-#define SETTINGS_INDEX_BITRATE "SETTINGS_INDEX_BITRATE"
-#define SETTINGS_INDEX_CACHE_LEVEL2 "SETTINGS_INDEX_CACHE_LEVEL2"
-#define SETTINGS_INDEX_BUFFER_HANDLES "SETTINGS_INDEX_BUFFER_HANDLES"
-#define SETTINGS_INDEX_BUFFER_COUNTS "SETTINGS_INDEX_BUFFER_COUNTS"
-#define SETTINGS_INDEX_FILLER_DATA "SETTINGS_INDEX_FILLER_DATA"
-#define SETTINGS_INDEX_ASPECT_RATIO "SETTINGS_INDEX_ASPECT_RATIO"
-#define SETTINGS_INDEX_SCALING_LIST "SETTINGS_INDEX_SCALING_LIST"
-#define SETTINGS_INDEX_QUANTIZATION_PARAMETER "SETTINGS_INDEX_QUANTIZATION_PARAMETER"
-#define SETTINGS_INDEX_LOOP_FILTER "SETTINGS_INDEX_LOOP_FILTER"
-#define SETTINGS_INDEX_PROFILE_LEVEL "SETTINGS_INDEX_PROFILE_LEVEL"
-#define SETTINGS_INDEX_PROFILES_LEVELS_SUPPORTED "SETTINGS_INDEX_PROFILES_LEVELS_SUPPORTED"
-#define SETTINGS_INDEX_FORMAT "SETTINGS_INDEX_FORMAT"
-#define SETTINGS_INDEX_FORMATS_SUPPORTED "SETTINGS_INDEX_FORMATS_SUPPORTED"
-#define SETTINGS_INDEX_SLICE_PARAMETER "SETTINGS_INDEX_SLICE_PARAMETER"
-#define SETTINGS_INDEX_SUBFRAME "SETTINGS_INDEX_SUBFRAME"
-#define SETTINGS_INDEX_RESOLUTION "SETTINGS_INDEX_RESOLUTION"
-#define SETTINGS_INDEX_DECODED_PICTURE_BUFFER "SETTINGS_INDEX_DECODED_PICTURE_BUFFER"
-#define SETTINGS_INDEX_LOOKAHEAD "SETTINGS_INDEX_LOOKAHEAD"
+enum SettingsIndex
+{
+  SETTINGS_INDEX_MIMES,
+  SETTINGS_INDEX_CLOCK,
+  SETTINGS_INDEX_STRIDE_ALIGNMENT,
+  SETTINGS_INDEX_GROUP_OF_PICTURES,
+  SETTINGS_INDEX_INTERNAL_ENTROPY_BUFFER,
+  SETTINGS_INDEX_LATENCY,
+  SETTINGS_INDEX_LOW_BANDWIDTH,
+  SETTINGS_INDEX_CONSTRAINED_INTRA_PREDICTION,
+  SETTINGS_INDEX_ENTROPY_CODING,
+  SETTINGS_INDEX_VIDEO_MODE,
+  SETTINGS_INDEX_VIDEO_MODES_SUPPORTED,
+  SETTINGS_INDEX_SEQUENCE_PICTURE_MODE,
+  SETTINGS_INDEX_SEQUENCE_PICTURE_MODES_SUPPORTED,
+  SETTINGS_INDEX_BITRATE,
+  SETTINGS_INDEX_CACHE_LEVEL2,
+  SETTINGS_INDEX_BUFFER_HANDLES,
+  SETTINGS_INDEX_BUFFER_COUNTS,
+  SETTINGS_INDEX_FILLER_DATA,
+  SETTINGS_INDEX_ASPECT_RATIO,
+  SETTINGS_INDEX_SCALING_LIST,
+  SETTINGS_INDEX_QUANTIZATION_PARAMETER,
+  SETTINGS_INDEX_LOOP_FILTER,
+  SETTINGS_INDEX_PROFILE_LEVEL,
+  SETTINGS_INDEX_PROFILES_LEVELS_SUPPORTED,
+  SETTINGS_INDEX_FORMAT,
+  SETTINGS_INDEX_FORMATS_SUPPORTED,
+  SETTINGS_INDEX_SLICE_PARAMETER,
+  SETTINGS_INDEX_SUBFRAME,
+  SETTINGS_INDEX_RESOLUTION,
+  SETTINGS_INDEX_DECODED_PICTURE_BUFFER,
+  SETTINGS_INDEX_LOOKAHEAD,
+  SETTINGS_INDEX_SCENE_CHANGE_DETECTION,
+  SETTINGS_INDEX_MAX,
+};
 
 struct MediatypeInterface
 {
@@ -84,8 +89,8 @@ struct MediatypeInterface
   };
 
   virtual ~MediatypeInterface() = 0;
-  virtual ErrorSettingsType Get(std::string index, void* settings) const = 0;
-  virtual ErrorSettingsType Set(std::string index, void const* settings) = 0;
+  virtual ErrorSettingsType Get(SettingsIndex index, void* settings) const = 0;
+  virtual ErrorSettingsType Set(SettingsIndex index, void const* settings) = 0;
   virtual void Reset() = 0;
 };
 
@@ -38,9 +38,14 @@
 #include "DummySyncDriver.h"
 #include "SyncLog.h"
 #include <cassert>
+#include <random>
+#include <stdexcept>
 
 extern "C"
 {
+#include <sys/eventfd.h>
+#include <unistd.h>
+
 /* needed definition for xvsfsync.h */
 #include <sys/ioctl.h>
 #define BIT(x) (1 << (x))
@@ -85,6 +90,21 @@ int findFirstBusyFrameBuffer(ChannelStatus const& channelStatus)
   return -1;
 }
 
+/* the producer writes the framebuffers in the order they were programmed */
+template<typename TimePoints>
+static int findOldestBusyFrameBuffer(ChannelStatus const& channelStatus, TimePoints const& enqueueTimes)
+{
+  int oldest = -1;
+
+  for(int fbNum = 0; fbNum < MAX_FB_NUMBER; ++fbNum)
+  {
+    if(!channelStatus.fbAvail[fbNum] && (oldest == -1 || enqueueTimes[fbNum] < enqueueTimes[oldest]))
+      oldest = fbNum;
+  }
+
+  return oldest;
+}
+
 static u32 encodeChannelStatus(vector<ChannelStatus>& channelStatuses)
 {
   u32 status = 0;
@@ -133,6 +153,13 @@ static AL_EDriverError sPostMessage(AL_TDriver* driver, int fd, long unsigned in
   return pThis->PostMessage(fd, messageId, data);
 }
 
+/* The producer logs through globals of other units, it can't outlive them:
+ * it only runs while the device is open, the close joins it */
+DummyDriver::~DummyDriver()
+{
+  assert(!simulationThread.joinable());
+}
+
 DummyDriver::DummyDriver()
 {
   static const AL_DriverVtable myVtable =
@@ -148,12 +175,54 @@ DummyDriver::DummyDriver()
 int DummyDriver::Open(const char* device)
 {
   (void)device;
-  return 1;
+  lock_guard<std::mutex> lock(mutex);
+  assert(eventFd == -1);
+  eventFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+  if(hasSimulation && !simulation.manualClock && eventFd != -1)
+  {
+    ScheduleFirstTick(Now());
+    isSimulating = true;
+    simulationThread = thread(&DummyDriver::Simulate, this);
+  }
+  return eventFd;
 }
 
 void DummyDriver::Close(int fd)
 {
-  (void)fd;
+  JoinSimulation();
+  lock_guard<std::mutex> lock(mutex);
+  assert(fd == eventFd);
+  close(fd);
+  eventFd = -1;
+}
+
+/* Level triggered like the hardware: the event stays set until all the errors are cleared */
+void DummyDriver::UpdateErrorEvent()
+{
+  if(eventFd == -1)
+    return;
+
+  bool hasError = false;
+
+  for(auto& channelStatus : channelStatuses)
+    hasError = hasError || channelStatus.syncError || channelStatus.watchdogError;
+
+  uint64_t count;
+
+  if(hasError)
+  {
+    count = 1;
+
+    if(write(eventFd, &count, sizeof(count)) != sizeof(count))
+      Log("driver", "Couldn't signal the error event\n");
+  }
+  else
+  {
+    // nothing to read is fine, the event was already cleared
+    if(read(eventFd, &count, sizeof(count)) != sizeof(count))
+      return;
+  }
 }
 
 static AL_EDriverError xvsfsync_get_cfg(DummyDriver* pThis, struct xvsfsync_config* config)
@@ -181,6 +250,7 @@ static AL_EDriverError xvsfsync_set_chan_config(DummyDriver* pThis, struct xvsfs
   if(fbNum == -1 || !channelStatus.fbAvail[fbNum])
     return DRIVER_ERROR_UNKNOWN;
   channelStatus.fbAvail[fbNum] = false;
+  pThis->enqueueTimes[config->channel_id][fbNum] = pThis->Now();
   return DRIVER_SUCCESS;
 }
 
@@ -207,6 +277,8 @@ static AL_EDriverError xvsfsync_clear_chan_errors(DummyDriver* pThis, struct xvs
 
   if(clr->wdg_err)
     pThis->channelStatuses[clr->channel_id].watchdogError = false;
+
+  pThis->UpdateErrorEvent();
   return DRIVER_SUCCESS;
 }
 
@@ -227,6 +299,7 @@ static AL_EDriverError xvsfsync_poll(DummyDriver* pThis)
 AL_EDriverError DummyDriver::PostMessage(int fd, long unsigned int messageId, void* data)
 {
   (void)fd;
+  lock_guard<std::mutex> lock(mutex);
   switch(messageId)
   {
   case XVSFSYNC_GET_CFG:
@@ -257,6 +330,7 @@ AL_EDriverError DummyDriver::PostMessage(int fd, long unsigned int messageId, vo
 
 void DummyDriver::FinalizeBuffer(int chanId, int fb_id)
 {
+  lock_guard<std::mutex> lock(mutex);
   auto& channelStatus = channelStatuses[chanId];
 
   if(!channelStatus.enable)
@@ -265,32 +339,187 @@ void DummyDriver::FinalizeBuffer(int chanId, int fb_id)
   if(fb_id == -1)
     fb_id = findFirstBusyFrameBuffer(channelStatus);
 
-  auto& fbAvail = channelStatus.fbAvail[fb_id];
-
-  if(fbAvail)
+  if(!Finalize(chanId, fb_id, Now()))
     throw runtime_error("Frame buffer isn't busy");
-  fbAvail = true;
+}
+
+chrono::steady_clock::time_point DummyDriver::Now() const
+{
+  if(hasSimulation && simulation.manualClock)
+    return simulatedNow;
+  return chrono::steady_clock::now();
+}
+
+/* Marks a programmed framebuffer as written, false if it isn't busy */
+bool DummyDriver::Finalize(int chanId, int fb_id, chrono::steady_clock::time_point now)
+{
+  if(fb_id == -1 || channelStatuses[chanId].fbAvail[fb_id])
+    return false;
+
+  channelStatuses[chanId].fbAvail[fb_id] = true;
+  latencies[chanId].push_back(chrono::duration_cast<chrono::microseconds>(now - enqueueTimes[chanId][fb_id]));
 
   Log("framebuffer", "Finalize framebuffer id %d for channel %d\n", fb_id, chanId);
+  return true;
+}
+
+void DummyDriver::StartSimulation(DummySyncSimulation const& simulation)
+{
+  assert(simulation.framerate > 0);
+  JoinSimulation();
+
+  lock_guard<std::mutex> lock(mutex);
+  this->simulation = simulation;
+  hasSimulation = true;
+  random.seed(simulation.seed);
+  ScheduleFirstTick(Now());
+
+  if(eventFd == -1 || simulation.manualClock)
+    return;
+
+  isSimulating = true;
+  simulationThread = thread(&DummyDriver::Simulate, this);
+}
+
+void DummyDriver::StopSimulation()
+{
+  {
+    lock_guard<std::mutex> lock(mutex);
+    hasSimulation = false;
+  }
+  JoinSimulation();
+}
+
+void DummyDriver::JoinSimulation()
+{
+  {
+    lock_guard<std::mutex> lock(mutex);
+    isSimulating = false;
+  }
+  simulationStop.notify_all();
+
+  if(simulationThread.joinable())
+    simulationThread.join();
+}
+
+void DummyDriver::AdvanceSimulation(chrono::microseconds duration)
+{
+  lock_guard<std::mutex> lock(mutex);
+  assert(hasSimulation && simulation.manualClock);
+  auto const end = simulatedNow + duration;
+
+  while(nextWrite <= end)
+  {
+    simulatedNow = nextWrite;
+    WriteFrameBuffers();
+  }
+
+  simulatedNow = end;
+}
+
+/* The ticks don't drift: the jitter moves a tick, not the ones after it */
+void DummyDriver::ScheduleFirstTick(chrono::steady_clock::time_point now)
+{
+  tick = now;
+  ScheduleNextTick();
+}
+
+void DummyDriver::ScheduleNextTick()
+{
+  uniform_int_distribution<int64_t> jitter(-simulation.jitter.count(), simulation.jitter.count());
+  tick += chrono::duration_cast<chrono::steady_clock::duration>(chrono::seconds(1)) / simulation.framerate;
+  nextWrite = tick + chrono::microseconds(jitter(random));
+}
+
+/* Each frame period, the oldest framebuffer of every enabled channel is written */
+void DummyDriver::WriteFrameBuffers()
+{
+  bernoulli_distribution syncError(simulation.syncErrorRate);
+  bernoulli_distribution watchdogError(simulation.watchdogErrorRate);
+  bool hasNewError = false;
+
+  for(int chanId = 0; chanId < numChan; ++chanId)
+  {
+    auto& channelStatus = channelStatuses[chanId];
+
+    if(!channelStatus.enable || !Finalize(chanId, findOldestBusyFrameBuffer(channelStatus, enqueueTimes[chanId]), nextWrite))
+      continue;
+
+    if(syncError(random))
+    {
+      channelStatus.syncError = true;
+      ++simulatedErrors[chanId];
+      hasNewError = true;
+    }
+
+    if(watchdogError(random))
+    {
+      channelStatus.watchdogError = true;
+      ++simulatedErrors[chanId];
+      hasNewError = true;
+    }
+  }
+
+  if(hasNewError)
+    UpdateErrorEvent();
+
+  ScheduleNextTick();
+}
+
+void DummyDriver::Simulate()
+{
+  unique_lock<std::mutex> lock(mutex);
+
+  while(!simulationStop.wait_until(lock, nextWrite, [&] { return !isSimulating;
+                                   }))
+    WriteFrameBuffers();
+}
+
+vector<chrono::microseconds> DummyDriver::GetLatencies(int chanId)
+{
+  lock_guard<std::mutex> lock(mutex);
+  return latencies[chanId];
+}
+
+void DummyDriver::ClearLatencies()
+{
+  lock_guard<std::mutex> lock(mutex);
+
+  for(auto& channelLatencies : latencies)
+    channelLatencies.clear();
+}
+
+int DummyDriver::GetSimulatedErrors(int chanId)
+{
+  lock_guard<std::mutex> lock(mutex);
+  return simulatedErrors[chanId];
 }
 
 void DummyDriver::SignalSyncError(int chanId)
 {
+  lock_guard<std::mutex> lock(mutex);
   channelStatuses[chanId].syncError = true;
+  UpdateErrorEvent();
 }
 
 void DummyDriver::SignalWatchdogError(int chanId)
 {
+  lock_guard<std::mutex> lock(mutex);
   channelStatuses[chanId].watchdogError = true;
+  UpdateErrorEvent();
 }
 
 static DummyDriver dummyDriver;
 
 DummyDriver* AL_InitDummyDriver(bool encode, int numChan)
 {
+  lock_guard<std::mutex> lock(dummyDriver.mutex);
   dummyDriver.encode = encode;
   dummyDriver.numChan = numChan;
   dummyDriver.channelStatuses.resize(numChan);
+  dummyDriver.enqueueTimes.resize(numChan);
+  dummyDriver.latencies.resize(numChan);
+  dummyDriver.simulatedErrors.assign(numChan, 0);
 
   for(auto& channelStatus : dummyDriver.channelStatuses)
   {
@@ -42,20 +42,40 @@ extern "C"
 #include "lib_common/IDriver.h"
 }
 
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <random>
+#include <thread>
 #include <vector>
 
 #include "SyncIp.h"
 
+/* Producer simulated by the dummy driver: the framebuffers of the enabled channels
+ * are written at the framerate, the errors are drawn for each framebuffer */
+struct DummySyncSimulation
+{
+  int framerate = 60;
+  std::chrono::microseconds jitter = std::chrono::microseconds::zero();
+  double syncErrorRate = 0.0;
+  double watchdogErrorRate = 0.0;
+  unsigned seed = 0;
+  /* the time only moves with AdvanceSimulation: no producer thread, the schedule
+   * and the latencies don't depend on the load of the machine */
+  bool manualClock = false;
+};
+
 struct DummyDriver : public AL_TDriver
 {
   DummyDriver();
-  virtual ~DummyDriver() {};
+  virtual ~DummyDriver();
 
   int Open(const char* device);
   void Close(int fd);
   AL_EDriverError PostMessage(int fd, long unsigned int messageId, void* data);
 
-  /* mock-up interface */
+  /* mock-up interface, can be called from any thread */
 
   void FinalizeBuffer(int chanId, int fb_id = -1);
   void SignalSyncError(int chanId);
@@ -63,6 +83,47 @@ struct DummyDriver : public AL_TDriver
   bool encode = true;
   int numChan = 4;
   std::vector<ChannelStatus> channelStatuses {};
+
+  /* the opened device is an eventfd, readable while a channel has an error */
+  int eventFd = -1;
+  std::mutex mutex {};
+  void UpdateErrorEvent();
+
+  /* time driven mock-up: a producer thread finalizes the framebuffers.
+   * It runs while the device is open, from the start until the stop */
+  void StartSimulation(DummySyncSimulation const& simulation);
+  void StopSimulation();
+  /* manual clock only: writes the framebuffers due in the next duration */
+  void AdvanceSimulation(std::chrono::microseconds duration);
+
+  /* time between the programming of a framebuffer and its completion, in completion order */
+  std::vector<std::chrono::microseconds> GetLatencies(int chanId);
+  void ClearLatencies();
+  /* sync and watchdog errors raised by the simulation */
+  int GetSimulatedErrors(int chanId);
+
+  std::vector<std::array<std::chrono::steady_clock::time_point, MAX_FB_NUMBER>> enqueueTimes {};
+  std::vector<std::vector<std::chrono::microseconds>> latencies {};
+  std::vector<int> simulatedErrors {};
+  /* clock of the latencies, the simulated one with a manual clock */
+  std::chrono::steady_clock::time_point Now() const;
+
+private:
+  std::thread simulationThread;
+  std::condition_variable simulationStop;
+  DummySyncSimulation simulation {};
+  bool hasSimulation = false;
+  bool isSimulating = false;
+  std::mt19937 random;
+  std::chrono::steady_clock::time_point tick {};
+  std::chrono::steady_clock::time_point nextWrite {};
+  std::chrono::steady_clock::time_point simulatedNow {};
+  void Simulate();
+  void JoinSimulation();
+  void ScheduleFirstTick(std::chrono::steady_clock::time_point now);
+  void ScheduleNextTick();
+  void WriteFrameBuffers();
+  bool Finalize(int chanId, int fb_id, std::chrono::steady_clock::time_point now);
 };
 
 DummyDriver* AL_InitDummyDriver(bool encode, int numChan);
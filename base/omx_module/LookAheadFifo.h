@@ -0,0 +1,81 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+extern "C"
+{
+#include <lib_common/BufferAPI.h>
+}
+
+/* Frame waiting in the lookahead, its metadata is looked up once when it enters the fifo */
+struct LookAheadFrame
+{
+  AL_TBuffer* src;
+  AL_TMetaData* meta;
+  int pictureSize;
+};
+
+/* Fixed capacity ring: the picture sizes of the first frames and of all the frames are summed as they come and go */
+struct LookAheadFifo
+{
+  static int constexpr HEAD_SIZE = 5;
+
+  void Reset(int capacity);
+  void Push(LookAheadFrame const& frame);
+  LookAheadFrame Pop();
+
+  LookAheadFrame const& operator[](int i) const
+  {
+    auto slot = head + i;
+    return frames[slot < (int)frames.size() ? slot : slot - frames.size()];
+  }
+
+  int Size() const { return count; }
+  bool Empty() const { return count == 0; }
+
+  int64_t headPictureSize = 0;
+  int64_t totalPictureSize = 0;
+
+private:
+  std::vector<LookAheadFrame> frames {};
+  int head = 0;
+  int count = 0;
+};
@@ -0,0 +1,85 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include "QuantizationParameterTables.h"
+
+void QuantizationParameterTables::Open()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  isOpen = true;
+}
+
+void QuantizationParameterTables::Close()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  isOpen = false;
+
+  for(auto table : tables.PopAll())
+    AL_Buffer_Unref(table);
+}
+
+ErrorType QuantizationParameterTables::Add(BufferHandleInterface* handle, std::function<AL_TBuffer*()> const& create)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+
+  if(!isOpen)
+    return ERROR_UNDEFINED;
+
+  auto table = create();
+
+  if(!table)
+    return ERROR_BAD_PARAMETER;
+
+  // the last table given for a frame wins
+  AL_TBuffer* previous;
+
+  if(tables.TryPop(handle, previous))
+    AL_Buffer_Unref(previous);
+
+  tables.Add(handle, table);
+  return SUCCESS;
+}
+
+AL_TBuffer* QuantizationParameterTables::Pop(BufferHandleInterface* handle)
+{
+  AL_TBuffer* table;
+
+  if(tables.TryPop(handle, table) || tables.TryPop(nullptr, table))
+    return table;
+
+  return nullptr;
+}
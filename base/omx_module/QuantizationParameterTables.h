@@ -0,0 +1,73 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#pragma once
+
+#include <functional>
+#include <mutex>
+
+#include "omx_module_interface.h"
+#include "base/omx_utils/flat_map.h"
+
+extern "C"
+{
+#include <lib_common/BufferAPI.h>
+}
+
+/* QP tables given from the client thread, pending until the frame they are for is emptied.
+ * A table is keyed to the header of its frame, a null header is for the next frame.
+ * Tables are only taken while the encoder exists, the pending ones are released with it */
+struct QuantizationParameterTables
+{
+  /* the encoder is created: tables are taken until Close */
+  void Open();
+
+  /* the encoder is destroyed: the pending tables are released, the next ones refused */
+  void Close();
+
+  /* The table is created under the lock so it can't be added after Close, it replaces the one pending for the same header.
+   * ERROR_UNDEFINED when closed, ERROR_BAD_PARAMETER when it couldn't be created */
+  ErrorType Add(BufferHandleInterface* handle, std::function<AL_TBuffer*()> const& create);
+
+  /* the table of that frame, else the one of the next frame, else nullptr. The caller owns its reference */
+  AL_TBuffer* Pop(BufferHandleInterface* handle);
+
+private:
+  std::mutex mutex;
+  bool isOpen = false;
+  FlatMap<BufferHandleInterface*, AL_TBuffer*> tables;
+};
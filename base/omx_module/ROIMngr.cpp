@@ -36,7 +36,9 @@
 ******************************************************************************/
 
 #include "ROIMngr.h"
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 
 extern "C"
 {
@@ -71,26 +73,6 @@ static int8_t ToInt(AL_ERoiQuality eQuality)
   return extendSign(eQuality, 6);
 }
 
-/****************************************************************************/
-static void PushBack(AL_TRoiMngrCtx* pCtx, AL_TRoiNode* pNode)
-{
-  if(pCtx->pFirstNode)
-  {
-    assert(pCtx->pLastNode);
-    pNode->pPrev = pCtx->pLastNode;
-    pNode->pNext = NULL;
-    pCtx->pLastNode->pNext = pNode;
-    pCtx->pLastNode = pNode;
-  }
-  else
-  {
-    assert(!pCtx->pLastNode);
-    pNode->pPrev = NULL;
-    pNode->pNext = NULL;
-    pCtx->pFirstNode = pCtx->pLastNode = pNode;
-  }
-}
-
 /****************************************************************************/
 static uint8_t GetNewDeltaQP(AL_ERoiQuality eQuality)
 {
@@ -106,24 +88,30 @@ static int8_t GetDQp(uint8_t iDeltaQP)
 }
 
 /****************************************************************************/
-static void Insert(AL_TRoiMngrCtx* pCtx, AL_TRoiNode* pNode)
+static bool Grow(void** ppBuf, int* pCapacity, int iCount, size_t zElemSize)
 {
-  AL_TRoiNode* pCur = pCtx->pFirstNode;
+  if(iCount <= *pCapacity)
+    return true;
 
-  while(pCur && GetDQp(pCur->iDeltaQP) > GetDQp(pNode->iDeltaQP))
-    pCur = pCur->pNext;
+  int iCapacity = *pCapacity ? *pCapacity : 16;
 
-  if(pCur)
-  {
-    pNode->pPrev = pCur->pPrev;
-    pNode->pNext = pCur;
-    pCur->pPrev = pNode;
+  while(iCapacity < iCount)
+    iCapacity *= 2;
+
+  void* pBuf = Rtos_Malloc(iCapacity * zElemSize);
+
+  if(!pBuf)
+    return false;
 
-    if(pCur == pCtx->pFirstNode)
-      pCtx->pFirstNode = pNode;
+  if(*ppBuf)
+  {
+    Rtos_Memcpy(pBuf, *ppBuf, *pCapacity * zElemSize);
+    Rtos_Free(*ppBuf);
   }
-  else
-    PushBack(pCtx, pNode);
+
+  *ppBuf = pBuf;
+  *pCapacity = iCapacity;
+  return true;
 }
 
 /****************************************************************************/
@@ -173,6 +161,25 @@ static uint32_t GetNodePosInBuf(AL_TRoiMngrCtx* pCtx, uint32_t uLcuX, uint32_t u
   return uLcuNum * iNumBytesPerLCU;
 }
 
+/****************************************************************************/
+static void FillLCUs(uint8_t* pLCU, int iNumLCUs, int iNumQPPerLCU, int iNumBytesPerLCU, uint8_t uQP)
+{
+  // packed layout: the LCUs form one span, let memset use the widest stores available
+  if(iNumQPPerLCU == iNumBytesPerLCU)
+  {
+    Rtos_Memset(pLCU, uQP, iNumLCUs * iNumBytesPerLCU);
+    return;
+  }
+
+  for(int iLCU = 0; iLCU < iNumLCUs; ++iLCU)
+  {
+    for(int i = 0; i < iNumQPPerLCU; ++i)
+      pLCU[i] = uQP;
+
+    pLCU += iNumBytesPerLCU;
+  }
+}
+
 /****************************************************************************/
 static void ComputeROI(AL_TRoiMngrCtx* pCtx, int iNumQPPerLCU, int iNumBytesPerLCU, uint8_t* pBuf, AL_TRoiNode* pNode)
 {
@@ -181,12 +188,7 @@ static void ComputeROI(AL_TRoiMngrCtx* pCtx, int iNumQPPerLCU, int iNumBytesPerL
   // Fill Roi
   for(int h = 0; h < pNode->iHeight; ++h)
   {
-    for(int w = 0; w < pNode->iWidth; ++w)
-    {
-      for(int i = 0; i < iNumQPPerLCU; ++i)
-        pLCU[w * iNumBytesPerLCU + i] = pNode->iDeltaQP;
-    }
-
+    FillLCUs(pLCU, pNode->iWidth, iNumQPPerLCU, iNumBytesPerLCU, pNode->iDeltaQP);
     pLCU += iNumBytesPerLCU * pCtx->iLcuWidth;
   }
 
@@ -242,6 +244,107 @@ static void ComputeROI(AL_TRoiMngrCtx* pCtx, int iNumQPPerLCU, int iNumBytesPerL
   }
 }
 
+/****************************************************************************/
+static bool IsEmpty(AL_TRoiRect const* pRect)
+{
+  return pRect->iWidth <= 0 || pRect->iHeight <= 0;
+}
+
+/****************************************************************************/
+static void Merge(AL_TRoiRect* pRect, AL_TRoiRect const* pOther)
+{
+  if(IsEmpty(pOther))
+    return;
+
+  if(IsEmpty(pRect))
+  {
+    *pRect = *pOther;
+    return;
+  }
+
+  int iRight = pRect->iPosX + pRect->iWidth;
+  int iBottom = pRect->iPosY + pRect->iHeight;
+  int iOtherRight = pOther->iPosX + pOther->iWidth;
+  int iOtherBottom = pOther->iPosY + pOther->iHeight;
+
+  pRect->iPosX = pOther->iPosX < pRect->iPosX ? pOther->iPosX : pRect->iPosX;
+  pRect->iPosY = pOther->iPosY < pRect->iPosY ? pOther->iPosY : pRect->iPosY;
+  pRect->iWidth = (iOtherRight > iRight ? iOtherRight : iRight) - pRect->iPosX;
+  pRect->iHeight = (iOtherBottom > iBottom ? iOtherBottom : iBottom) - pRect->iPosY;
+}
+
+/****************************************************************************/
+static AL_TRoiRect GetNodeBounds(AL_TRoiMngrCtx* pCtx, AL_TRoiNode const* pNode)
+{
+  // the transitions write one LCU around the ROI
+  int iLeft = Clip3(pNode->iPosX - 1, 0, pCtx->iLcuWidth);
+  int iTop = Clip3(pNode->iPosY - 1, 0, pCtx->iLcuHeight);
+  int iRight = Clip3(pNode->iPosX + pNode->iWidth + 1, 0, pCtx->iLcuWidth);
+  int iBottom = Clip3(pNode->iPosY + pNode->iHeight + 1, 0, pCtx->iLcuHeight);
+
+  AL_TRoiRect tBounds = { iLeft, iTop, iRight - iLeft, iBottom - iTop };
+  return tBounds;
+}
+
+/****************************************************************************/
+static void CopyRect(AL_TRoiMngrCtx* pCtx, AL_TRoiRect const* pRect, uint8_t const* pSrc, uint8_t* pDst)
+{
+  for(int h = 0; h < pRect->iHeight; ++h)
+  {
+    uint32_t uPos = GetNodePosInBuf(pCtx, pRect->iPosX, pRect->iPosY + h, 1);
+    Rtos_Memcpy(pDst + uPos, pSrc + uPos, pRect->iWidth);
+  }
+}
+
+/****************************************************************************/
+static bool IsPaintedBefore(AL_TRoiNode const& tNode1, AL_TRoiNode const& tNode2)
+{
+  // worst quality first so the best one wins, the latest first among equals
+  int8_t iDQp1 = GetDQp(tNode1.iDeltaQP);
+  int8_t iDQp2 = GetDQp(tNode2.iDeltaQP);
+
+  if(iDQp1 != iDQp2)
+    return iDQp1 > iDQp2;
+  return tNode1.iOrder > tNode2.iOrder;
+}
+
+/****************************************************************************/
+static void SortNodes(AL_TRoiMngrCtx* pCtx)
+{
+  if(pCtx->bSorted)
+    return;
+
+  if(pCtx->eOrder == AL_ROI_QUALITY_ORDER)
+    std::sort(pCtx->pNodes, pCtx->pNodes + pCtx->iNumNodes, IsPaintedBefore);
+
+  pCtx->bSorted = true;
+}
+
+/****************************************************************************/
+static void Paint(AL_TRoiMngrCtx* pCtx, int iNumQPPerLCU, int iNumBytesPerLCU, uint8_t* pBuf, AL_TRoiRect const* pArea)
+{
+  SortNodes(pCtx);
+
+  // Fill background, whole rows form a single span
+  uint8_t uBkgQP = GetNewDeltaQP(pCtx->eBkgQuality);
+  auto* pLCU = pBuf + GetNodePosInBuf(pCtx, pArea->iPosX, pArea->iPosY, iNumBytesPerLCU);
+
+  if(pArea->iWidth == pCtx->iLcuWidth)
+    FillLCUs(pLCU, pArea->iWidth * pArea->iHeight, iNumQPPerLCU, iNumBytesPerLCU, uBkgQP);
+  else
+  {
+    for(int h = 0; h < pArea->iHeight; ++h)
+    {
+      FillLCUs(pLCU, pArea->iWidth, iNumQPPerLCU, iNumBytesPerLCU, uBkgQP);
+      pLCU += iNumBytesPerLCU * pCtx->iLcuWidth;
+    }
+  }
+
+  // Fill ROIs
+  for(int iNode = 0; iNode < pCtx->iNumNodes; ++iNode)
+    ComputeROI(pCtx, iNumQPPerLCU, iNumBytesPerLCU, pBuf, &pCtx->pNodes[iNode]);
+}
+
 /****************************************************************************/
 AL_TRoiMngrCtx* AL_RoiMngr_Create(int iPicWidth, int iPicHeight, AL_EProfile eProf, AL_ERoiQuality eBkgQuality, AL_ERoiOrder eOrder)
 {
@@ -257,37 +360,49 @@ AL_TRoiMngrCtx* AL_RoiMngr_Create(int iPicWidth, int iPicHeight, AL_EProfile ePr
 
   pCtx->eBkgQuality = eBkgQuality;
   pCtx->eOrder = eOrder;
-  pCtx->pFirstNode = NULL;
-  pCtx->pLastNode = NULL;
 
   pCtx->iLcuWidth = RoundUp(pCtx->iPicWidth, 1 << pCtx->uLcuSize) >> pCtx->uLcuSize;
   pCtx->iLcuHeight = RoundUp(pCtx->iPicHeight, 1 << pCtx->uLcuSize) >> pCtx->uLcuSize;
   pCtx->iNumLCUs = pCtx->iLcuWidth * pCtx->iLcuHeight;
 
+  pCtx->pNodes = NULL;
+  pCtx->iNumNodes = 0;
+  pCtx->iMaxNodes = 0;
+
+  pCtx->bSorted = true;
+
+  pCtx->pMap = (uint8_t*)Rtos_Malloc(pCtx->iNumLCUs);
+  pCtx->pNextMap = (uint8_t*)Rtos_Malloc(pCtx->iNumLCUs);
+
+  if(!pCtx->pMap || !pCtx->pNextMap)
+  {
+    AL_RoiMngr_Destroy(pCtx);
+    return NULL;
+  }
+
+  uint8_t uBkgQP = GetNewDeltaQP(pCtx->eBkgQuality);
+  FillLCUs(pCtx->pMap, pCtx->iNumLCUs, 1, 1, uBkgQP);
+  FillLCUs(pCtx->pNextMap, pCtx->iNumLCUs, 1, 1, uBkgQP);
+  pCtx->tMapBounds = { 0, 0, 0, 0 };
+
   return pCtx;
 }
 
 /****************************************************************************/
 void AL_RoiMngr_Destroy(AL_TRoiMngrCtx* pCtx)
 {
-  AL_RoiMngr_Clear(pCtx);
+  Rtos_Free(pCtx->pNodes);
+  Rtos_Free(pCtx->pMap);
+  Rtos_Free(pCtx->pNextMap);
   Rtos_Free(pCtx);
 }
 
 /****************************************************************************/
 void AL_RoiMngr_Clear(AL_TRoiMngrCtx* pCtx)
 {
-  AL_TRoiNode* pCur = pCtx->pFirstNode;
-
-  while(pCur)
-  {
-    AL_TRoiNode* pNext = pCur->pNext;
-    Rtos_Free(pCur);
-    pCur = pNext;
-  }
-
-  pCtx->pFirstNode = NULL;
-  pCtx->pLastNode = NULL;
+  // the arena is kept for the next regions
+  pCtx->iNumNodes = 0;
+  pCtx->bSorted = false;
 }
 
 /****************************************************************************/
@@ -301,24 +416,21 @@ bool AL_RoiMngr_AddROI(AL_TRoiMngrCtx* pCtx, int iPosX, int iPosY, int iWidth, i
   iWidth = RoundUp(iWidth, 1 << pCtx->uLcuSize) >> pCtx->uLcuSize;
   iHeight = RoundUp(iHeight, 1 << pCtx->uLcuSize) >> pCtx->uLcuSize;
 
-  AL_TRoiNode* pNode = (AL_TRoiNode*)Rtos_Malloc(sizeof(AL_TRoiNode));
-
-  if(!pNode)
+  if(!Grow((void**)&pCtx->pNodes, &pCtx->iMaxNodes, pCtx->iNumNodes + 1, sizeof(AL_TRoiNode)))
     return false;
 
+  AL_TRoiNode* pNode = &pCtx->pNodes[pCtx->iNumNodes];
+
   pNode->iPosX = iPosX;
   pNode->iPosY = iPosY;
   pNode->iWidth = ((iPosX + iWidth) > pCtx->iLcuWidth) ? (pCtx->iLcuWidth - iPosX) : iWidth;
   pNode->iHeight = ((iPosY + iHeight) > pCtx->iLcuHeight) ? (pCtx->iLcuHeight - iPosY) : iHeight;
 
   pNode->iDeltaQP = GetNewDeltaQP(eQuality);
-  pNode->pNext = NULL;
-  pNode->pPrev = NULL;
+  pNode->iOrder = pCtx->iNumNodes;
 
-  if(pCtx->eOrder == AL_ROI_QUALITY_ORDER)
-    Insert(pCtx, pNode);
-  else
-    PushBack(pCtx, pNode);
+  ++pCtx->iNumNodes;
+  pCtx->bSorted = false;
 
   return true;
 }
@@ -328,22 +440,78 @@ void AL_RoiMngr_FillBuff(AL_TRoiMngrCtx* pCtx, int iNumQPPerLCU, int iNumBytesPe
 {
   assert(pBuf);
 
-  // Fill background
-  for(int iLCU = 0; iLCU < pCtx->iNumLCUs; iLCU++)
-  {
-    int iFirst = iLCU * iNumBytesPerLCU;
+  AL_TRoiRect tAll = { 0, 0, pCtx->iLcuWidth, pCtx->iLcuHeight };
+  Paint(pCtx, iNumQPPerLCU, iNumBytesPerLCU, pBuf, &tAll);
+}
+
+/****************************************************************************/
+bool AL_RoiMngr_UpdateMap(AL_TRoiMngrCtx* pCtx, AL_TRoiRect* pDirty)
+{
+  assert(pDirty);
+  *pDirty = { 0, 0, 0, 0 };
 
-    for(int iQP = 0; iQP < iNumQPPerLCU; ++iQP)
-      pBuf[iFirst + iQP] = GetNewDeltaQP(pCtx->eBkgQuality);
+  AL_TRoiRect tBounds = { 0, 0, 0, 0 };
+
+  for(int iNode = 0; iNode < pCtx->iNumNodes; ++iNode)
+  {
+    AL_TRoiRect tNodeBounds = GetNodeBounds(pCtx, &pCtx->pNodes[iNode]);
+    Merge(&tBounds, &tNodeBounds);
   }
 
-  // Fill ROIs
-  AL_TRoiNode* pCur = pCtx->pFirstNode;
+  // outside the previous and the new ROIs both maps only hold the background
+  AL_TRoiRect tArea = tBounds;
+  Merge(&tArea, &pCtx->tMapBounds);
+  pCtx->tMapBounds = tBounds;
+
+  if(IsEmpty(&tArea))
+    return false;
+
+  // pNextMap matches pMap: repaint the area, the transitions only read background beyond it
+  Paint(pCtx, 1, 1, pCtx->pNextMap, &tArea);
+
+  int iLeft = pCtx->iLcuWidth;
+  int iRight = -1;
+  int iTop = -1;
+  int iBottom = -1;
 
-  while(pCur)
+  for(int h = 0; h < tArea.iHeight; ++h)
   {
-    ComputeROI(pCtx, iNumQPPerLCU, iNumBytesPerLCU, pBuf, pCur);
-    pCur = pCur->pNext;
+    int iRow = GetNodePosInBuf(pCtx, 0, tArea.iPosY + h, 1);
+    uint8_t const* pOld = pCtx->pMap + iRow;
+    uint8_t const* pNew = pCtx->pNextMap + iRow;
+
+    int iFirst = tArea.iPosX;
+    int iLast = tArea.iPosX + tArea.iWidth - 1;
+
+    if(!memcmp(pOld + iFirst, pNew + iFirst, tArea.iWidth))
+      continue;
+
+    while(pOld[iFirst] == pNew[iFirst])
+      ++iFirst;
+
+    while(pOld[iLast] == pNew[iLast])
+      --iLast;
+
+    iLeft = iFirst < iLeft ? iFirst : iLeft;
+    iRight = iLast > iRight ? iLast : iRight;
+
+    if(iTop < 0)
+      iTop = tArea.iPosY + h;
+    iBottom = tArea.iPosY + h;
   }
+
+  if(iTop < 0)
+    return false;
+
+  *pDirty = { iLeft, iTop, iRight - iLeft + 1, iBottom - iTop + 1 };
+  CopyRect(pCtx, pDirty, pCtx->pNextMap, pCtx->pMap);
+
+  return true;
 }
 
+/****************************************************************************/
+void AL_RoiMngr_CopyMap(AL_TRoiMngrCtx* pCtx, AL_TRoiRect const* pRect, uint8_t* pBuf)
+{
+  assert(pBuf);
+  CopyRect(pCtx, pRect, pCtx->pMap, pBuf);
+}
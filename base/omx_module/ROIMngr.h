@@ -60,15 +60,22 @@ typedef enum al_eRoiOrder
 
 struct AL_TRoiNode
 {
-  AL_TRoiNode* pPrev;
-  AL_TRoiNode* pNext;
-
   int iPosX;
   int iPosY;
   int iWidth;
   int iHeight;
 
   int8_t iDeltaQP;
+  int iOrder; // rank of AL_RoiMngr_AddROI, breaks quality ties
+};
+
+/* area in LCUs */
+struct AL_TRoiRect
+{
+  int iPosX;
+  int iPosY;
+  int iWidth;
+  int iHeight;
 };
 
 struct AL_TRoiMngrCtx
@@ -87,8 +94,16 @@ struct AL_TRoiMngrCtx
   AL_ERoiQuality eBkgQuality;
   AL_ERoiOrder eOrder;
 
-  AL_TRoiNode* pFirstNode;
-  AL_TRoiNode* pLastNode;
+  /* nodes arena, sorted in painting order before use */
+  AL_TRoiNode* pNodes;
+  int iNumNodes;
+  int iMaxNodes;
+  bool bSorted;
+
+  /* map of the last update, one QP per LCU, and the LCUs its ROIs may have touched */
+  uint8_t* pMap;
+  uint8_t* pNextMap;
+  AL_TRoiRect tMapBounds;
 };
 
 AL_TRoiMngrCtx* AL_RoiMngr_Create(int iPicWidth, int iPicHeight, AL_EProfile eProf, AL_ERoiQuality eBkgQuality, AL_ERoiOrder eOrder);
@@ -101,3 +116,8 @@ bool AL_RoiMngr_AddROI(AL_TRoiMngrCtx* pCtx, int iPosX, int iPosY, int iWidth, i
 
 void AL_RoiMngr_FillBuff(AL_TRoiMngrCtx* pCtx, int iNumQPPerLCU, int iNumBytesPerLCU, uint8_t* pBuf);
 
+/* Refresh pMap from the current ROIs and report the LCUs that changed (empty if none) */
+bool AL_RoiMngr_UpdateMap(AL_TRoiMngrCtx* pCtx, AL_TRoiRect* pDirty);
+
+void AL_RoiMngr_CopyMap(AL_TRoiMngrCtx* pCtx, AL_TRoiRect const* pRect, uint8_t* pBuf);
+
@@ -0,0 +1,72 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include "RoiMapHistory.h"
+#include <cassert>
+
+void RoiMapHistory::Update(AL_TRoiMngrCtx* ctx)
+{
+  AL_TRoiRect dirty;
+
+  if(!AL_RoiMngr_UpdateMap(ctx, &dirty))
+    return;
+
+  rects.push_back(dirty);
+
+  if(rects.size() > maxSize)
+    rects.pop_front();
+  ++generation;
+}
+
+bool RoiMapHistory::CanPatch(uint32_t mapGeneration) const
+{
+  return mapGeneration != 0 && generation - mapGeneration <= rects.size();
+}
+
+void RoiMapHistory::Patch(AL_TRoiMngrCtx* ctx, uint32_t mapGeneration, uint8_t* map) const
+{
+  assert(CanPatch(mapGeneration));
+
+  for(auto i = rects.size() - (generation - mapGeneration); i < rects.size(); ++i)
+    AL_RoiMngr_CopyMap(ctx, &rects[i], map);
+}
+
+void RoiMapHistory::Reset()
+{
+  rects.clear();
+  generation = 1;
+}
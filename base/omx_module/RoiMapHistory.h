@@ -0,0 +1,68 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+
+#include "ROIMngr.h"
+
+/* Recycled ROI buffers are only patched with the LCUs the map changed since they were written.
+ * A map is identified by its generation, 0 is never a valid one */
+struct RoiMapHistory
+{
+  explicit RoiMapHistory(size_t maxSize) : maxSize{maxSize} {}
+
+  /* refreshes the map of the context, a new generation starts if it changed */
+  void Update(AL_TRoiMngrCtx* ctx);
+
+  /* false when the map of that generation is too old to be patched: it needs a full copy */
+  bool CanPatch(uint32_t generation) const;
+
+  /* copies the LCUs changed since that generation to a map written then */
+  void Patch(AL_TRoiMngrCtx* ctx, uint32_t generation, uint8_t* map) const;
+
+  uint32_t Generation() const { return generation; }
+
+  void Reset();
+
+private:
+  size_t const maxSize;
+  std::deque<AL_TRoiRect> rects {};
+  uint32_t generation = 1;
+};
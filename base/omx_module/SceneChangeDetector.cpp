@@ -0,0 +1,222 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include "SceneChangeDetector.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+using namespace std;
+
+static int constexpr BLOCK_SIZE = 8;
+static int constexpr BLOCK_SHIFT = 6; // log2 of the number of pixels of a block
+static int constexpr HISTOGRAM_BINS = 64;
+static int constexpr HISTOGRAM_SHIFT = 2;
+
+/* thumbnail differences are in 1/16 of a luma level */
+static int constexpr DIFFERENCE_PRECISION = 16;
+/* under this mean difference the frames always belong to the same scene */
+static int constexpr MIN_DIFFERENCE = 10 * DIFFERENCE_PRECISION;
+/* a new scene is a jump of the difference against its running average */
+static int constexpr DIFFERENCE_RATIO = 3;
+/* percentage of the thumbnail that must have moved to another histogram bin */
+static int constexpr HISTOGRAM_THRESHOLD = 25;
+/* flashes and fades shouldn't start a new scene on every frame */
+static int constexpr MIN_SCENE_LENGTH = 4;
+
+static uint8_t ReduceBlock(uint8_t const* src, int pitch)
+{
+  int sum = 0;
+
+  for(int row = 0; row < BLOCK_SIZE; ++row)
+  {
+    for(int col = 0; col < BLOCK_SIZE; ++col)
+      sum += src[row * pitch + col];
+  }
+
+  return static_cast<uint8_t>(sum >> BLOCK_SHIFT);
+}
+
+/* Two blocks (16 pixels) at a time when SIMD is available */
+void SceneChangeDetector::ReduceBlockRow(uint8_t const* src, int pitch, int numBlocks, uint8_t* dst)
+{
+  int block = 0;
+
+#if defined(__SSE2__)
+  auto const zero = _mm_setzero_si128();
+
+  for(; block + 2 <= numBlocks; block += 2)
+  {
+    auto sum = _mm_setzero_si128();
+
+    for(int row = 0; row < BLOCK_SIZE; ++row)
+    {
+      auto pixels = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + row * pitch + block * BLOCK_SIZE));
+      sum = _mm_add_epi64(sum, _mm_sad_epu8(pixels, zero));
+    }
+
+    dst[block] = static_cast<uint8_t>(_mm_cvtsi128_si32(sum) >> BLOCK_SHIFT);
+    dst[block + 1] = static_cast<uint8_t>(_mm_cvtsi128_si32(_mm_srli_si128(sum, 8)) >> BLOCK_SHIFT);
+  }
+
+#elif defined(__ARM_NEON)
+
+  for(; block + 2 <= numBlocks; block += 2)
+  {
+    auto sum = vdupq_n_u16(0);
+
+    for(int row = 0; row < BLOCK_SIZE; ++row)
+      sum = vpadalq_u8(sum, vld1q_u8(src + row * pitch + block * BLOCK_SIZE));
+
+    auto blockSums = vpaddlq_u32(vpaddlq_u16(sum));
+    dst[block] = static_cast<uint8_t>(vgetq_lane_u64(blockSums, 0) >> BLOCK_SHIFT);
+    dst[block + 1] = static_cast<uint8_t>(vgetq_lane_u64(blockSums, 1) >> BLOCK_SHIFT);
+  }
+
+#endif
+
+  for(; block < numBlocks; ++block)
+    dst[block] = ReduceBlock(src + block * BLOCK_SIZE, pitch);
+}
+
+int64_t SceneChangeDetector::ComputeDifference(uint8_t const* a, uint8_t const* b, int size)
+{
+  int64_t difference = 0;
+  int i = 0;
+
+#if defined(__SSE2__)
+  auto sum = _mm_setzero_si128();
+
+  for(; i + 16 <= size; i += 16)
+  {
+    auto va = _mm_loadu_si128(reinterpret_cast<__m128i const*>(a + i));
+    auto vb = _mm_loadu_si128(reinterpret_cast<__m128i const*>(b + i));
+    sum = _mm_add_epi64(sum, _mm_sad_epu8(va, vb));
+  }
+
+  difference = _mm_cvtsi128_si32(sum) + _mm_cvtsi128_si32(_mm_srli_si128(sum, 8));
+
+#elif defined(__ARM_NEON)
+  auto sum = vdupq_n_u32(0);
+
+  for(; i + 16 <= size; i += 16)
+    sum = vpadalq_u16(sum, vpaddlq_u8(vabdq_u8(vld1q_u8(a + i), vld1q_u8(b + i))));
+
+  auto sum64 = vpaddlq_u32(sum);
+  difference = vgetq_lane_u64(sum64, 0) + vgetq_lane_u64(sum64, 1);
+
+#endif
+
+  for(; i < size; ++i)
+    difference += abs(a[i] - b[i]);
+
+  return difference;
+}
+
+SceneChangeDetector::SceneChangeDetector(int width, int height, int pitch) :
+  pitch{pitch},
+  thumbnailWidth{width / BLOCK_SIZE},
+  thumbnailHeight{height / BLOCK_SIZE},
+  thumbnail(thumbnailWidth * thumbnailHeight),
+  previousThumbnail(thumbnailWidth * thumbnailHeight),
+  histogram(HISTOGRAM_BINS),
+  previousHistogram(HISTOGRAM_BINS),
+  hasPrevious{false},
+  averageDifference{0},
+  framesSinceSceneChange{0}
+{
+  assert(pitch >= width);
+}
+
+void SceneChangeDetector::ComputeThumbnail(uint8_t const* luma)
+{
+  for(int row = 0; row < thumbnailHeight; ++row)
+    ReduceBlockRow(luma + row * BLOCK_SIZE * pitch, pitch, thumbnailWidth, &thumbnail[row * thumbnailWidth]);
+
+  fill(histogram.begin(), histogram.end(), 0);
+
+  for(auto level : thumbnail)
+    ++histogram[level >> HISTOGRAM_SHIFT];
+}
+
+bool SceneChangeDetector::IsSceneChange(uint8_t const* luma)
+{
+  if(thumbnail.empty())
+    return false;
+
+  swap(thumbnail, previousThumbnail);
+  swap(histogram, previousHistogram);
+  ComputeThumbnail(luma);
+
+  if(!hasPrevious)
+  {
+    hasPrevious = true;
+    return false;
+  }
+
+  ++framesSinceSceneChange;
+
+  int64_t const size = thumbnail.size();
+  auto difference = static_cast<int>(ComputeDifference(thumbnail.data(), previousThumbnail.data(), size) * DIFFERENCE_PRECISION / size);
+
+  int64_t moved = 0;
+
+  for(int bin = 0; bin < HISTOGRAM_BINS; ++bin)
+    moved += abs(histogram[bin] - previousHistogram[bin]);
+
+  // each block that moved is counted in its old and its new bin
+  auto histogramDistance = static_cast<int>(moved * 100 / (2 * size));
+
+  auto isSceneChange = framesSinceSceneChange >= MIN_SCENE_LENGTH &&
+                       difference > max(MIN_DIFFERENCE, DIFFERENCE_RATIO * averageDifference) &&
+                       histogramDistance > HISTOGRAM_THRESHOLD;
+
+  if(isSceneChange)
+    framesSinceSceneChange = 0;
+  else
+    averageDifference = (7 * averageDifference + difference) / 8;
+
+  return isSceneChange;
+}
+
@@ -0,0 +1,77 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/*
+** Software scene change detection on the luma of 8 bits source frames
+** Each frame is reduced to a thumbnail holding the mean of its 8x8 blocks.
+** A frame starts a new scene when the difference with the previous thumbnail jumps
+** above its running average and the histogram of the thumbnail changed too,
+** a fast motion moves the blocks but keeps the histogram.
+*/
+struct SceneChangeDetector
+{
+  SceneChangeDetector(int width, int height, int pitch);
+
+  /* Analyzes the next frame, returns true if it is the first frame of a new scene */
+  bool IsSceneChange(uint8_t const* luma);
+
+  /* Mean of each 8x8 block of a row of blocks, vectorized when SIMD is available */
+  static void ReduceBlockRow(uint8_t const* src, int pitch, int numBlocks, uint8_t* dst);
+
+  /* Sum of the absolute differences, vectorized when SIMD is available */
+  static int64_t ComputeDifference(uint8_t const* a, uint8_t const* b, int size);
+
+private:
+  int const pitch;
+  int const thumbnailWidth;
+  int const thumbnailHeight;
+  std::vector<uint8_t> thumbnail;
+  std::vector<uint8_t> previousThumbnail;
+  std::vector<int> histogram;
+  std::vector<int> previousHistogram;
+  bool hasPrevious;
+  int averageDifference;
+  int framesSinceSceneChange;
+
+  void ComputeThumbnail(uint8_t const* luma);
+};
+
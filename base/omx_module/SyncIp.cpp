@@ -45,9 +45,15 @@
 #include <stdexcept>
 #include <map>
 #include <algorithm>
+#include <cerrno>
+#include <cstring>
 
 extern "C"
 {
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
 /* needed definition for xvsfsync.h */
 #include <sys/ioctl.h>
 #define BIT(x) (1 << (x))
@@ -64,27 +70,21 @@ typedef uint64_t u64;
 
 using namespace std;
 
-struct sync_error : public std::runtime_error
-{
-  explicit sync_error(const char* msg) : std::runtime_error(msg)
-  {
-  }
-};
-
-struct sync_no_buf_slot_available : public sync_error
-{
-  explicit sync_no_buf_slot_available() : sync_error("Couldn't add buffer to the sync ip channel")
-  {
-  }
-};
-
 template<typename L>
 std::unique_lock<L> Lock(L& lockMe)
 {
   return std::unique_lock<L>(lockMe);
 }
 
-SyncIp::SyncIp(AL_TDriver* driver, char const* device) : driver{driver}
+/* only used when the driver file can't be waited on */
+static int constexpr POLL_TIMEOUT = 100;
+
+static u32 channelErrorMask(int chanId)
+{
+  return XVSFSYNC_CHX_SYNC_ERR_MASK(chanId) | XVSFSYNC_CHX_WDG_ERR_MASK(chanId);
+}
+
+SyncIp::SyncIp(AL_TDriver* driver, char const* device) : quit{false}, driver{driver}
 {
   fd = AL_Driver_Open(driver, device);
 
@@ -94,23 +94,87 @@ SyncIp::SyncIp(AL_TDriver* driver, char const* device) : driver{driver}
   struct xvsfsync_config config {};
 
   if(AL_Driver_PostMessage(driver, fd, XVSFSYNC_GET_CFG, &config) != DRIVER_SUCCESS)
+  {
+    closeFiles();
     throw runtime_error("Couldn't get sync ip configuration");
+  }
 
   Log("driver", "[fd: %d] mode: %s, channel number: %d\n", fd, config.encode ? "encode" : "decode", config.max_channels);
   maxChannels = config.max_channels;
   channelStatuses.resize(config.max_channels);
   eventListeners.resize(config.max_channels);
+  reserved.resize(config.max_channels);
+
+  for(int i = 0; i < maxChannels; ++i)
+    errorMask |= channelErrorMask(i);
+
+  wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  epollFd = epoll_create1(EPOLL_CLOEXEC);
+
+  struct epoll_event wake {};
+  wake.events = EPOLLIN;
+  wake.data.fd = wakeFd;
+
+  if(wakeFd == -1 || epollFd == -1 || epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &wake) == -1)
+  {
+    closeFiles();
+    throw runtime_error("Couldn't create the sync ip event loop");
+  }
+
+  /* the driver signals the errors on its file */
+  struct epoll_event error {};
+  error.events = EPOLLIN | EPOLLPRI;
+  error.data.fd = fd;
 
-  pollingThread = std::thread(&SyncIp::pollingRoutine, this);
+  if(epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &error) == 0)
+    eventThread = std::thread(&SyncIp::eventRoutine, this);
+  else
+  {
+    Log("driver", "Can't wait on the sync ip (%s), polling every %d ms\n", strerror(errno), POLL_TIMEOUT);
+    eventThread = std::thread(&SyncIp::pollingRoutine, this);
+  }
 }
 
 SyncIp::~SyncIp()
 {
   quit = true;
-  pollingThread.join();
+  uint64_t wake = 1;
+
+  if(write(wakeFd, &wake, sizeof(wake)) != sizeof(wake))
+    Log("driver", "Couldn't wake the sync ip event thread\n");
+
+  eventThread.join();
+  closeFiles();
+}
+
+/* the constructor can fail halfway: only what was opened is closed */
+void SyncIp::closeFiles()
+{
+  if(epollFd != -1)
+    close(epollFd);
+
+  if(wakeFd != -1)
+    close(wakeFd);
+
   AL_Driver_Close(driver, fd);
 }
 
+shared_ptr<SyncIp> SyncIp::Shared(AL_TDriver* driver, char const* device)
+{
+  static std::mutex sharedMutex;
+  static map<string, weak_ptr<SyncIp>> shared;
+
+  auto lock = Lock(sharedMutex);
+  auto syncIp = shared[device].lock();
+
+  if(!syncIp)
+  {
+    syncIp = make_shared<SyncIp>(driver, device);
+    shared[device] = syncIp;
+  }
+  return syncIp;
+}
+
 void SyncIp::getLatestChanStatus()
 {
   u32 chan_status;
@@ -120,15 +184,14 @@ void SyncIp::getLatestChanStatus()
   parseChanStatus(chan_status);
 }
 
-void SyncIp::resetStatus(int chanId)
+bool SyncIp::resetStatus(int chanId)
 {
   struct xvsfsync_clr_err clr;
   clr.channel_id = chanId;
   clr.sync_err = 1;
   clr.wdg_err = 1;
 
-  if(AL_Driver_PostMessage(driver, fd, XVSFSYNC_CLR_CHAN_ERR, &clr) != DRIVER_SUCCESS)
-    throw runtime_error("Couldnt reset status of channel " + to_string(chanId));
+  return AL_Driver_PostMessage(driver, fd, XVSFSYNC_CLR_CHAN_ERR, &clr) == DRIVER_SUCCESS;
 }
 
 int SyncIp::getFreeChannel()
@@ -142,18 +205,27 @@ int SyncIp::getFreeChannel()
    */
   for(int i = 0; i < maxChannels; i++)
   {
-    bool isAvailable = true;
+    bool isAvailable = !reserved[i];
 
     for(int j = 0; j < MAX_FB_NUMBER; ++j)
       isAvailable = isAvailable && channelStatuses[i].fbAvail[j];
 
     if(isAvailable)
+    {
+      reserved[i] = true;
       return i;
+    }
   }
 
   throw runtime_error("No channel available");
 }
 
+void SyncIp::releaseChannel(int chanId)
+{
+  auto lock = Lock(mutex);
+  reserved[chanId] = false;
+}
+
 void SyncIp::enableChannel(int chanId)
 {
   u8 chan = chanId;
@@ -170,58 +242,81 @@ void SyncIp::disableChannel(int chanId)
     throw runtime_error("Couldn't disable channel");
 }
 
-void SyncIp::addBuffer(struct xvsfsync_chan_config* fbConfig)
+bool SyncIp::addBuffer(struct xvsfsync_chan_config* fbConfig)
 {
-  if(AL_Driver_PostMessage(driver, fd, XVSFSYNC_SET_CHAN_CONFIG, fbConfig) != DRIVER_SUCCESS)
-    throw sync_no_buf_slot_available();
+  return AL_Driver_PostMessage(driver, fd, XVSFSYNC_SET_CHAN_CONFIG, fbConfig) == DRIVER_SUCCESS;
 }
 
-void SyncIp::pollErrors(int timeout)
+/* Only the channels in error are visited. Their errors are cleared even without
+ * a listener, the driver would signal them again otherwise.
+ * Runs on the event thread: driver failures are logged, the next event retries */
+void SyncIp::dispatchErrors()
 {
-  AL_EDriverError retCode = AL_Driver_PostMessage(driver, fd, AL_POLL_MSG, &timeout);
+  auto lock = Lock(mutex);
+  u32 status;
 
-  if(retCode == DRIVER_TIMEOUT)
+  if(AL_Driver_PostMessage(driver, fd, XVSFSYNC_GET_CHAN_STATUS, &status) != DRIVER_SUCCESS)
+  {
+    Log("driver", "Couldn't get sync ip channel status\n");
     return;
+  }
 
-  if(retCode != DRIVER_SUCCESS)
-    Log("driver", "Error while polling the errors. (driver error: %d)\n", retCode);
+  u32 errors = status & errorMask;
 
-  auto lock = Lock(mutex);
-  getLatestChanStatus();
-
-  for(size_t i = 0; i < channelStatuses.size(); ++i)
+  while(errors)
   {
-    ChannelStatus& status = channelStatuses[i];
+    int chanId = __builtin_ctz(errors) >> 3;
+    errors &= ~channelErrorMask(chanId);
+    parseChanStatus(status, chanId);
 
-    if(eventListeners[i] && (status.syncError || status.watchdogError))
-    {
-      eventListeners[i] (status);
-      resetStatus(i);
-    }
+    if(eventListeners[chanId])
+      eventListeners[chanId] (channelStatuses[chanId]);
+
+    if(!resetStatus(chanId))
+      Log("driver", "Couldn't reset status of channel %d\n", chanId);
   }
 }
 
-void SyncIp::pollingRoutine()
+void SyncIp::eventRoutine()
 {
-  while(true)
+  struct epoll_event events[2];
+
+  while(!quit)
   {
+    int numEvents = epoll_wait(epollFd, events, 2, -1);
+
+    if(numEvents == -1)
     {
-      Lock(mutex);
+      if(errno == EINTR)
+        continue;
 
-      if(quit)
-        break;
+      Log("driver", "Error while waiting for the errors (%s)\n", strerror(errno));
+      break;
     }
-    pollErrors(5000);
-  }
 
-  pollErrors(0);
+    for(int i = 0; i < numEvents; ++i)
+    {
+      if(events[i].data.fd == fd && !quit)
+        dispatchErrors();
+    }
+  }
 }
 
-template<typename T>
-void SyncIp::addListener(int chanId, T delegate)
+void SyncIp::pollingRoutine()
 {
-  auto lock = Lock(mutex);
-  eventListeners[chanId] = delegate;
+  while(!quit)
+  {
+    int timeout = POLL_TIMEOUT;
+    AL_EDriverError retCode = AL_Driver_PostMessage(driver, fd, AL_POLL_MSG, &timeout);
+
+    if(retCode == DRIVER_TIMEOUT)
+      continue;
+
+    if(retCode != DRIVER_SUCCESS)
+      Log("driver", "Error while polling the errors. (driver error: %d)\n", retCode);
+
+    dispatchErrors();
+  }
 }
 
 void SyncIp::removeListener(int chanId)
@@ -240,15 +335,18 @@ ChannelStatus & SyncIp::getStatus(int chanId)
 void SyncIp::parseChanStatus(u32 status)
 {
   for(int i = 0; i < maxChannels; ++i)
-  {
-    auto& chan = channelStatuses[i];
-    chan.fbAvail[0] = status & XVSFSYNC_CHX_FB0_MASK(i);
-    chan.fbAvail[1] = status & XVSFSYNC_CHX_FB1_MASK(i);
-    chan.fbAvail[2] = status & XVSFSYNC_CHX_FB2_MASK(i);
-    chan.enable = status & XVSFSYNC_CHX_ENB_MASK(i);
-    chan.syncError = status & XVSFSYNC_CHX_SYNC_ERR_MASK(i);
-    chan.watchdogError = status & XVSFSYNC_CHX_WDG_ERR_MASK(i);
-  }
+    parseChanStatus(status, i);
+}
+
+void SyncIp::parseChanStatus(u32 status, int chanId)
+{
+  auto& chan = channelStatuses[chanId];
+  chan.fbAvail[0] = status & XVSFSYNC_CHX_FB0_MASK(chanId);
+  chan.fbAvail[1] = status & XVSFSYNC_CHX_FB1_MASK(chanId);
+  chan.fbAvail[2] = status & XVSFSYNC_CHX_FB2_MASK(chanId);
+  chan.enable = status & XVSFSYNC_CHX_ENB_MASK(chanId);
+  chan.syncError = status & XVSFSYNC_CHX_SYNC_ERR_MASK(chanId);
+  chan.watchdogError = status & XVSFSYNC_CHX_WDG_ERR_MASK(chanId);
 }
 
 void printFrameBufferConfig(struct xvsfsync_chan_config const& config)
@@ -328,12 +426,13 @@ SyncChannel::~SyncChannel()
 
   while(!buffers.empty())
   {
-    auto& buf = buffers.front();
+    auto buf = buffers.front().buf;
     buffers.pop();
     AL_Buffer_Unref(buf);
   }
 
   sync->removeListener(id);
+  sync->releaseChannel(id);
 }
 
 void SyncChannel::addBuffer_(AL_TBuffer* buf, int numFbToEnable)
@@ -342,8 +441,12 @@ void SyncChannel::addBuffer_(AL_TBuffer* buf, int numFbToEnable)
   {
     /* we do not support adding buffer when the pipeline is running */
     assert(!isRunning);
+
+    /* the buffer is programmed with the same config each time it comes back */
+    unique_ptr<struct xvsfsync_chan_config> config(new xvsfsync_chan_config(setFrameBufferConfig(id, buf)));
+    printFrameBufferConfig(*config);
     AL_Buffer_Ref(buf);
-    buffers.push(buf);
+    buffers.push({ buf, move(config) });
   }
 
   /* If we don't want to start the ip yet, we do not program
@@ -358,25 +461,19 @@ void SyncChannel::addBuffer_(AL_TBuffer* buf, int numFbToEnable)
 
   while(isRunning && numFbToEnable > 0 && !buffers.empty())
   {
-    buf = buffers.front();
+    auto& frameBuffer = buffers.front();
 
-    auto config = setFrameBufferConfig(id, buf);
-    printFrameBufferConfig(config);
-
-    try
-    {
-      sync->addBuffer(&config);
-      Log("framebuffer", "Pushed buffer in sync ip\n");
-      printChannelStatus(sync->getStatus(id));
-      buffers.pop();
-    }
-    catch(sync_no_buf_slot_available const& error)
-    {
-      /* Will try again later */
+    /* no free slot in the ip, will try again on the next refill */
+    if(!sync->addBuffer(frameBuffer.config.get()))
       break;
-    }
 
-    buffers.push(buf);
+    Trace("framebuffer", "Pushed buffer in sync ip\n");
+#if AL_SYNCIP_TRACES
+    printChannelStatus(sync->getStatus(id));
+#endif
+
+    buffers.push(move(frameBuffer));
+    buffers.pop();
     --numFbToEnable;
   }
 }
@@ -43,8 +43,10 @@ extern "C"
 #include "lib_common/BufferAPI.h"
 }
 
+#include <atomic>
 #include <vector>
 #include <queue>
+#include <memory>
 #include <mutex>
 #include <thread>
 #include <functional>
@@ -58,14 +60,25 @@ struct ChannelStatus
   bool watchdogError;
 };
 
+/*
+** Errors of all the channels of a sync ip are handled by one event thread.
+** It sleeps until the driver signals an error or the sync ip is destroyed.
+*/
 struct SyncIp
 {
   SyncIp(AL_TDriver* driver, char const* device);
   ~SyncIp();
+
+  /* One sync ip per device for the whole process, it lives as long as a user holds it */
+  static std::shared_ptr<SyncIp> Shared(AL_TDriver* driver, char const* device);
+
+  /* The channel is reserved until it is released */
   int getFreeChannel();
+  void releaseChannel(int chanId);
   void enableChannel(int chanId);
   void disableChannel(int chanId);
-  void addBuffer(struct xvsfsync_chan_config* fbConfig);
+  /* false when the channel has no free framebuffer slot */
+  bool addBuffer(struct xvsfsync_chan_config* fbConfig);
 
   template<typename T>
   void addListener(int chanId, T delegate);
@@ -76,19 +89,34 @@ struct SyncIp
 private:
   void getLatestChanStatus();
   void parseChanStatus(uint32_t status);
-  void resetStatus(int chanId);
+  void parseChanStatus(uint32_t status, int chanId);
+  bool resetStatus(int chanId);
+  void closeFiles();
   int fd = -1;
-  bool quit = false;
-  std::thread pollingThread;
+  int wakeFd = -1;
+  int epollFd = -1;
+  uint32_t errorMask = 0;
+  std::atomic<bool> quit;
+  std::thread eventThread;
+  void eventRoutine();
   void pollingRoutine();
-  void pollErrors(int timeout);
+  void dispatchErrors();
 
   AL_TDriver* driver;
   std::mutex mutex {};
   std::vector<std::function<void(ChannelStatus &)>> eventListeners {};
   std::vector<ChannelStatus> channelStatuses {};
+  std::vector<bool> reserved {};
 };
 
+/* The delegate is called on the event thread, with the sync ip locked */
+template<typename T>
+void SyncIp::addListener(int chanId, T delegate)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  eventListeners[chanId] = delegate;
+}
+
 struct SyncChannel
 {
   SyncChannel(SyncIp* sync, int id);
@@ -100,8 +128,14 @@ struct SyncChannel
   int id;
 
 private:
+  struct FrameBuffer
+  {
+    AL_TBuffer* buf;
+    std::unique_ptr<struct xvsfsync_chan_config> config;
+  };
+
   bool enabled = false;
-  std::queue<AL_TBuffer*> buffers {};
+  std::queue<FrameBuffer> buffers;
   std::mutex mutex {};
   SyncIp* sync;
   bool isRunning = false;
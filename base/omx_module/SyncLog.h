@@ -45,6 +45,13 @@ extern std::map<std::string, bool> g_Categories;
   if(g_Categories[category]) \
     printf(__VA_ARGS__);
 
+/* traces of the per frame path, only built with ENABLE_SYNCIP_TRACES=1 */
+#if AL_SYNCIP_TRACES
+#define Trace(category, ...) Log(category, __VA_ARGS__)
+#else
+#define Trace(category, ...) ((void)0)
+#endif
+
 void printChannelStatus(ChannelStatus const& status);
 void printChannelStatus(int channelId, ChannelStatus const& status);
 void printAllChannelStatuses(SyncIp* syncIp);
@@ -40,10 +40,20 @@
 #include <algorithm>
 #include <cassert>
 #include <iostream>
+#include <limits>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #define SEQUENCE_SIZE_MAX 1000
 #define LOCAL_RANGE 5
 
+static char const TWOPASS_LOG_MAGIC[4] = { 'A', 'L', 'T', 'P' };
+static uint32_t const TWOPASS_LOG_VERSION = 1;
+static uint32_t const TWOPASS_LOG_CHECKSUM_BASIS = 2166136261u;
+
 using namespace std;
 
 /***************************************************************************/
@@ -109,14 +119,33 @@ int32_t AL_TwoPassMngr_GetIPRatio(AL_TBuffer* pCurrentSrc, AL_TBuffer* pNextSrc)
   return GetIPRatio(pCurrentMeta, pNextMeta);
 }
 
+/***************************************************************************/
+bool AL_TwoPassMngr_SceneChangeDetected(AL_TLookAheadMetaData* pPrevMeta, AL_TLookAheadMetaData* pCurrentMeta)
+{
+  return SceneChangeDetected(pPrevMeta, pCurrentMeta);
+}
+
+/***************************************************************************/
+int32_t AL_TwoPassMngr_GetIPRatio(AL_TLookAheadMetaData* pCurrentMeta, AL_TLookAheadMetaData* pNextMeta)
+{
+  return GetIPRatio(pCurrentMeta, pNextMeta);
+}
+
 /***************************************************************************/
 /*Offline TwoPass methods*/
 /***************************************************************************/
-TwoPassMngr::TwoPassMngr(string p_FileName, int p_iPass)
+TwoPassMngr::TwoPassMngr(string p_FileName, int p_iPass, TwoPassLogFormat p_eFormat)
 {
   FileName = p_FileName;
   iPass = p_iPass;
+  eFormat = p_eFormat;
   iCurrentFrame = 0;
+  iLogFrame = 0;
+  uChecksum = 0;
+  uNumFrames = 0;
+  uRecordSize = sizeof(TwoPassLogRecord);
+  pMapping = nullptr;
+  zMappingSize = 0;
   tFrames.clear();
   OpenLog();
 }
@@ -128,31 +157,157 @@ TwoPassMngr::~TwoPassMngr()
   CloseLog();
 }
 
+/***************************************************************************/
+static uint32_t UpdateChecksum(uint32_t uChecksum, void const* pData, size_t zSize)
+{
+  // FNV-1a
+  auto pBytes = static_cast<uint8_t const*>(pData);
+
+  for(size_t i = 0; i < zSize; i++)
+    uChecksum = (uChecksum ^ pBytes[i]) * 16777619u;
+
+  return uChecksum;
+}
+
+/***************************************************************************/
+static bool IsBinaryLog(string const& FileName)
+{
+  char sMagic[sizeof(TWOPASS_LOG_MAGIC)];
+  ifstream file(FileName, ios::binary);
+
+  if(!file.read(sMagic, sizeof(sMagic)))
+    return false;
+
+  return memcmp(sMagic, TWOPASS_LOG_MAGIC, sizeof(sMagic)) == 0;
+}
+
 /***************************************************************************/
 void TwoPassMngr::OpenLog()
 {
   if(iPass == 1)
-    outputFile.open(FileName);
+  {
+    if(eFormat == TWOPASS_LOG_TEXT)
+    {
+      outputFile.open(FileName);
+      return;
+    }
+
+    outputFile.open(FileName, ios::binary);
+    uChecksum = TWOPASS_LOG_CHECKSUM_BASIS;
+    uNumFrames = 0;
+    WriteBinaryHeader();
+  }
 
   if(iPass == 2)
-    inputFile.open(FileName);
+  {
+    eFormat = IsBinaryLog(FileName) ? TWOPASS_LOG_BINARY : TWOPASS_LOG_TEXT;
+
+    if(eFormat == TWOPASS_LOG_BINARY)
+      OpenBinaryLog();
+    else
+      inputFile.open(FileName);
+  }
+}
+
+/***************************************************************************/
+static char const* CheckBinaryLog(TwoPassLogHeader const& tHeader, uint8_t const* pRecords, size_t zRecordsSize)
+{
+  if(tHeader.uVersion != TWOPASS_LOG_VERSION || tHeader.uRecordSize < sizeof(TwoPassLogRecord))
+    return "[Pass 2] : Unsupported TwoPass LogFile version";
+
+  if(zRecordsSize != static_cast<size_t>(tHeader.uNumFrames) * tHeader.uRecordSize)
+    return "[Pass 2] : Incomplete TwoPass LogFile, pass 1 wasn't closed";
+
+  if(UpdateChecksum(TWOPASS_LOG_CHECKSUM_BASIS, pRecords, zRecordsSize) != tHeader.uChecksum)
+    return "[Pass 2] : Corrupted TwoPass LogFile";
+
+  return nullptr;
+}
+
+/***************************************************************************/
+void TwoPassMngr::OpenBinaryLog()
+{
+  auto fd = open(FileName.c_str(), O_RDONLY);
+
+  if(fd < 0)
+    throw runtime_error("Can't open TwoPass LogFile");
+
+  struct stat tStat;
+
+  if(fstat(fd, &tStat) != 0 || static_cast<size_t>(tStat.st_size) < sizeof(TwoPassLogHeader))
+  {
+    close(fd);
+    throw runtime_error("[Pass 2] : Truncated TwoPass LogFile");
+  }
+
+  zMappingSize = tStat.st_size;
+  auto pData = mmap(nullptr, zMappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+
+  if(pData == MAP_FAILED)
+  {
+    zMappingSize = 0;
+    throw runtime_error("Can't map TwoPass LogFile");
+  }
+
+  pMapping = static_cast<uint8_t*>(pData);
+
+  TwoPassLogHeader tHeader;
+  memcpy(&tHeader, pMapping, sizeof(tHeader));
+  auto sError = CheckBinaryLog(tHeader, pMapping + sizeof(TwoPassLogHeader), zMappingSize - sizeof(TwoPassLogHeader));
+
+  if(sError)
+  {
+    CloseLog();
+    throw runtime_error(sError);
+  }
+
+  uNumFrames = tHeader.uNumFrames;
+  uRecordSize = tHeader.uRecordSize;
+}
+
+/***************************************************************************/
+void TwoPassMngr::WriteBinaryHeader()
+{
+  TwoPassLogHeader tHeader {};
+  memcpy(tHeader.sMagic, TWOPASS_LOG_MAGIC, sizeof(tHeader.sMagic));
+  tHeader.uVersion = TWOPASS_LOG_VERSION;
+  tHeader.uRecordSize = sizeof(TwoPassLogRecord);
+  tHeader.uNumFrames = uNumFrames;
+  tHeader.uChecksum = uChecksum;
+
+  outputFile.seekp(0);
+  outputFile.write(reinterpret_cast<char const*>(&tHeader), sizeof(tHeader));
+  outputFile.seekp(0, ios::end);
 }
 
 /***************************************************************************/
 void TwoPassMngr::CloseLog()
 {
+  if(outputFile.is_open() && eFormat == TWOPASS_LOG_BINARY)
+    WriteBinaryHeader();
+
+  if(pMapping)
+    munmap(pMapping, zMappingSize);
+
+  pMapping = nullptr;
+  zMappingSize = 0;
   inputFile.close();
   outputFile.close();
 }
 
 /***************************************************************************/
-void TwoPassMngr::EmptyLog()
+TwoPassLogRecord const* TwoPassMngr::GetRecord(int iFrame) const
+{
+  return reinterpret_cast<TwoPassLogRecord const*>(pMapping + sizeof(TwoPassLogHeader) + static_cast<size_t>(iFrame) * uRecordSize);
+}
+
+/***************************************************************************/
+void TwoPassMngr::ReadTextLog()
 {
   if(!inputFile.is_open())
     throw runtime_error("Can't open TwoPass LogFile");
 
-  tFrames.clear();
-
   char sLine[256];
   bool bFind = true;
   int i = 0;
@@ -174,7 +329,39 @@ void TwoPassMngr::EmptyLog()
     i++;
   }
 
-  ComputeTwoPass();
+  iLogFrame += i;
+}
+
+/***************************************************************************/
+void TwoPassMngr::ReadBinaryLog()
+{
+  if(!pMapping)
+    throw runtime_error("Can't open TwoPass LogFile");
+
+  auto iNumFrames = min(SEQUENCE_SIZE_MAX, static_cast<int>(uNumFrames) - iLogFrame);
+
+  for(int i = 0; i < iNumFrames; i++)
+  {
+    TwoPassLogRecord tRecord;
+    memcpy(&tRecord, GetRecord(iLogFrame + i), sizeof(tRecord));
+    AddNewFrame(tRecord.iPictureSize, tRecord.iPercentIntra, tRecord.iPercentSkip);
+  }
+
+  iLogFrame += max(iNumFrames, 0);
+}
+
+/***************************************************************************/
+void TwoPassMngr::EmptyLog()
+{
+  tFrames.clear();
+
+  if(eFormat == TWOPASS_LOG_BINARY)
+    ReadBinaryLog();
+  else
+    ReadTextLog();
+
+  if(!tFrames.empty())
+    ComputeTwoPass();
 }
 
 /***************************************************************************/
@@ -183,12 +370,82 @@ void TwoPassMngr::FillLog()
   if(!outputFile.is_open())
     throw runtime_error("Can't open TwoPass LogFile");
 
-  for(auto frame: tFrames)
-    outputFile << frame.iPictureSize << " " << static_cast<int>(frame.iPercentIntra) << " " << static_cast<int>(frame.iPercentSkip) << endl;
+  if(eFormat == TWOPASS_LOG_TEXT)
+  {
+    for(auto const& frame: tFrames)
+      outputFile << frame.iPictureSize << " " << static_cast<int>(frame.iPercentIntra) << " " << static_cast<int>(frame.iPercentSkip) << "\n";
+
+    tFrames.clear();
+    return;
+  }
+
+  tRecords.clear();
+
+  for(auto const& frame: tFrames)
+    tRecords.push_back({ frame.iPictureSize, frame.iPercentIntra, frame.iPercentSkip });
+
+  auto zSize = tRecords.size() * sizeof(TwoPassLogRecord);
+  outputFile.write(reinterpret_cast<char const*>(tRecords.data()), zSize);
+  uChecksum = UpdateChecksum(uChecksum, tRecords.data(), zSize);
+  uNumFrames += tRecords.size();
 
   tFrames.clear();
 }
 
+/***************************************************************************/
+int TwoPassMngr::GetNumFrames()
+{
+  if(eFormat == TWOPASS_LOG_BINARY)
+    return uNumFrames;
+
+  if(!inputFile.is_open())
+    throw runtime_error("Can't open TwoPass LogFile");
+
+  // the text format has no index, count the lines and come back
+  inputFile.clear();
+  auto tPosition = inputFile.tellg();
+  inputFile.seekg(0);
+
+  int iNumFrames = 0;
+  string sLine;
+
+  while(getline(inputFile, sLine) && !sLine.empty())
+    iNumFrames++;
+
+  inputFile.clear();
+  inputFile.seekg(tPosition);
+  return iNumFrames;
+}
+
+/***************************************************************************/
+void TwoPassMngr::SeekFrame(int iFrame)
+{
+  if(iFrame < 0)
+    throw runtime_error("[Pass 2] : Frame out of the pass 1 Logfile");
+
+  // the second pass is computed per sequence, start from the sequence of the frame so the results match a sequential read
+  auto iSequenceStart = iFrame - iFrame % SEQUENCE_SIZE_MAX;
+
+  if(eFormat == TWOPASS_LOG_TEXT)
+  {
+    if(!inputFile.is_open())
+      throw runtime_error("Can't open TwoPass LogFile");
+
+    inputFile.clear();
+    inputFile.seekg(0);
+
+    for(int i = 0; i < iSequenceStart; i++)
+      inputFile.ignore(numeric_limits<streamsize>::max(), '\n');
+  }
+
+  iLogFrame = iSequenceStart;
+  EmptyLog();
+  iCurrentFrame = iFrame - iSequenceStart;
+
+  if(iCurrentFrame >= static_cast<int>(tFrames.size()))
+    throw runtime_error("[Pass 2] : Frame out of the pass 1 Logfile");
+}
+
 /***************************************************************************/
 void TwoPassMngr::AddNewFrame(int iPictureSize, int iPercentIntra, int iPercentSkip)
 {
@@ -269,16 +526,11 @@ void TwoPassMngr::ComputeTwoPass()
 }
 
 /***************************************************************************/
-static int GetLocalComplexity(vector<AL_TLookAheadMetaData> tFrames, int iLocalIndex, int iIndexMax, size_t zPicSizeMoy)
+static int GetLocalComplexity(size_t zSumLocal, int iLocalSize, size_t zPicSizeMoy)
 {
-  if(iIndexMax - iLocalIndex < LOCAL_RANGE)
+  if(iLocalSize < LOCAL_RANGE || !zPicSizeMoy)
     return 1000;
 
-  size_t zSumLocal = 0;
-
-  for(int k = 0; k < LOCAL_RANGE; k++)
-    zSumLocal += tFrames[iLocalIndex + k].iPictureSize;
-
   return 1000 * (zSumLocal / LOCAL_RANGE) / zPicSizeMoy;
 }
 
@@ -291,18 +543,23 @@ void TwoPassMngr::ComputeComplexity()
 
   size_t zSumPicSize = 0;
 
-  for(auto frame: tFrames)
+  for(auto const& frame: tFrames)
     zSumPicSize += frame.iPictureSize;
 
   auto zPicSizeMoy = zSumPicSize / iSequenceSize;
 
-  int iComplexity = 1000;
-
-  for(int k = 0; k < iSequenceSize; k++)
+  // every LOCAL_RANGE frames share the complexity of their window, a truncated last window is neutral
+  for(int iLocalIndex = 0; iLocalIndex < iSequenceSize; iLocalIndex += LOCAL_RANGE)
   {
-    if(k % LOCAL_RANGE == 0)
-      iComplexity = GetLocalComplexity(tFrames, k, iSequenceSize, zPicSizeMoy);
-    tFrames[k].iComplexity = iComplexity;
+    auto iLocalEnd = min(iLocalIndex + LOCAL_RANGE, iSequenceSize);
+    size_t zSumLocal = 0;
+
+    for(int k = iLocalIndex; k < iLocalEnd; k++)
+      zSumLocal += tFrames[k].iPictureSize;
+
+    auto iComplexity = GetLocalComplexity(zSumLocal, iLocalEnd - iLocalIndex, zPicSizeMoy);
+
+    for(int k = iLocalIndex; k < iLocalEnd; k++)
+      tFrames[k].iComplexity = iComplexity;
   }
 }
-
@@ -39,7 +39,9 @@
 
 #include <fstream>
 #include <vector>
+#include <string>
 #include <cstring>
+#include <cstdint>
 
 extern "C"
 {
@@ -60,18 +62,50 @@ bool AL_TwoPassMngr_SceneChangeDetected(AL_TBuffer* pPrevSrc, AL_TBuffer* pCurre
 *****************************************************************************/
 int32_t AL_TwoPassMngr_GetIPRatio(AL_TBuffer* pCurrentSrc, AL_TBuffer* pNextSrc);
 
+/* Same as above on the lookahead metadata of the frames */
+bool AL_TwoPassMngr_SceneChangeDetected(AL_TLookAheadMetaData* pPrevMeta, AL_TLookAheadMetaData* pCurrentMeta);
+int32_t AL_TwoPassMngr_GetIPRatio(AL_TLookAheadMetaData* pCurrentMeta, AL_TLookAheadMetaData* pNextMeta);
+
 /***************************************************************************/
 /*Offline TwoPass structures and methods*/
 /***************************************************************************/
 
+/*
+** Binary logfile: a header followed by one fixed size record per frame
+** The frame count and the checksum are written when the first pass closes the logfile
+*/
+struct TwoPassLogHeader
+{
+  char sMagic[4];
+  uint32_t uVersion;
+  uint32_t uRecordSize;
+  uint32_t uNumFrames;
+  uint32_t uChecksum;
+  uint32_t uReserved;
+};
+
+struct TwoPassLogRecord
+{
+  int32_t iPictureSize;
+  int32_t iPercentIntra;
+  int32_t iPercentSkip;
+};
+
+enum TwoPassLogFormat
+{
+  TWOPASS_LOG_TEXT,
+  TWOPASS_LOG_BINARY,
+};
+
 /*
 ** Struct for TwoPass management
 ** Writes First Pass informations on the logfile
 ** Reads and computes the logfile for the Second Pass
+** The Second Pass detects the logfile format, the text format is still supported
 */
 struct TwoPassMngr
 {
-  TwoPassMngr(std::string p_FileName, int p_iPass);
+  TwoPassMngr(std::string p_FileName, int p_iPass, TwoPassLogFormat p_eFormat = TWOPASS_LOG_BINARY);
   ~TwoPassMngr();
 
   void OpenLog();
@@ -86,11 +120,31 @@ struct TwoPassMngr
   void ComputeTwoPass();
   void ComputeComplexity();
 
+  /* Second Pass: number of frames in the logfile and random access, the next GetFrame returns iFrame */
+  int GetNumFrames();
+  void SeekFrame(int iFrame);
+
   int iPass;
   std::string FileName;
+  TwoPassLogFormat eFormat;
   std::vector<AL_TLookAheadMetaData> tFrames;
   int iCurrentFrame;
+  int iLogFrame;
   std::ofstream outputFile;
   std::ifstream inputFile;
+
+  uint32_t uChecksum;
+  uint32_t uNumFrames;
+  uint32_t uRecordSize;
+  std::vector<TwoPassLogRecord> tRecords;
+  uint8_t* pMapping;
+  size_t zMappingSize;
+
+private:
+  void OpenBinaryLog();
+  void ReadTextLog();
+  void ReadBinaryLog();
+  void WriteBinaryHeader();
+  TwoPassLogRecord const* GetRecord(int iFrame) const;
 };
 
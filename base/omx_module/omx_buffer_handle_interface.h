@@ -47,6 +47,9 @@ struct BufferHandleInterface
   int offset = 0;
   int payload = 0;
 
+  /* index of the bookkeeping of the module that uses the buffer */
+  int slot = -1;
+
 protected:
   BufferHandleInterface(char* data, int size) : data(data), size(size) {}
   BufferHandleInterface() : data(nullptr), size(0) {}
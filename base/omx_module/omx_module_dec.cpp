@@ -51,6 +51,7 @@ extern "C"
 #include "base/omx_mediatype/omx_convert_module_soft.h"
 #include "base/omx_mediatype/omx_convert_module_soft_dec.h"
 #include "base/omx_utils/round.h"
+#include "base/omx_utils/parallel_copy.h"
 
 using namespace std;
 
@@ -191,11 +192,10 @@ void DecModule::ReleaseBufs(AL_TBuffer* frame)
 
 void DecModule::CopyIfRequired(AL_TBuffer* frameToDisplay, int size)
 {
-  if(shouldBeCopied.Exist(frameToDisplay))
-  {
-    auto buffer = shouldBeCopied.Get(frameToDisplay);
-    copy(AL_Buffer_GetData(frameToDisplay), AL_Buffer_GetData(frameToDisplay) + size, buffer);
-  }
+  char* buffer = nullptr;
+
+  if(shouldBeCopied.TryGet(frameToDisplay, buffer))
+    ParallelCopy(reinterpret_cast<uint8_t*>(buffer), AL_Buffer_GetData(frameToDisplay), size);
 }
 
 void DecModule::Display(AL_TBuffer* frameToDisplay, AL_TInfoDecode* info)
@@ -234,7 +234,7 @@ void DecModule::Display(AL_TBuffer* frameToDisplay, AL_TInfoDecode* info)
     return;
   }
 
-  auto size = GetBufferRequirements().output.size;
+  auto size = GetGeometry().outputSize;
   CopyIfRequired(frameToDisplay, size);
   currentDisplayPictureType = info->ePicStruct;
   auto rhandleOut = handlesOut.Pop(frameToDisplay);
@@ -255,6 +255,7 @@ void DecModule::ResolutionFound(int bufferNumber, int bufferSize, AL_TStreamSett
 
   media->stride = (int)RoundUp(AL_Decoder_GetMinPitch(settings.tDim.iWidth, settings.iBitDepth, media->settings.eFBStorageMode), strideAlignment.widthStride);
   media->sliceHeight = (int)RoundUp(AL_Decoder_GetMinStrideHeight(settings.tDim.iHeight), strideAlignment.heightStride);
+  UpdateGeometry();
 
   callbacks.event(CALLBACK_EVENT_RESOLUTION_CHANGE, nullptr);
 }
@@ -267,6 +268,13 @@ ErrorType DecModule::CreateDecoder(bool shouldPrealloc)
     return ERROR_UNDEFINED;
   }
 
+  UpdateGeometry();
+
+  auto requirements = GetBufferRequirements();
+  handlesIn.Reserve(static_cast<size_t>(requirements.input.min));
+  handlesOut.Reserve(static_cast<size_t>(requirements.output.min));
+  dpb.Reserve(static_cast<size_t>(requirements.output.min));
+
   channel = device->Init(*allocator.get());
   AL_TDecCallBacks decCallbacks {};
   decCallbacks.endDecodingCB = { RedirectionEndDecoding, this };
@@ -339,18 +347,18 @@ void DecModule::Free(void* buffer)
   if(!buffer)
     return;
 
-  if(dpb.Exist((char*)buffer))
+  AL_TBuffer* output = nullptr;
+
+  if(dpb.TryPop((char*)buffer, output))
   {
-    auto handle = dpb.Pop((char*)buffer);
-    assert(!handlesOut.Exist(handle));
-    AL_Buffer_Unref(handle);
+    assert(!handlesOut.Exist(output));
+    AL_Buffer_Unref(output);
   }
 
-  if(allocated.Exist(buffer))
-  {
-    auto handle = allocated.Pop(buffer);
+  AL_HANDLE handle = nullptr;
+
+  if(allocated.TryPop(buffer, handle))
     AL_Allocator_Free(allocator.get(), handle);
-  }
 }
 
 void DecModule::FreeDMA(int fd)
@@ -360,16 +368,18 @@ void DecModule::FreeDMA(int fd)
 
   auto buffer = (char*)((intptr_t)fd);
 
-  if(dpb.Exist(buffer))
+  AL_TBuffer* output = nullptr;
+
+  if(dpb.TryPop(buffer, output))
   {
-    auto handle = dpb.Pop(buffer);
-    assert(!handlesOut.Exist(handle));
-    AL_Buffer_Unref(handle);
+    assert(!handlesOut.Exist(output));
+    AL_Buffer_Unref(output);
   }
 
-  if(allocatedDMA.Exist(fd))
+  AL_HANDLE handle = nullptr;
+
+  if(allocatedDMA.TryPop(fd, handle))
   {
-    auto handle = allocatedDMA.Pop(fd);
     AL_Allocator_Free(allocator.get(), handle);
     close(fd);
   }
@@ -438,10 +448,7 @@ AL_TBuffer* DecModule::CreateInputBuffer(char* buffer, int size)
 {
   AL_TBuffer* input = nullptr;
 
-  BufferHandles bufferHandles {};
-  media->Get(SETTINGS_INDEX_BUFFER_HANDLES, &bufferHandles);
-
-  if(bufferHandles.input == BufferHandleType::BUFFER_HANDLE_FD)
+  if(GetGeometry().bufferHandles.input == BufferHandleType::BUFFER_HANDLE_FD)
   {
     auto fd = static_cast<int>((intptr_t)buffer);
 
@@ -460,8 +467,10 @@ AL_TBuffer* DecModule::CreateInputBuffer(char* buffer, int size)
   }
   else
   {
-    if(allocated.Exist(buffer))
-      input = AL_Buffer_Create(allocator.get(), allocated.Get(buffer), size, RedirectionInputBufferDestroy);
+    AL_HANDLE handle = nullptr;
+
+    if(allocated.TryGet(buffer, handle))
+      input = AL_Buffer_Create(allocator.get(), handle, size, RedirectionInputBufferDestroy);
     else
       input = AL_Buffer_WrapData((uint8_t*)buffer, size, RedirectionInputBufferDestroy);
   }
@@ -503,15 +512,52 @@ bool DecModule::Empty(BufferHandleInterface* handle)
   return pushed;
 }
 
-static AL_TMetaData* CreateSourceMeta(AL_TStreamSettings const& streamSettings, Resolution resolution)
+void DecModule::UpdateGeometry()
+{
+  lock_guard<mutex> lock(geometryMutex);
+  _UpdateGeometry();
+}
+
+StreamGeometry DecModule::GetGeometry()
+{
+  lock_guard<mutex> lock(geometryMutex);
+  return geometry;
+}
+
+/* the client can pick other strides when it reconfigures the port after a resolution change */
+StreamGeometry DecModule::GetOutputGeometry()
+{
+  lock_guard<mutex> lock(geometryMutex);
+
+  if(geometry.stride != media->stride || geometry.sliceHeight != media->sliceHeight)
+    _UpdateGeometry();
+
+  return geometry;
+}
+
+void DecModule::_UpdateGeometry()
 {
+  auto streamSettings = media->settings.tStream;
+  Resolution resolution {};
+  media->Get(SETTINGS_INDEX_RESOLUTION, &resolution);
+
   auto picFormat = AL_GetDecPicFormat(streamSettings.eChroma, static_cast<uint8_t>(streamSettings.iBitDepth), AL_FB_RASTER, false);
-  auto fourCC = AL_GetDecFourCC(picFormat);
   auto stride = resolution.stride.widthStride;
   auto sliceHeight = resolution.stride.heightStride;
-  AL_TPitches const pitches = { stride, stride };
-  AL_TOffsetYC const offsetYC = { 0, stride * sliceHeight };
-  return (AL_TMetaData*)(AL_SrcMetaData_Create({ resolution.width, resolution.height }, pitches, offsetYC, fourCC));
+
+  geometry.stride = media->stride;
+  geometry.sliceHeight = media->sliceHeight;
+  geometry.outputSize = GetBufferRequirements().output.size;
+  media->Get(SETTINGS_INDEX_BUFFER_HANDLES, &geometry.bufferHandles);
+  geometry.dimension = { resolution.width, resolution.height };
+  geometry.pitches = { stride, stride };
+  geometry.offsetYC = { 0, stride * sliceHeight };
+  geometry.fourCC = AL_GetDecFourCC(picFormat);
+}
+
+static AL_TMetaData* CreateSourceMeta(StreamGeometry const& geometry)
+{
+  return (AL_TMetaData*)(AL_SrcMetaData_Create(geometry.dimension, geometry.pitches, geometry.offsetYC, geometry.fourCC));
 }
 
 void DecModule::OutputBufferDestroy(AL_TBuffer* output)
@@ -534,19 +580,15 @@ void DecModule::OutputBufferDestroyAndFree(AL_TBuffer* output)
 
 AL_TBuffer* DecModule::CreateOutputBuffer(char* buffer, int size)
 {
-  Resolution resolution {};
-  media->Get(SETTINGS_INDEX_RESOLUTION, &resolution);
-  auto sourceMeta = CreateSourceMeta(media->settings.tStream, resolution);
+  auto outputGeometry = GetOutputGeometry();
+  auto sourceMeta = CreateSourceMeta(outputGeometry);
 
   if(!sourceMeta)
     return nullptr;
 
   AL_TBuffer* output = nullptr;
 
-  BufferHandles bufferHandles {};
-  media->Get(SETTINGS_INDEX_BUFFER_HANDLES, &bufferHandles);
-
-  if(bufferHandles.output == BufferHandleType::BUFFER_HANDLE_FD)
+  if(outputGeometry.bufferHandles.output == BufferHandleType::BUFFER_HANDLE_FD)
   {
     auto fd = static_cast<int>((intptr_t)buffer);
 
@@ -566,8 +608,10 @@ AL_TBuffer* DecModule::CreateOutputBuffer(char* buffer, int size)
   }
   else
   {
-    if(allocated.Exist(buffer))
-      output = AL_Buffer_Create(allocator.get(), allocated.Get(buffer), size, RedirectionOutputBufferDestroy);
+    AL_HANDLE handle = nullptr;
+
+    if(allocated.TryGet(buffer, handle))
+      output = AL_Buffer_Create(allocator.get(), handle, size, RedirectionOutputBufferDestroy);
     else
     {
       output = AL_Buffer_Create_And_Allocate(allocator.get(), size, RedirectionOutputBufferDestroyAndFree);
@@ -600,7 +644,10 @@ bool DecModule::Fill(BufferHandleInterface* handle)
 
   auto buffer = handle->data;
 
-  auto output = dpb.Exist(buffer) ? dpb.Get(buffer) : CreateOutputBuffer(buffer, handle->size);
+  AL_TBuffer* output = nullptr;
+
+  if(!dpb.TryGet(buffer, output))
+    output = CreateOutputBuffer(buffer, handle->size);
 
   if(!output)
     return false;
@@ -651,12 +698,11 @@ bool DecModule::Flush()
 
 void DecModule::FlushEosHandles()
 {
-  auto rhandleOut = handlesOut.Get(eosHandles.output);
+  auto rhandleOut = handlesOut.Pop(eosHandles.output);
 
   if(rhandleOut)
   {
     dpb.Remove(rhandleOut->data);
-    handlesOut.Remove(eosHandles.output);
 
     callbacks.release(false, rhandleOut);
 
@@ -679,13 +725,13 @@ void DecModule::Stop()
   ReleaseAllBuffers();
 }
 
-ErrorType DecModule::SetDynamic(std::string index, void const* param)
+ErrorType DecModule::SetDynamic(DynamicIndex index, void const* param)
 {
   (void)index, (void)param;
   return ERROR_NOT_IMPLEMENTED;
 }
 
-ErrorType DecModule::GetDynamic(std::string index, void* param)
+ErrorType DecModule::GetDynamic(DynamicIndex index, void* param)
 {
   (void)index, (void)param;
   return ERROR_NOT_IMPLEMENTED;
@@ -44,17 +44,35 @@
 #include <vector>
 #include <queue>
 #include <memory>
+#include <mutex>
 
 #include "base/omx_mediatype/omx_mediatype_dec_interface.h"
-#include "base/omx_utils/threadsafe_map.h"
+#include "base/omx_utils/flat_map.h"
 
 extern "C"
 {
 #include <lib_decode/lib_decode.h>
 #include <lib_common/SliceConsts.h>
 #include <lib_common/StreamBuffer.h>
+#include <lib_common/BufferSrcMeta.h>
 }
 
+/* What the hot path needs to know about the current stream.
+ * Computed once per resolution instead of being queried on every frame */
+struct StreamGeometry
+{
+  int stride;
+  int sliceHeight;
+  int outputSize;
+  BufferHandles bufferHandles;
+
+  /* source metadata template of the output buffers */
+  AL_TDimension dimension;
+  AL_TPitches pitches;
+  AL_TOffsetYC offsetYC;
+  TFourCC fourCC;
+};
+
 struct DecModule : public ModuleInterface
 {
   DecModule(std::shared_ptr<DecMediatypeInterface> media, std::shared_ptr<DecDevice> device, std::shared_ptr<AL_TAllocator> allocator);
@@ -83,8 +101,8 @@ struct DecModule : public ModuleInterface
   bool Flush() override;
   void Stop() override;
 
-  ErrorType SetDynamic(std::string index, void const* param) override;
-  ErrorType GetDynamic(std::string index, void* param) override;
+  ErrorType SetDynamic(DynamicIndex index, void const* param) override;
+  ErrorType GetDynamic(DynamicIndex index, void* param) override;
 
 private:
   std::shared_ptr<DecMediatypeInterface> const media;
@@ -92,15 +110,22 @@ private:
   std::shared_ptr<AL_TAllocator> allocator;
 
   int currentDisplayPictureType = -1;
+  /* written on the resolution found and fill threads, read by the display callback */
+  std::mutex geometryMutex;
+  StreamGeometry geometry {};
+  void UpdateGeometry();
+  void _UpdateGeometry();
+  StreamGeometry GetGeometry();
+  StreamGeometry GetOutputGeometry();
 
   Callbacks callbacks;
-  ThreadSafeMap<AL_TBuffer*, BufferHandleInterface*> handlesIn;
-  ThreadSafeMap<AL_TBuffer*, BufferHandleInterface*> handlesOut;
-  ThreadSafeMap<char*, AL_TBuffer*> dpb;
-  ThreadSafeMap<AL_TBuffer*, char*> shouldBeCopied;
+  FlatMap<AL_TBuffer*, BufferHandleInterface*> handlesIn;
+  FlatMap<AL_TBuffer*, BufferHandleInterface*> handlesOut;
+  FlatMap<char*, AL_TBuffer*> dpb;
+  FlatMap<AL_TBuffer*, char*> shouldBeCopied;
 
-  ThreadSafeMap<void*, AL_HANDLE> allocated;
-  ThreadSafeMap<int, AL_HANDLE> allocatedDMA;
+  FlatMap<void*, AL_HANDLE> allocated;
+  FlatMap<int, AL_HANDLE> allocatedDMA;
 
   AL_TIDecChannel* channel;
   AL_HDecoder decoder;
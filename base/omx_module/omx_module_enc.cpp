@@ -59,9 +59,14 @@ extern "C"
 #include "base/omx_mediatype/omx_convert_module_soft_enc.h"
 #include "base/omx_mediatype/omx_convert_module_soft.h"
 #include "base/omx_utils/round.h"
+#include "base/omx_utils/parallel_copy.h"
+#include "base/omx_utils/omx_log.h"
 
 using namespace std;
 
+/* map changes kept to patch recycled ROI buffers, older buffers are rewritten */
+static size_t constexpr ROI_HISTORY_SIZE = 8;
+
 static ErrorType ToModuleError(int errorCode)
 {
   switch(errorCode)
@@ -103,7 +108,8 @@ static void LookCoherency(AL_TEncSettings& settings)
 EncModule::EncModule(shared_ptr<EncMediatypeInterface> media, shared_ptr<EncDevice> device, shared_ptr<AL_TAllocator> allocator) :
   media(media),
   device(device),
-  allocator(allocator)
+  allocator(allocator),
+  roiHistory(ROI_HISTORY_SIZE)
 {
   assert(this->media);
   assert(this->device);
@@ -113,7 +119,10 @@ EncModule::EncModule(shared_ptr<EncMediatypeInterface> media, shared_ptr<EncDevi
   ResetRequirements();
 }
 
-EncModule::~EncModule() = default;
+EncModule::~EncModule()
+{
+  InvalidateBuffers();
+}
 
 map<AL_ERR, string> MapToStringEncodeError =
 {
@@ -163,12 +172,13 @@ void EncModule::InitEncoders(int numPass)
         AL_Buffer_Ref(encoderPass.streamBuffers.back());
       }
 
-      auto p = bind(&EncModule::_ProcessEmptyFifo, this, placeholders::_1);
+      // the lookahead of every channel runs on the workers shared by the process
+      auto p = bind(&EncModule::_ProcessEmptyFifo, this, pass, placeholders::_1);
       auto d = bind(&EncModule::_DeleteEmptyFifo, this, placeholders::_1);
-      encoderPass.threadFifo.reset(new ProcessorFifo(p, d));
+      encoderPass.lookAheadStrand.reset(new ProcessorStrand(ProcessorPool::Shared(), p, d));
     }
 
-    encoders.push_back(encoderPass);
+    encoders.push_back(move(encoderPass));
   }
 }
 
@@ -180,6 +190,9 @@ ErrorType EncModule::CreateEncoder()
     return ERROR_UNDEFINED;
   }
 
+  runBufferHandles = GetBufferHandles();
+  runResolution = GetResolution();
+
   auto chan = media->settings.tChParam[0];
   roiCtx = AL_RoiMngr_Create(chan.uWidth, chan.uHeight, chan.eProfile, AL_ROI_QUALITY_MEDIUM, AL_ROI_INCOMING_ORDER);
 
@@ -198,6 +211,29 @@ ErrorType EncModule::CreateEncoder()
 #endif
 
   InitEncoders(numPass);
+  qpTables.Open();
+
+  bool sceneChangeDetection = false;
+  media->Get(SETTINGS_INDEX_SCENE_CHANGE_DETECTION, &sceneChangeDetection);
+
+  // the lookahead already detects the scene changes
+  if(sceneChangeDetection && numPass == 1)
+  {
+    if(chan.uSrcBitDepth != 8)
+      fprintf(stderr, "Scene change detection is only available on 8 bits inputs\n");
+    else
+    {
+      sceneChangeDetector.reset(new SceneChangeDetector(runResolution.width, runResolution.height, runResolution.stride.widthStride));
+      auto p = bind(&EncModule::_ProcessSceneChange, this, placeholders::_1);
+      auto d = bind(&EncModule::_DeleteSceneChange, this, placeholders::_1);
+      sceneChangeStrand.reset(new ProcessorStrand(ProcessorPool::Shared(), p, d));
+    }
+  }
+
+  auto requirements = GetBufferRequirements();
+  auto bufferCount = static_cast<size_t>(requirements.input.min + requirements.output.min);
+  slots.Reserve(static_cast<int>(bufferCount));
+  roiGenerations.Reserve(static_cast<size_t>(requirements.input.min));
 
   for(auto pass = 0; pass < numPass; pass++)
   {
@@ -212,6 +248,7 @@ ErrorType EncModule::CreateEncoder()
       AL_TwoPassMngr_SetPass1Settings(settingsPass);
       callback = { EncModule::RedirectionEndEncodingLookAhead, &(encoderPass.lookAheadParams.callbackParam) };
       encoderPass.lookAheadParams.fifoSize = settings.LookAhead;
+      encoderPass.fifo.Reset(settings.LookAhead);
     }
 #endif
 
@@ -248,12 +285,19 @@ bool EncModule::DestroyEncoder()
     return false;
   }
 
+  // the frames waiting for the scene change analysis are given back, the running one is pushed
+  sceneChangeStrand.reset();
+  sceneChangeDetector.reset();
+
   for(auto pass = 0; pass < (int)encoders.size(); pass++)
   {
-    GenericEncoder encoder = encoders[pass];
+    GenericEncoder& encoder = encoders[pass];
 
     AL_Encoder_Destroy(encoder.enc);
 
+    // frames still queued to the lookahead are released by the strand, the next pass is still alive
+    encoder.lookAheadStrand.reset();
+
     while(!encoder.roiBuffers.empty())
     {
       auto roiBuffer = encoder.roiBuffers.front();
@@ -261,12 +305,8 @@ bool EncModule::DestroyEncoder()
       AL_Buffer_Unref(roiBuffer);
     }
 
-    while(!encoder.fifo.empty())
-    {
-      auto src = encoder.fifo.front();
-      encoder.fifo.pop_front();
-      AL_Buffer_Unref(src);
-    }
+    while(!encoder.fifo.Empty())
+      AL_Buffer_Unref(encoder.fifo.Pop().src);
 
     for(int i = 0; i < (int)encoder.streamBuffers.size(); i++)
     {
@@ -277,6 +317,11 @@ bool EncModule::DestroyEncoder()
 
   encoders.clear();
 
+  /* settings (resolution, format) can change before the next run */
+  InvalidateBuffers();
+  qpTables.Close();
+  DestroyRoiBuffers();
+
   device->Deinit(scheduler);
   scheduler = nullptr;
 
@@ -356,6 +401,10 @@ void EncModule::Stop()
 
   DestroyEncoder();
   FlushEosHandles();
+
+  if(streamStats.frames)
+    LOGI("Stream bytes moved per frame : %f", static_cast<float>(streamStats.bytesMoved) / streamStats.frames);
+  streamStats = StreamStats {};
 }
 
 void EncModule::ResetRequirements()
@@ -501,27 +550,36 @@ bool EncModule::Use(BufferHandleInterface* handle, unsigned char* buffer, int si
   if(!buffer)
     throw invalid_argument("buffer");
 
-  AL_TBuffer* encoderBuffer = nullptr;
+  auto encoderBuffer = GetCachedBuffer(handle, size);
 
-  if(allocated.Exist(buffer))
-  {
-    encoderBuffer = AL_Buffer_Create(allocator.get(), allocated.Get(buffer), size, FreeWithoutDestroyingMemory);
-  }
-  else if(size)
+  if(!encoderBuffer)
   {
-    encoderBuffer = AL_Buffer_Create_And_Allocate(allocator.get(), size, AL_Buffer_Destroy);
-    shouldBeCopied.Add(encoderBuffer, buffer);
-  }
-  else
-    encoderBuffer = AL_Buffer_Create(allocator.get(), NULL, size, FreeWithoutDestroyingMemory);
+    AL_HANDLE allocatedHandle = nullptr;
+    AL_VADDR shadowOf = nullptr;
 
-  if(!encoderBuffer)
-    return false;
+    if(allocated.TryGet(buffer, allocatedHandle))
+    {
+      encoderBuffer = AL_Buffer_Create(allocator.get(), allocatedHandle, size, FreeWithoutDestroyingMemory);
+    }
+    else if(size)
+    {
+      encoderBuffer = AL_Buffer_Create_And_Allocate(allocator.get(), size, AL_Buffer_Destroy);
+      shadowOf = buffer;
+    }
+    else
+      encoderBuffer = AL_Buffer_Create(allocator.get(), NULL, size, FreeWithoutDestroyingMemory);
 
-  assert(!pool.Exist(handle));
+    if(!encoderBuffer)
+      return false;
+
+    CacheBuffer(handle, encoderBuffer, shadowOf);
+  }
+
+  auto& slot = slots[handle->slot];
+  assert(!slot.used.load(memory_order_acquire));
 
   AL_Buffer_Ref(encoderBuffer);
-  pool.Add(handle, encoderBuffer);
+  slot.used.store(encoderBuffer, memory_order_release);
 
   return true;
 }
@@ -534,23 +592,31 @@ bool EncModule::UseDMA(BufferHandleInterface* handle, int fd, int size)
   if(fd < 0)
     throw invalid_argument("fd");
 
-  auto dmaHandle = AL_LinuxDmaAllocator_ImportFromFd((AL_TLinuxDmaAllocator*)allocator.get(), fd);
+  auto encoderBuffer = GetCachedBuffer(handle, size);
 
-  if(!dmaHandle)
+  if(!encoderBuffer)
   {
-    fprintf(stderr, "Failed to import fd : %i\n", fd);
-    return false;
-  }
+    auto dmaHandle = AL_LinuxDmaAllocator_ImportFromFd((AL_TLinuxDmaAllocator*)allocator.get(), fd);
 
-  auto encoderBuffer = AL_Buffer_Create(allocator.get(), dmaHandle, size, AL_Buffer_Destroy);
+    if(!dmaHandle)
+    {
+      fprintf(stderr, "Failed to import fd : %i\n", fd);
+      return false;
+    }
 
-  if(!encoderBuffer)
-    return false;
+    encoderBuffer = AL_Buffer_Create(allocator.get(), dmaHandle, size, AL_Buffer_Destroy);
 
-  assert(!pool.Exist(handle));
+    if(!encoderBuffer)
+      return false;
+
+    CacheBuffer(handle, encoderBuffer, nullptr);
+  }
+
+  auto& slot = slots[handle->slot];
+  assert(!slot.used.load(memory_order_acquire));
 
   AL_Buffer_Ref(encoderBuffer);
-  pool.Add(handle, encoderBuffer);
+  slot.used.store(encoderBuffer, memory_order_release);
 
   return true;
 }
@@ -560,22 +626,110 @@ void EncModule::Unuse(BufferHandleInterface* handle)
   if(!handle)
     throw invalid_argument("handle");
 
-  auto encoderBuffer = pool.Pop(handle);
-
-  if(shouldBeCopied.Exist(encoderBuffer))
-    shouldBeCopied.Remove(encoderBuffer);
+  auto slot = FindSlot(handle);
+  assert(slot >= 0);
+  auto encoderBuffer = slots[slot].used.exchange(nullptr, memory_order_acq_rel);
+  assert(encoderBuffer);
   AL_Buffer_Unref(encoderBuffer);
 }
 
 void EncModule::UnuseDMA(BufferHandleInterface* handle)
 {
-  if(!handle)
-    throw invalid_argument("handle");
+  Unuse(handle);
+}
+
+static void* SlotToUserData(int slot)
+{
+  return reinterpret_cast<void*>(static_cast<intptr_t>(slot) + 1);
+}
+
+static int GetSlot(AL_TBuffer const* encoderBuffer)
+{
+  auto slot = static_cast<int>(reinterpret_cast<intptr_t>(AL_Buffer_GetUserData(encoderBuffer))) - 1;
+  assert(slot >= 0);
+  return slot;
+}
+
+/* The slot of a header is only trusted while the header still owns it: the slots are given back
+ * when the buffers are invalidated, the headers keep their index */
+int EncModule::FindSlot(BufferHandleInterface* handle)
+{
+  auto slot = handle->slot;
+
+  if(!slots.IsValid(slot) || slots[slot].owner.load(memory_order_acquire) != handle)
+    return -1;
+
+  return slot;
+}
+
+AL_TBuffer* EncModule::GetUsedBuffer(BufferHandleInterface* handle)
+{
+  auto slot = FindSlot(handle);
+
+  if(slot < 0)
+    return nullptr;
+
+  return slots[slot].used.load(memory_order_acquire);
+}
+
+AL_TBuffer* EncModule::GetCachedBuffer(BufferHandleInterface* handle, int size)
+{
+  auto slot = FindSlot(handle);
+  auto encoderBuffer = slot >= 0 ? slots[slot].cached.load() : nullptr;
+
+  if(encoderBuffer && static_cast<int>(encoderBuffer->zSize) == size)
+    return encoderBuffer;
+
+  InvalidateBuffer(handle);
+  return nullptr;
+}
+
+void EncModule::CacheBuffer(BufferHandleInterface* handle, AL_TBuffer* encoderBuffer, AL_VADDR shadowOf)
+{
+  /* the cache owns one reference: the buffer, its dma import and its metadata live as long as the header */
+  AL_Buffer_Ref(encoderBuffer);
 
-  auto encoderBuffer = pool.Pop(handle);
+  auto slot = slots.Acquire();
+  auto& record = slots[slot];
+  record.cached.store(encoderBuffer);
+  record.used.store(nullptr);
+  record.inFlight.store(nullptr);
+  record.shadowOf.store(shadowOf);
+  record.pendingRoi.store(nullptr);
+  record.owner.store(handle);
+
+  AL_Buffer_SetUserData(encoderBuffer, SlotToUserData(slot));
+  handle->slot = slot;
+}
+
+void EncModule::ReleaseSlot(int slot)
+{
+  auto& record = slots[slot];
+  auto encoderBuffer = record.cached.exchange(nullptr);
+  record.shadowOf.store(nullptr);
+  record.owner.store(nullptr);
+  slots.Release(slot);
   AL_Buffer_Unref(encoderBuffer);
 }
 
+void EncModule::InvalidateBuffer(BufferHandleInterface* handle)
+{
+  auto slot = FindSlot(handle);
+
+  if(slot < 0)
+    return;
+
+  handle->slot = -1;
+  ReleaseSlot(slot);
+}
+
+void EncModule::InvalidateBuffers()
+{
+  slots.ForEach([&](int slot, EncBufferSlot&) {
+    ReleaseSlot(slot);
+  });
+}
+
 static AL_TMetaData* CreateSourceMeta(shared_ptr<MediatypeInterface> media, Resolution const& resolution)
 {
   Format format {};
@@ -638,6 +792,14 @@ bool EncModule::Empty(BufferHandleInterface* handle)
   if(eos)
   {
     eosHandles.input = handle;
+
+    // behind the frames still analyzed
+    if(sceneChangeStrand)
+    {
+      sceneChangeStrand->queue(nullptr);
+      return true;
+    }
+
     auto bRet = AL_Encoder_Process(encoder, nullptr, nullptr);
     return bRet;
   }
@@ -646,21 +808,21 @@ bool EncModule::Empty(BufferHandleInterface* handle)
 
   uint8_t* buffer = (uint8_t*)handle->data;
 
-  BufferHandles bufferHandles = GetBufferHandles();
+  BufferHandles const& bufferHandles = runBufferHandles;
 
   if(bufferHandles.input == BufferHandleType::BUFFER_HANDLE_FD)
     UseDMA(handle, static_cast<int>((intptr_t)buffer), handle->payload);
   else
     Use(handle, buffer, handle->payload);
 
-  auto input = pool.Get(handle);
+  auto input = GetUsedBuffer(handle);
 
   if(!input)
     return false;
 
   if(!AL_Buffer_GetMetaData(input, AL_META_TYPE_SOURCE))
   {
-    if(!CreateAndAttachSourceMeta(*input, media, GetResolution()))
+    if(!CreateAndAttachSourceMeta(*input, media, runResolution))
       return false;
   }
 
@@ -671,12 +833,39 @@ bool EncModule::Empty(BufferHandleInterface* handle)
       return false;
 #endif
 
-  handles.Add(input, handle);
+  auto& inputSlot = slots[GetSlot(input)];
+  inputSlot.inFlight.store(handle, memory_order_release);
+
+  auto copyFrom = inputSlot.shadowOf.load(memory_order_acquire);
+  auto isCopied = copyFrom != nullptr;
 
-  if(shouldBeCopied.Exist(input))
+  if(isCopied)
+    ParallelCopy(AL_Buffer_GetData(input), copyFrom, input->zSize);
+
+  auto qpBuffer = qpTables.Pop(handle);
+
+  if(qpBuffer)
   {
-    auto buffer = shouldBeCopied.Get(input);
-    copy(buffer, buffer + input->zSize, AL_Buffer_GetData(input));
+    // the table replaces the map of the regions of interest pushed for this frame
+    if(!currentEnc.roiBuffers.empty())
+    {
+      AL_Buffer_Unref(currentEnc.roiBuffers.back());
+      currentEnc.roiBuffers.pop_back();
+    }
+    currentEnc.roiBuffers.push_back(qpBuffer);
+  }
+
+  if(sceneChangeStrand)
+  {
+    // there is a single pass: the strand releases the ROI buffer once the frame is pushed
+    if(!currentEnc.roiBuffers.empty())
+    {
+      inputSlot.pendingRoi.store(currentEnc.roiBuffers.front(), memory_order_release);
+      currentEnc.roiBuffers.pop_front();
+    }
+
+    sceneChangeStrand->queue(input);
+    return true;
   }
 
   if(currentEnc.roiBuffers.empty())
@@ -687,7 +876,10 @@ bool EncModule::Empty(BufferHandleInterface* handle)
   auto success = AL_Encoder_Process(encoder, input, roiBuffer);
 
   if(currentEnc.index != encoders.back().index)
+  {
+    lock_guard<mutex> lock(roiBuffersMutex);
     encoders[currentEnc.index + 1].roiBuffers.push_back(roiBuffer);
+  }
   else
     AL_Buffer_Unref(roiBuffer);
 
@@ -724,36 +916,43 @@ bool EncModule::Fill(BufferHandleInterface* handle)
 
   auto buffer = (uint8_t*)handle->data;
 
-  BufferHandles bufferHandles = GetBufferHandles();
+  BufferHandles const& bufferHandles = runBufferHandles;
 
   if(bufferHandles.output == BufferHandleType::BUFFER_HANDLE_FD)
     UseDMA(handle, static_cast<int>((intptr_t)buffer), handle->size);
   else
     Use(handle, buffer, handle->size);
 
-  auto output = pool.Get(handle);
+  auto output = GetUsedBuffer(handle);
 
   if(!output)
     return false;
 
-  if(!AL_Buffer_GetMetaData(output, AL_META_TYPE_STREAM))
-  {
-    if(!CreateAndAttachStreamMeta(*output))
-      return false;
-  }
+  auto streamMeta = (AL_TStreamMetaData*)AL_Buffer_GetMetaData(output, AL_META_TYPE_STREAM);
+
+  if(streamMeta)
+    AL_StreamMetaData_ClearAllSections(streamMeta);
+  else if(!CreateAndAttachStreamMeta(*output))
+    return false;
 
-  handles.Add(output, handle);
+  slots[GetSlot(output)].inFlight.store(handle, memory_order_release);
 
   return AL_Encoder_PutStreamBuffer(encoder, output);
 }
 
-static void AppendBuffer(uint8_t*& dst, uint8_t const* src, size_t len)
+/* returns the bytes moved: a section already in place is left alone */
+static size_t AppendBuffer(uint8_t*& dst, uint8_t const* src, size_t len)
 {
-  move(src, src + len, dst);
+  auto isMoved = (dst != src);
+
+  if(isMoved)
+    move(src, src + len, dst);
+
   dst += len;
+  return isMoved ? len : 0;
 }
 
-static int WriteOneSection(uint8_t*& dst, AL_TBuffer& stream, int numSection)
+static int WriteOneSection(uint8_t*& dst, AL_TBuffer& stream, int numSection, size_t& bytesMoved)
 {
   auto meta = (AL_TStreamMetaData*)AL_Buffer_GetMetaData(&stream, AL_META_TYPE_STREAM);
 
@@ -764,32 +963,74 @@ static int WriteOneSection(uint8_t*& dst, AL_TBuffer& stream, int numSection)
 
   if(size < (meta->pSections[numSection]).uLength)
   {
-    AppendBuffer(dst, (AL_Buffer_GetData(&stream) + meta->pSections[numSection].uOffset), size);
-    AppendBuffer(dst, AL_Buffer_GetData(&stream), (meta->pSections[numSection]).uLength - size);
+    bytesMoved += AppendBuffer(dst, (AL_Buffer_GetData(&stream) + meta->pSections[numSection].uOffset), size);
+    bytesMoved += AppendBuffer(dst, AL_Buffer_GetData(&stream), (meta->pSections[numSection]).uLength - size);
   }
   else
-    AppendBuffer(dst, (AL_Buffer_GetData(&stream) + meta->pSections[numSection].uOffset), meta->pSections[numSection].uLength);
+    bytesMoved += AppendBuffer(dst, (AL_Buffer_GetData(&stream) + meta->pSections[numSection].uOffset), meta->pSections[numSection].uLength);
 
   return meta->pSections[numSection].uLength;
 }
 
-static int ReconstructStream(AL_TBuffer& stream)
+/* The sections can be handed as is to the client when they follow each other
+ * without wrapping around the end of the buffer */
+static bool AreSectionsContiguous(AL_TBuffer const& stream, AL_TStreamMetaData const& meta, int& offset, int& size)
 {
-  auto origin = AL_Buffer_GetData(&stream);
-  auto size = 0;
+  auto first = true;
+  uint32_t end = 0;
+  offset = 0;
+  size = 0;
+
+  for(int i = 0; i < meta.uNumSection; i++)
+  {
+    auto const& section = meta.pSections[i];
+
+    if(!section.uLength)
+      continue;
+
+    if(first)
+    {
+      offset = section.uOffset;
+      end = section.uOffset;
+      first = false;
+    }
+
+    if(section.uOffset != end)
+      return false;
+
+    end += section.uLength;
+  }
+
+  if(end > stream.zSize)
+    return false;
+
+  size = end - offset;
+  return true;
+}
 
+static int ReconstructStream(AL_TBuffer& stream, int& offset, size_t& bytesMoved)
+{
   auto meta = (AL_TStreamMetaData*)(AL_Buffer_GetMetaData(&stream, AL_META_TYPE_STREAM));
   assert(meta);
 
+  auto size = 0;
+  bytesMoved = 0;
+
+  if(AreSectionsContiguous(stream, *meta, offset, size))
+    return size;
+
+  auto origin = AL_Buffer_GetData(&stream);
+  offset = 0;
+
   for(int i = 0; i < meta->uNumSection; i++)
-    size += WriteOneSection(origin, stream, i);
+    size += WriteOneSection(origin, stream, i, bytesMoved);
 
   return size;
 }
 
 void EncModule::ReleaseBuf(AL_TBuffer const* buf, bool isDma, bool isSrc)
 {
-  auto rhandle = handles.Pop(buf);
+  auto rhandle = slots[GetSlot(buf)].inFlight.exchange(nullptr, memory_order_acq_rel);
 
   if(isDma)
     UnuseDMA(rhandle);
@@ -819,7 +1060,7 @@ void EncModule::EndEncoding(AL_TBuffer* stream, AL_TBuffer const* source)
       callbacks.event(CALLBACK_EVENT_ERROR, (void*)ToModuleError(errorCode));
   }
 
-  BufferHandles bufferHandles = GetBufferHandles();
+  BufferHandles const& bufferHandles = runBufferHandles;
 
   auto isSrcRelease = (stream == nullptr && source);
 
@@ -853,19 +1094,18 @@ void EncModule::EndEncoding(AL_TBuffer* stream, AL_TBuffer const* source)
     return;
   }
 
-  auto rhandleIn = handles.Get(source);
+  auto& sourceSlot = slots[GetSlot(source)];
+  auto rhandleIn = isEndOfFrame(stream) ?
+                   sourceSlot.inFlight.exchange(nullptr, memory_order_acq_rel) :
+                   sourceSlot.inFlight.load(memory_order_acquire);
   assert(rhandleIn->data);
 
-  auto rhandleOut = handles.Get(stream);
+  auto& streamSlot = slots[GetSlot(stream)];
+  auto rhandleOut = streamSlot.inFlight.exchange(nullptr, memory_order_acq_rel);
   assert(rhandleOut->data);
 
   callbacks.associate(rhandleIn, rhandleOut);
 
-  if(isEndOfFrame(stream))
-    handles.Remove(source);
-
-  handles.Remove(stream);
-
   if(isEndOfFrame(stream))
   {
     if(bufferHandles.input == BufferHandleType::BUFFER_HANDLE_FD)
@@ -878,20 +1118,23 @@ void EncModule::EndEncoding(AL_TBuffer* stream, AL_TBuffer const* source)
     callbacks.emptied(rhandleIn);
   }
 
-  auto size = ReconstructStream(*stream);
+  auto offset = 0;
+  size_t bytesMoved = 0;
+  auto size = ReconstructStream(*stream, offset, bytesMoved);
+  streamStats.frames++;
+  streamStats.bytesMoved += bytesMoved;
 
-  if(shouldBeCopied.Exist(stream))
-  {
-    auto buffer = shouldBeCopied.Get(stream);
-    copy(AL_Buffer_GetData(stream), AL_Buffer_GetData(stream) + size, buffer);
-  }
+  auto buffer = streamSlot.shadowOf.load(memory_order_acquire);
+
+  if(buffer)
+    ParallelCopy(buffer + offset, AL_Buffer_GetData(stream) + offset, size);
 
   if(bufferHandles.output == BufferHandleType::BUFFER_HANDLE_FD)
     UnuseDMA(rhandleOut);
   else
     Unuse(rhandleOut);
 
-  rhandleOut->offset = 0;
+  rhandleOut->offset = offset;
   rhandleOut->payload = size;
   callbacks.filled(rhandleOut, rhandleOut->offset, rhandleOut->payload);
 }
@@ -922,7 +1165,7 @@ void EncModule::EndEncodingLookAhead(AL_TBuffer* stream, AL_TBuffer const* sourc
     return;
   }
 
-  BufferHandles bufferHandles = GetBufferHandles();
+  BufferHandles const& bufferHandles = runBufferHandles;
 
   if(isSrcRelease)
   {
@@ -942,21 +1185,30 @@ void EncModule::EndEncodingLookAhead(AL_TBuffer* stream, AL_TBuffer const* sourc
 
 void EncModule::AddFifo(GenericEncoder& encoder, AL_TBuffer* src)
 {
-  bool isEOS = (src == nullptr);
-
-  if(!isEOS)
-  {
+  if(src)
     AL_Buffer_Ref(src);
-    encoder.fifo.push_back(src);
-  }
-  encoder.threadFifo->queue(new EmptyFifoParam(&encoder, isEOS));
+
+  encoder.lookAheadStrand->queue(src);
 }
 
-void EncModule::EmptyFifo(GenericEncoder& encoder, bool isEOS)
+void EncModule::EmptyFifo(GenericEncoder& encoder, AL_TBuffer* src)
 {
   assert(encoder.index < (int)encoders.size() - 1);
 
-  GenericEncoder nextEnc = encoders[encoder.index + 1];
+  GenericEncoder& nextEnc = encoders[encoder.index + 1];
+  bool isEOS = (src == nullptr);
+
+  if(!isEOS)
+  {
+    LookAheadFrame frame { src, nullptr, 0 };
+#if AL_ENABLE_TWOPASS
+    frame.meta = AL_Buffer_GetMetaData(src, AL_META_TYPE_LOOKAHEAD);
+
+    if(frame.meta)
+      frame.pictureSize = ((AL_TLookAheadMetaData*)frame.meta)->iPictureSize;
+#endif
+    encoder.fifo.Push(frame);
+  }
 
 #if AL_ENABLE_TWOPASS
 
@@ -964,19 +1216,19 @@ void EncModule::EmptyFifo(GenericEncoder& encoder, bool isEOS)
     encoder.ComputeComplexity(isEOS);
 #endif
 
-  if(isEOS && encoder.fifo.size() == 0)
+  if(isEOS && encoder.fifo.Empty())
     AL_Encoder_Process(nextEnc.enc, nullptr, nullptr);
 
-  else if(isEOS || (int)encoder.fifo.size() == encoder.lookAheadParams.fifoSize)
+  else if(isEOS || encoder.fifo.Size() == encoder.lookAheadParams.fifoSize)
   {
-    auto src = encoder.fifo.front();
-    encoder.fifo.pop_front();
+    auto frame = encoder.fifo.Pop();
 
 #if AL_ENABLE_TWOPASS
-    encoder.ProcessLookAheadParams(src);
+    encoder.ProcessLookAheadParams(frame);
 #endif
 
     AL_TBuffer* roiBuffer = nullptr;
+    unique_lock<mutex> lock(roiBuffersMutex);
 
     if(!nextEnc.roiBuffers.empty())
     {
@@ -984,20 +1236,26 @@ void EncModule::EmptyFifo(GenericEncoder& encoder, bool isEOS)
       nextEnc.roiBuffers.pop_front();
     }
 
-    AL_Encoder_Process(nextEnc.enc, src, roiBuffer);
+    lock.unlock();
+
+    AL_Encoder_Process(nextEnc.enc, frame.src, roiBuffer);
 
     if(roiBuffer)
     {
       if(nextEnc.index != encoders.back().index)
+      {
+        lock.lock();
         encoders[nextEnc.index + 1].roiBuffers.push_back(roiBuffer);
+        lock.unlock();
+      }
       else
         AL_Buffer_Unref(roiBuffer);
     }
 
-    AL_Buffer_Unref(src);
+    AL_Buffer_Unref(frame.src);
 
     if(isEOS)
-      EmptyFifo(encoder, isEOS);
+      EmptyFifo(encoder, nullptr);
   }
 }
 
@@ -1039,10 +1297,7 @@ Flags EncModule::GetFlags(AL_TBuffer* stream)
 
 Flags EncModule::GetFlags(BufferHandleInterface* handle)
 {
-  AL_TBuffer* stream = nullptr;
-
-  if(pool.Exist(handle))
-    stream = pool.Get(handle);
+  auto stream = GetUsedBuffer(handle);
 
   if(!stream)
     return Flags {};
@@ -1050,23 +1305,121 @@ Flags EncModule::GetFlags(BufferHandleInterface* handle)
   return GetFlags(stream);
 }
 
-ErrorType EncModule::SetDynamic(std::string index, void const* param)
+AL_TBuffer* EncModule::GetRoiBuffer()
+{
+  AL_TBuffer* roiBuffer = nullptr;
+
+  {
+    lock_guard<mutex> lock(roiPoolMutex);
+
+    // the last released buffer is the one with the fewest changes to patch
+    if(!roiPool.empty())
+    {
+      roiBuffer = roiPool.back();
+      roiPool.pop_back();
+    }
+  }
+
+  if(!roiBuffer)
+  {
+    auto chan = media->settings.tChParam[0];
+    AL_TDimension tDim = { chan.uWidth, chan.uHeight };
+    roiBuffer = AL_Buffer_Create_And_Allocate(allocator.get(), AL_GetAllocSizeEP2(tDim, chan.uMaxCuSize), RedirectionRoiBufferRelease);
+
+    if(!roiBuffer)
+      return nullptr;
+
+    AL_Buffer_SetUserData(roiBuffer, this);
+  }
+
+  AL_Buffer_Ref(roiBuffer);
+  return roiBuffer;
+}
+
+void EncModule::ReleaseRoiBuffer(AL_TBuffer* roiBuffer)
+{
+  lock_guard<mutex> lock(roiPoolMutex);
+  roiPool.push_back(roiBuffer);
+}
+
+void EncModule::DestroyRoiBuffers()
+{
+  lock_guard<mutex> lock(roiPoolMutex);
+
+  for(auto roiBuffer : roiPool)
+  {
+    roiGenerations.Remove(roiBuffer);
+    AL_Buffer_Destroy(roiBuffer);
+  }
+
+  roiPool.clear();
+  roiHistory.Reset();
+}
+
+AL_TBuffer* EncModule::CreateQuantizationParameterTable(QuantizationParameterTable const& table)
 {
+  QuantizationParameterTableLayout layout;
+  GetDynamic(DYNAMIC_INDEX_QUANTIZATION_PARAMETER_TABLE, &layout);
+
+  if(table.fd >= 0)
+  {
+    auto dmaHandle = AL_LinuxDmaAllocator_ImportFromFd((AL_TLinuxDmaAllocator*)allocator.get(), table.fd);
+
+    if(!dmaHandle)
+    {
+      fprintf(stderr, "Failed to import fd : %i\n", table.fd);
+      return nullptr;
+    }
+
+    auto qpBuffer = AL_Buffer_Create(allocator.get(), dmaHandle, layout.dmaSize, AL_Buffer_Destroy);
+
+    if(!qpBuffer)
+      return nullptr;
+
+    AL_Buffer_Ref(qpBuffer);
+    return qpBuffer;
+  }
+
+  if(!table.table || table.size < layout.size)
+    return nullptr;
+
+  // host memory can't be read by the encoder, a recycled ROI buffer takes the only copy
+  auto qpBuffer = GetRoiBuffer();
+
+  if(!qpBuffer)
+    return nullptr;
+
+  memset(AL_Buffer_GetData(qpBuffer), 0, AL_Buffer_GetSize(qpBuffer));
+  memcpy(AL_Buffer_GetData(qpBuffer) + layout.offset, table.table, layout.size);
+  roiGenerations.Remove(qpBuffer); // not built from the map, rewrite it on reuse
+
+  return qpBuffer;
+}
+
+ErrorType EncModule::SetDynamic(DynamicIndex index, void const* param)
+{
+  // given from the client thread: doesn't look at the encoders, they can be created or destroyed meanwhile
+  if(index == DYNAMIC_INDEX_QUANTIZATION_PARAMETER_TABLE)
+  {
+    auto table = static_cast<QuantizationParameterTable const*>(param);
+    return qpTables.Add(table->handle, [&] { return CreateQuantizationParameterTable(*table); });
+  }
+
   if(!encoders.size())
     return ERROR_UNDEFINED;
 
-  AL_HEncoder encoder = encoders.back().enc;
-
-  if(index == "DYNAMIC_INDEX_CLOCK")
+  switch(index)
   {
-    auto clock = static_cast<Clock const*>(param);
-    auto ret = media->Set(SETTINGS_INDEX_CLOCK, clock);
+  case DYNAMIC_INDEX_CLOCK:
+  {
+    auto clock = *static_cast<Clock const*>(param);
+    auto ret = media->Set(SETTINGS_INDEX_CLOCK, &clock);
     assert(ret == MediatypeInterface::ERROR_SETTINGS_NONE);
-    AL_Encoder_SetFrameRate(encoder, clock->framerate, clock->clockratio);
+    ApplyInFrameOrder([clock](AL_HEncoder encoder) { AL_Encoder_SetFrameRate(encoder, clock.framerate, clock.clockratio); });
     return SUCCESS;
   }
 
-  if(index == "DYNAMIC_INDEX_BITRATE")
+  case DYNAMIC_INDEX_BITRATE:
   {
     auto bitrate = static_cast<int>((intptr_t)param);
     Bitrate mediaBitrate;
@@ -1076,27 +1429,30 @@ ErrorType EncModule::SetDynamic(std::string index, void const* param)
     if(mediaBitrate.mode != RateControlType::RATE_CONTROL_VARIABLE_BITRATE)
       mediaBitrate.max = mediaBitrate.target;
     media->Set(SETTINGS_INDEX_BITRATE, &mediaBitrate);
-    AL_Encoder_SetBitRate(encoder, bitrate * 1000);
+    ApplyInFrameOrder([bitrate](AL_HEncoder encoder) { AL_Encoder_SetBitRate(encoder, bitrate * 1000); });
     return SUCCESS;
   }
 
-  if(index == "DYNAMIC_INDEX_INSERT_IDR")
+  case DYNAMIC_INDEX_INSERT_IDR:
   {
-    AL_Encoder_RestartGop(encoder);
+    ApplyInFrameOrder([](AL_HEncoder encoder) { AL_Encoder_RestartGop(encoder); });
     return SUCCESS;
   }
 
-  if(index == "DYNAMIC_INDEX_GOP")
+  case DYNAMIC_INDEX_GOP:
   {
-    auto gop = static_cast<Gop const*>(param);
-    auto ret = media->Set(SETTINGS_INDEX_GROUP_OF_PICTURES, gop);
+    auto gop = *static_cast<Gop const*>(param);
+    auto ret = media->Set(SETTINGS_INDEX_GROUP_OF_PICTURES, &gop);
     assert(ret == MediatypeInterface::ERROR_SETTINGS_NONE);
-    AL_Encoder_SetGopNumB(encoder, gop->b);
-    AL_Encoder_SetGopLength(encoder, gop->length);
+    ApplyInFrameOrder([gop](AL_HEncoder encoder)
+    {
+      AL_Encoder_SetGopNumB(encoder, gop.b);
+      AL_Encoder_SetGopLength(encoder, gop.length);
+    });
     return SUCCESS;
   }
 
-  if(index == "DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_ADD")
+  case DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_ADD:
   {
     assert(roiCtx);
     auto roi = static_cast<RegionQuality const*>(param);
@@ -1105,58 +1461,93 @@ ErrorType EncModule::SetDynamic(std::string index, void const* param)
     return SUCCESS;
   }
 
-  if(index == "DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_CLEAR")
+  case DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_CLEAR:
   {
     assert(roiCtx);
     AL_RoiMngr_Clear(roiCtx);
     return SUCCESS;
   }
 
-  if(index == "DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_BUFFER_EMPTY")
+  case DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_BUFFER_EMPTY:
   {
     assert(roiCtx);
     auto bufferToEmpty = static_cast<char const*>(param);
-    auto chan = media->settings.tChParam[0];
-    AL_TDimension tDim = { chan.uWidth, chan.uHeight };
-    auto size = AL_GetAllocSizeEP2(tDim, chan.uMaxCuSize);
-    auto roiBuffer = AL_Buffer_Create_And_Allocate(allocator.get(), size, AL_Buffer_Destroy);
-    AL_Buffer_Ref(roiBuffer);
-    copy(bufferToEmpty, bufferToEmpty + size, AL_Buffer_GetData(roiBuffer));
+    auto roiBuffer = GetRoiBuffer();
+
+    if(!roiBuffer)
+      return ERROR_NO_MEMORY;
+
+    copy(bufferToEmpty, bufferToEmpty + AL_Buffer_GetSize(roiBuffer), AL_Buffer_GetData(roiBuffer));
+    roiGenerations.Remove(roiBuffer); // not built from the map, rewrite it on reuse
     encoders.front().roiBuffers.push_back(roiBuffer);
     return SUCCESS;
   }
 
-  if(index == "DYNAMIC_INDEX_NOTIFY_SCENE_CHANGE")
+  case DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_BUFFER_PUSH:
+  {
+    assert(roiCtx);
+    roiHistory.Update(roiCtx);
+
+    auto roiBuffer = GetRoiBuffer();
+
+    if(!roiBuffer)
+      return ERROR_NO_MEMORY;
+
+    uint32_t generation = 0;
+    roiGenerations.TryPop(roiBuffer, generation);
+    auto roiMap = AL_Buffer_GetData(roiBuffer) + EP2_BUF_QP_BY_MB.Offset;
+
+    if(roiHistory.CanPatch(generation))
+      roiHistory.Patch(roiCtx, generation, roiMap);
+    else
+    {
+      AL_TRoiRect all = { 0, 0, roiCtx->iLcuWidth, roiCtx->iLcuHeight };
+      memset(AL_Buffer_GetData(roiBuffer), 0, AL_Buffer_GetSize(roiBuffer));
+      AL_RoiMngr_CopyMap(roiCtx, &all, roiMap);
+    }
+
+    roiGenerations.Add(roiBuffer, roiHistory.Generation());
+    encoders.front().roiBuffers.push_back(roiBuffer);
+    return SUCCESS;
+  }
+
+  case DYNAMIC_INDEX_NOTIFY_SCENE_CHANGE:
   {
     auto lookAhead = static_cast<int>((intptr_t)param);
-    AL_Encoder_NotifySceneChange(encoder, lookAhead);
+    ApplyInFrameOrder([lookAhead](AL_HEncoder encoder) { AL_Encoder_NotifySceneChange(encoder, lookAhead); });
     return SUCCESS;
   }
 
-  if(index == "DYNAMIC_INDEX_IS_LONG_TERM")
+  case DYNAMIC_INDEX_IS_LONG_TERM:
   {
-    AL_Encoder_NotifyIsLongTerm(encoder);
+    ApplyInFrameOrder([](AL_HEncoder encoder) { AL_Encoder_NotifyIsLongTerm(encoder); });
     return SUCCESS;
   }
 
-  if(index == "DYNAMIC_INDEX_USE_LONG_TERM")
+  case DYNAMIC_INDEX_USE_LONG_TERM:
   {
-    AL_Encoder_NotifyUseLongTerm(encoder);
+    ApplyInFrameOrder([](AL_HEncoder encoder) { AL_Encoder_NotifyUseLongTerm(encoder); });
     return SUCCESS;
   }
 
+  default:
+    break;
+  }
+
   return ERROR_NOT_IMPLEMENTED;
 }
 
-ErrorType EncModule::GetDynamic(std::string index, void* param)
+ErrorType EncModule::GetDynamic(DynamicIndex index, void* param)
 {
-  if(index == "DYNAMIC_INDEX_CLOCK")
+  switch(index)
+  {
+  case DYNAMIC_INDEX_CLOCK:
   {
     media->Get(SETTINGS_INDEX_CLOCK, static_cast<Clock*>(param));
     return SUCCESS;
   }
 
-  if(index == "DYNAMIC_INDEX_BITRATE")
+  case DYNAMIC_INDEX_BITRATE:
   {
     Bitrate mediaBitrate;
     media->Get(SETTINGS_INDEX_BITRATE, &mediaBitrate);
@@ -1164,13 +1555,13 @@ ErrorType EncModule::GetDynamic(std::string index, void* param)
     return SUCCESS;
   }
 
-  if(index == "DYNAMIC_INDEX_GOP")
+  case DYNAMIC_INDEX_GOP:
   {
     media->Get(SETTINGS_INDEX_GROUP_OF_PICTURES, static_cast<Gop*>(param));
     return SUCCESS;
   }
 
-  if(index == "DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_BUFFER_FILL")
+  case DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_BUFFER_FILL:
   {
     assert(roiCtx);
     uint8_t* bufferToFill = static_cast<uint8_t*>(param);
@@ -1178,7 +1569,7 @@ ErrorType EncModule::GetDynamic(std::string index, void* param)
     return SUCCESS;
   }
 
-  if(index == "DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_BUFFER_SIZE")
+  case DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_BUFFER_SIZE:
   {
     Resolution mediaResolution;
     media->Get(SETTINGS_INDEX_RESOLUTION, &mediaResolution);
@@ -1187,15 +1578,31 @@ ErrorType EncModule::GetDynamic(std::string index, void* param)
     return SUCCESS;
   }
 
+  case DYNAMIC_INDEX_QUANTIZATION_PARAMETER_TABLE:
+  {
+    Resolution mediaResolution;
+    media->Get(SETTINGS_INDEX_RESOLUTION, &mediaResolution);
+    auto lcuSize = 1 << media->settings.tChParam[0].uMaxCuSize;
+    auto layout = static_cast<QuantizationParameterTableLayout*>(param);
+    layout->size = (RoundUp(mediaResolution.width, lcuSize) / lcuSize) * (RoundUp(mediaResolution.height, lcuSize) / lcuSize);
+    layout->offset = EP2_BUF_QP_BY_MB.Offset;
+    AL_TDimension tDim = { mediaResolution.width, mediaResolution.height };
+    layout->dmaSize = AL_GetAllocSizeEP2(tDim, media->settings.tChParam[0].uMaxCuSize);
+    return SUCCESS;
+  }
+  default:
+    break;
+  }
+
   return ERROR_NOT_IMPLEMENTED;
 }
 
 #if AL_ENABLE_TWOPASS
 
-void GenericEncoder::ProcessLookAheadParams(AL_TBuffer* src)
+void GenericEncoder::ProcessLookAheadParams(LookAheadFrame const& frame)
 {
-  auto pPictureMetaLA = (AL_TLookAheadMetaData*)AL_Buffer_GetMetaData(src, AL_META_TYPE_LOOKAHEAD);
-  auto fifoSize = (int)fifo.size();
+  auto pPictureMetaLA = (AL_TLookAheadMetaData*)frame.meta;
+  auto fifoSize = fifo.Size();
 
   if(pPictureMetaLA)
   {
@@ -1204,11 +1611,12 @@ void GenericEncoder::ProcessLookAheadParams(AL_TBuffer* src)
 
     if(fifoSize >= 1)
     {
-      pPictureMetaLA->bNextSceneChange = AL_TwoPassMngr_SceneChangeDetected(src, fifo[0]);
-      pPictureMetaLA->iIPRatio = AL_TwoPassMngr_GetIPRatio(src, fifo[0]);
+      auto pNextMetaLA = (AL_TLookAheadMetaData*)fifo[0].meta;
+      pPictureMetaLA->bNextSceneChange = AL_TwoPassMngr_SceneChangeDetected(pPictureMetaLA, pNextMetaLA);
+      pPictureMetaLA->iIPRatio = AL_TwoPassMngr_GetIPRatio(pPictureMetaLA, pNextMetaLA);
 
       for(int i = 1; (i < std::min(fifoSize, 3)); i++)
-        pPictureMetaLA->iIPRatio = std::min(pPictureMetaLA->iIPRatio, AL_TwoPassMngr_GetIPRatio(src, fifo[i]));
+        pPictureMetaLA->iIPRatio = std::min(pPictureMetaLA->iIPRatio, AL_TwoPassMngr_GetIPRatio(pPictureMetaLA, (AL_TLookAheadMetaData*)fifo[i].meta));
     }
   }
 }
@@ -1216,24 +1624,16 @@ void GenericEncoder::ProcessLookAheadParams(AL_TBuffer* src)
 void GenericEncoder::ComputeComplexity(bool isEOS)
 {
   lookAheadParams.complexityCount++;
-  int fifoSize = static_cast<int>(fifo.size());
+  int fifoSize = fifo.Size();
 
   if(lookAheadParams.complexityCount >= 5 && (isEOS || fifoSize == lookAheadParams.fifoSize))
   {
     lookAheadParams.complexityCount = 0;
     lookAheadParams.complexity = 1000;
 
-    if(fifoSize >= 5 && AL_Buffer_GetMetaData(fifo.front(), AL_META_TYPE_LOOKAHEAD))
+    if(fifoSize >= LookAheadFifo::HEAD_SIZE && fifo[0].meta && fifo.totalPictureSize)
     {
-      int iComp[2] = { 0, 0 };
-
-      for(int i = 0; i < fifoSize; i++)
-      {
-        auto pPictureMetaLA = (AL_TLookAheadMetaData*)AL_Buffer_GetMetaData(fifo[i], AL_META_TYPE_LOOKAHEAD);
-        iComp[(i < 5) ? 0 : 1] += pPictureMetaLA->iPictureSize;
-      }
-
-      lookAheadParams.complexity = ((1000 * fifoSize / 5) + lookAheadParams.complexityDiff) * iComp[0] / (iComp[0] + iComp[1]);
+      lookAheadParams.complexity = static_cast<int>(((1000 * fifoSize / LookAheadFifo::HEAD_SIZE) + lookAheadParams.complexityDiff) * fifo.headPictureSize / fifo.totalPictureSize);
       lookAheadParams.complexityDiff += (1000 - lookAheadParams.complexity);
     }
   }
@@ -1241,19 +1641,99 @@ void GenericEncoder::ComputeComplexity(bool isEOS)
 
 #endif
 
-void EncModule::_ProcessEmptyFifo(void* data)
+void EncModule::_ProcessEmptyFifo(int index, void* src)
+{
+  EmptyFifo(encoders[index], static_cast<AL_TBuffer*>(src));
+}
+
+void EncModule::_DeleteEmptyFifo(void* src)
 {
-  auto param = static_cast<EmptyFifoParam*>(data);
-  assert(param);
-  assert(param->encoder);
-  GenericEncoder& encoder = *(param->encoder);
-  EmptyFifo(encoder, param->isEOS);
-  delete param;
+  if(src)
+    AL_Buffer_Unref(static_cast<AL_TBuffer*>(src));
+}
+
+/* The frame is pushed once analyzed, so the scene changes with it and the notification has no distance */
+void EncModule::_ProcessSceneChange(void* data)
+{
+  auto encoder = encoders.front().enc;
+
+  if(data == &sceneChangeSettings)
+  {
+    PopSceneChangeSetting()(encoder);
+    return;
+  }
+
+  auto input = static_cast<AL_TBuffer*>(data);
+
+  if(!input)
+  {
+    AL_Encoder_Process(encoder, nullptr, nullptr);
+    return;
+  }
+
+  if(sceneChangeDetector->IsSceneChange(AL_Buffer_GetData(input)))
+    AL_Encoder_NotifySceneChange(encoder, 0);
+
+  auto roiBuffer = slots[GetSlot(input)].pendingRoi.exchange(nullptr, memory_order_acq_rel);
+
+  if(!AL_Encoder_Process(encoder, input, roiBuffer))
+  {
+    // the encoder didn't take the frame, nobody else gives it back
+    auto errorCode = AL_Encoder_GetLastError(encoder);
+    LOGE("Failed to push the frame to the encoder");
+    ReleaseBuf(input, runBufferHandles.input == BufferHandleType::BUFFER_HANDLE_FD, true);
+    callbacks.event(CALLBACK_EVENT_ERROR, (void*)(errorCode != AL_SUCCESS ? ToModuleError(errorCode) : ERROR_UNDEFINED));
+  }
+
+  if(roiBuffer)
+    AL_Buffer_Unref(roiBuffer);
+}
+
+void EncModule::_DeleteSceneChange(void* data)
+{
+  if(data == &sceneChangeSettings)
+  {
+    PopSceneChangeSetting();
+    return;
+  }
+
+  auto input = static_cast<AL_TBuffer*>(data);
+
+  if(!input)
+    return;
+
+  auto roiBuffer = slots[GetSlot(input)].pendingRoi.exchange(nullptr, memory_order_acq_rel);
+
+  if(roiBuffer)
+    AL_Buffer_Unref(roiBuffer);
+
+  ReleaseBuf(input, runBufferHandles.input == BufferHandleType::BUFFER_HANDLE_FD, true);
+}
+
+/* Without the strand the setting applies now, with it the setting waits for the frames given before it.
+ * The queue of settings marks its place among the frames */
+void EncModule::ApplyInFrameOrder(function<void(AL_HEncoder)> setting)
+{
+  if(!sceneChangeStrand)
+  {
+    setting(encoders.back().enc);
+    return;
+  }
+
+  {
+    lock_guard<mutex> lock(sceneChangeSettingsMutex);
+    sceneChangeSettings.push_back(move(setting));
+  }
+
+  sceneChangeStrand->queue(&sceneChangeSettings);
 }
 
-void EncModule::_DeleteEmptyFifo(void* data)
+function<void(AL_HEncoder)> EncModule::PopSceneChangeSetting()
 {
-  auto param = static_cast<EmptyFifoParam*>(data);
-  delete param;
+  lock_guard<mutex> lock(sceneChangeSettingsMutex);
+  assert(!sceneChangeSettings.empty());
+  auto setting = move(sceneChangeSettings.front());
+  sceneChangeSettings.pop_front();
+  return setting;
 }
 
@@ -43,16 +43,24 @@
 #include "omx_module_codec_structs.h"
 
 #include "ROIMngr.h"
+#include "RoiMapHistory.h"
+#include "QuantizationParameterTables.h"
+#include "SceneChangeDetector.h"
+#include "LookAheadFifo.h"
 
 #include <cstring>
 #include <vector>
 #include <deque>
+#include <functional>
 #include <list>
 #include <future>
 #include <memory>
+#include <mutex>
+#include <atomic>
 
-#include "base/omx_utils/threadsafe_map.h"
-#include "base/omx_utils/processor_fifo.h"
+#include "base/omx_utils/flat_map.h"
+#include "base/omx_utils/processor_pool.h"
+#include "base/omx_utils/slot_registry.h"
 #include "base/omx_mediatype/omx_mediatype_enc_interface.h"
 
 #if AL_ENABLE_TWOPASS
@@ -90,6 +98,41 @@ struct LookAheadParams
   int complexityDiff;
 };
 
+/* Bytes moved to compact the stream sections, the fast path hands them as is */
+struct StreamStats
+{
+  uint64_t frames = 0;
+  uint64_t bytesMoved = 0;
+};
+
+/* QP table of one frame: host copy or dmabuf import, a null handle is for the next frame */
+struct QuantizationParameterTable
+{
+  BufferHandleInterface* handle;
+  uint8_t const* table;
+  int size;
+  int fd;
+};
+
+struct QuantizationParameterTableLayout
+{
+  int size;
+  int offset;
+  int dmaSize;
+};
+
+/* Bookkeeping of one buffer header, at the slot given when its encoder buffer is created.
+ * The encoder buffer carries the slot in its user data, the header in its slot field. */
+struct EncBufferSlot
+{
+  std::atomic<BufferHandleInterface*> owner;
+  std::atomic<AL_TBuffer*> cached; // one reference as long as the header
+  std::atomic<AL_TBuffer*> used; // one reference while the header is queued
+  std::atomic<BufferHandleInterface*> inFlight; // handed back when the encoder is done with the buffer
+  std::atomic<AL_VADDR> shadowOf; // client memory the buffer is copied from/to
+  std::atomic<AL_TBuffer*> pendingRoi; // ROI buffer of the frame waiting for the scene change analysis
+};
+
 struct GenericEncoder
 {
   GenericEncoder(int pass) : index{pass} {}
@@ -99,12 +142,12 @@ struct GenericEncoder
   int index {};
   std::list<AL_TBuffer*> roiBuffers {};
   std::vector<AL_TBuffer*> streamBuffers {};
-  std::deque<AL_TBuffer*> fifo {};
-  std::shared_ptr<ProcessorFifo> threadFifo {};
+  LookAheadFifo fifo {};
+  std::shared_ptr<ProcessorStrand> lookAheadStrand {};
   LookAheadParams lookAheadParams {};
 
 #if AL_ENABLE_TWOPASS
-  void ProcessLookAheadParams(AL_TBuffer* src);
+  void ProcessLookAheadParams(LookAheadFrame const& frame);
   void ComputeComplexity(bool isEOS);
 #endif
 };
@@ -125,7 +168,7 @@ struct EncModule : public ModuleInterface
 
   bool CreateAndAttachStreamMeta(AL_TBuffer& buf);
   void AddFifo(GenericEncoder& encoder, AL_TBuffer* src);
-  void EmptyFifo(GenericEncoder& encoder, bool isEOS);
+  void EmptyFifo(GenericEncoder& encoder, AL_TBuffer* src);
 
   bool CheckParam() override;
   bool Create() override;
@@ -140,6 +183,10 @@ struct EncModule : public ModuleInterface
   bool UseDMA(BufferHandleInterface* handle, int fd, int size);
   void UnuseDMA(BufferHandleInterface* handle);
 
+  /* Drop the encoder buffer cached for this handle (FreeBuffer) */
+  void InvalidateBuffer(BufferHandleInterface* handle);
+  void InvalidateBuffers();
+
   bool Empty(BufferHandleInterface* handle) override;
   bool Fill(BufferHandleInterface* handle) override;
   Flags GetFlags(BufferHandleInterface* handle);
@@ -148,8 +195,8 @@ struct EncModule : public ModuleInterface
   bool Flush() override;
   void Stop() override;
 
-  ErrorType SetDynamic(std::string index, void const* param) override;
-  ErrorType GetDynamic(std::string index, void* param) override;
+  ErrorType SetDynamic(DynamicIndex index, void const* param) override;
+  ErrorType GetDynamic(DynamicIndex index, void* param) override;
 
 private:
   std::shared_ptr<EncMediatypeInterface> const media;
@@ -160,11 +207,39 @@ private:
   Callbacks callbacks;
 
   AL_TRoiMngrCtx* roiCtx;
+
+  /* the lookahead workers hand the ROI buffers over to the next pass */
+  std::mutex roiBuffersMutex;
+
+  /* encoder ROI buffers are recycled: a buffer is only patched with the map changes since it was written */
+  std::mutex roiPoolMutex;
+  std::vector<AL_TBuffer*> roiPool;
+  FlatMap<AL_TBuffer*, uint32_t> roiGenerations;
+  RoiMapHistory roiHistory;
   EOSHandles<BufferHandleInterface*> eosHandles;
+  StreamStats streamStats;
+
+  /* optional: the input frames go through a strand of the shared pool that analyzes their luma
+   * then pushes them, Empty returns without waiting for the analysis */
+  std::unique_ptr<SceneChangeDetector> sceneChangeDetector;
+  std::shared_ptr<ProcessorStrand> sceneChangeStrand;
+
+  /* encoder settings changed while the frames are analyzed: the strand applies them behind the frames already given */
+  std::mutex sceneChangeSettingsMutex;
+  std::deque<std::function<void(AL_HEncoder)>> sceneChangeSettings;
+
+  /* immutable while executing: read once when the encoder is created instead of every frame */
+  BufferHandles runBufferHandles;
+  Resolution runResolution;
 
   void InitEncoders(int numPass);
   bool Use(BufferHandleInterface* handle, uint8_t* buffer, int size);
   void Unuse(BufferHandleInterface* handle);
+  AL_TBuffer* GetCachedBuffer(BufferHandleInterface* handle, int size);
+  void CacheBuffer(BufferHandleInterface* handle, AL_TBuffer* encoderBuffer, AL_VADDR shadowOf);
+  int FindSlot(BufferHandleInterface* handle);
+  AL_TBuffer* GetUsedBuffer(BufferHandleInterface* handle);
+  void ReleaseSlot(int slot);
   ErrorType CreateEncoder();
   bool DestroyEncoder();
   bool isCreated;
@@ -185,23 +260,27 @@ private:
     pThis->EndEncodingLookAhead(pStream, pSource, params->index);
   };
   void EndEncodingLookAhead(AL_TBuffer* pStream, AL_TBuffer const* pSource, int index);
-  void _ProcessEmptyFifo(void* data);
-  void _DeleteEmptyFifo(void* data);
+  void _ProcessEmptyFifo(int index, void* src);
+  void _DeleteEmptyFifo(void* src);
+  void _ProcessSceneChange(void* input);
+  void _DeleteSceneChange(void* input);
+  void ApplyInFrameOrder(std::function<void(AL_HEncoder)> setting);
+  std::function<void(AL_HEncoder)> PopSceneChangeSetting();
   void FlushEosHandles();
 
-  ThreadSafeMap<AL_TBuffer const*, BufferHandleInterface*> handles;
-  ThreadSafeMap<void*, AL_HANDLE> allocated;
-  ThreadSafeMap<int, AL_HANDLE> allocatedDMA;
-  ThreadSafeMap<AL_TBuffer*, AL_VADDR> shouldBeCopied;
-  ThreadSafeMap<BufferHandleInterface*, AL_TBuffer*> pool;
-};
-
-struct EmptyFifoParam
-{
-  EmptyFifoParam(GenericEncoder* encoder, bool isEOS) :
-    encoder{encoder}, isEOS{isEOS} {};
-
-  GenericEncoder* encoder;
-  bool isEOS;
+  static void RedirectionRoiBufferRelease(AL_TBuffer* roiBuffer)
+  {
+    auto pThis = static_cast<EncModule*>(AL_Buffer_GetUserData(roiBuffer));
+    pThis->ReleaseRoiBuffer(roiBuffer);
+  };
+  AL_TBuffer* GetRoiBuffer();
+  void ReleaseRoiBuffer(AL_TBuffer* roiBuffer);
+  void DestroyRoiBuffers();
+  AL_TBuffer* CreateQuantizationParameterTable(QuantizationParameterTable const& table);
+
+  SlotRegistry<EncBufferSlot> slots;
+  FlatMap<void*, AL_HANDLE> allocated;
+  FlatMap<int, AL_HANDLE> allocatedDMA;
+  QuantizationParameterTables qpTables;
 };
 
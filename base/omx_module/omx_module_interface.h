@@ -93,18 +93,24 @@ static std::map<ErrorType, const char*> ToStringError
   },
 };
 
-#define DYNAMIC_INDEX_GOP "DYNAMIC_INDEX_GOP"
-#define DYNAMIC_INDEX_INSERT_IDR "DYNAMIC_INDEX_INSERT_IDR"
-#define DYNAMIC_INDEX_CLOCK "DYNAMIC_INDEX_CLOCK"
-#define DYNAMIC_INDEX_BITRATE "DYNAMIC_INDEX_BITRATE"
-#define DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_BUFFER_SIZE "DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_BUFFER_SIZE"
-#define DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_BUFFER_FILL "DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_BUFFER_FILL"
-#define DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_BUFFER_EMPTY "DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_BUFFER_EMPTY"
-#define DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_ADD "DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_ADD"
-#define DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_CLEAR "DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_CLEAR"
-#define DYNAMIC_INDEX_NOTIFY_SCENE_CHANGE "DYNAMIC_INDEX_NOTIFY_SCENE_CHANGE"
-#define DYNAMIC_INDEX_IS_LONG_TERM "DYNAMIC_INDEX_IS_LONG_TERM"
-#define DYNAMIC_INDEX_USE_LONG_TERM "DYNAMIC_INDEX_USE_LONG_TERM"
+enum DynamicIndex
+{
+  DYNAMIC_INDEX_GOP,
+  DYNAMIC_INDEX_INSERT_IDR,
+  DYNAMIC_INDEX_CLOCK,
+  DYNAMIC_INDEX_BITRATE,
+  DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_BUFFER_SIZE,
+  DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_BUFFER_FILL,
+  DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_BUFFER_EMPTY,
+  DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_BUFFER_PUSH,
+  DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_ADD,
+  DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_CLEAR,
+  DYNAMIC_INDEX_NOTIFY_SCENE_CHANGE,
+  DYNAMIC_INDEX_IS_LONG_TERM,
+  DYNAMIC_INDEX_USE_LONG_TERM,
+  DYNAMIC_INDEX_QUANTIZATION_PARAMETER_TABLE,
+  DYNAMIC_INDEX_MAX,
+};
 
 enum CallbackEventType
 {
@@ -158,7 +164,7 @@ struct ModuleInterface
   virtual bool Flush() = 0;
   virtual void Stop() = 0;
 
-  virtual ErrorType SetDynamic(std::string index, void const* param) = 0;
-  virtual ErrorType GetDynamic(std::string index, void* param) = 0;
+  virtual ErrorType SetDynamic(DynamicIndex index, void const* param) = 0;
+  virtual ErrorType GetDynamic(DynamicIndex index, void* param) = 0;
 };
 
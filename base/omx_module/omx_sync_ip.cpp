@@ -63,15 +63,27 @@ using namespace std;
 static char const* syncDevice = "/dev/xvsfsync0";
 static constexpr bool usingDummy = false;
 
+/* without the hardware, a simulated producer writes the framebuffers at 60 fps
+ * while a sync ip holds the device */
+static DummyDriver* initDummyDriver()
+{
+  auto driver = AL_InitDummyDriver(true, 4);
+  driver->StartSimulation(DummySyncSimulation {});
+  return driver;
+}
+
 AL_TDriver* getDriver()
 {
   if(usingDummy)
-    return AL_InitDummyDriver(true, 4);
+  {
+    static auto dummyDriver = initDummyDriver();
+    return dummyDriver;
+  }
 
   return AL_GetHardwareDriver();
 }
 
-OMXSyncIp::OMXSyncIp(shared_ptr<MediatypeInterface> media, shared_ptr<AL_TAllocator> allocator) : media(media), allocator(allocator), syncIp(getDriver(), syncDevice), sync{&syncIp, syncIp.getFreeChannel()}
+OMXSyncIp::OMXSyncIp(shared_ptr<MediatypeInterface> media, shared_ptr<AL_TAllocator> allocator) : media(media), allocator(allocator), syncIp(SyncIp::Shared(getDriver(), syncDevice)), sync{syncIp.get(), syncIp->getFreeChannel()}
 {
   assert(media);
   assert(allocator);
@@ -59,7 +59,7 @@ struct OMXSyncIp : SyncIpInterface
 private:
   std::shared_ptr<MediatypeInterface> media;
   std::shared_ptr<AL_TAllocator> allocator;
-  SyncIp syncIp;
+  std::shared_ptr<SyncIp> syncIp;
   SyncChannel sync;
 };
 
@@ -5,6 +5,10 @@ OMX_MODULE_ENC_SRCS+=\
 	$(THIS.omx_module_enc)/omx_device_enc_interface.cpp\
 	$(THIS.omx_module_enc)/omx_device_enc_hardware_mcu.cpp\
 	$(THIS.omx_module_enc)/ROIMngr.cpp\
+	$(THIS.omx_module_enc)/RoiMapHistory.cpp\
+	$(THIS.omx_module_enc)/QuantizationParameterTables.cpp\
+	$(THIS.omx_module_enc)/SceneChangeDetector.cpp\
+	$(THIS.omx_module_enc)/LookAheadFifo.cpp\
 	$(THIS.omx_module_enc)/TwoPassMngr.cpp\
 	$(THIS.omx_module_enc)/omx_convert_module_soft_roi.cpp\
 
@@ -0,0 +1,115 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <deque>
+#include <random>
+
+#include "base/omx_module/LookAheadFifo.h"
+
+using namespace std;
+
+/* the sums as the lookahead computed them before the ring, walking the whole fifo */
+static void ExpectSameAsDequeWalk(LookAheadFifo const& fifo, deque<LookAheadFrame> const& frames)
+{
+  int64_t head = 0;
+  int64_t tail = 0;
+
+  for(int i = 0; i < (int)frames.size(); i++)
+  {
+    (i < LookAheadFifo::HEAD_SIZE ? head : tail) += frames[i].pictureSize;
+    ASSERT_EQ(frames[i].src, fifo[i].src);
+  }
+
+  ASSERT_EQ((int)frames.size(), fifo.Size());
+  ASSERT_EQ(head, fifo.headPictureSize);
+  ASSERT_EQ(head + tail, fifo.totalPictureSize);
+}
+
+TEST(LookAheadFifo, RunningSumsMatchTheDequeWalk)
+{
+  mt19937 random(18);
+  uniform_int_distribution<int> pictureSize(0, 4000000);
+
+  for(int sequence = 0; sequence < 2000; sequence++)
+  {
+    auto depth = uniform_int_distribution<int>(10, 70)(random);
+    LookAheadFifo fifo;
+    fifo.Reset(depth);
+    deque<LookAheadFrame> frames;
+    auto numFrames = uniform_int_distribution<int>(0, 4 * depth)(random);
+
+    // the lookahead pops one frame per push once full, then drains everything on EOS
+    for(int i = 0; i < numFrames; i++)
+    {
+      LookAheadFrame frame { reinterpret_cast<AL_TBuffer*>(static_cast<intptr_t>(i + 1)), nullptr, pictureSize(random) };
+      fifo.Push(frame);
+      frames.push_back(frame);
+      ExpectSameAsDequeWalk(fifo, frames);
+
+      if(fifo.Size() == depth)
+      {
+        ASSERT_EQ(frames.front().src, fifo.Pop().src);
+        frames.pop_front();
+        ExpectSameAsDequeWalk(fifo, frames);
+      }
+    }
+
+    while(!fifo.Empty())
+    {
+      ASSERT_EQ(frames.front().src, fifo.Pop().src);
+      frames.pop_front();
+      ExpectSameAsDequeWalk(fifo, frames);
+    }
+  }
+}
+
+TEST(LookAheadFifo, ResetEmptiesTheRing)
+{
+  LookAheadFifo fifo;
+  fifo.Reset(10);
+
+  for(int i = 0; i < 7; i++)
+    fifo.Push(LookAheadFrame { nullptr, nullptr, 100 });
+
+  fifo.Reset(20);
+  EXPECT_TRUE(fifo.Empty());
+  EXPECT_EQ(0, fifo.headPictureSize);
+  EXPECT_EQ(0, fifo.totalPictureSize);
+}
@@ -0,0 +1,239 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "base/omx_module/QuantizationParameterTables.h"
+
+extern "C"
+{
+#include "lib_common/Allocator.h"
+}
+
+using namespace std;
+
+struct Handle : BufferHandleInterface
+{
+};
+
+/* released tables are destroyed at the end of the test, so a new table never reuses the address of a released one */
+static mutex releasedMutex;
+static vector<AL_TBuffer*> released;
+
+static void ReleaseTable(AL_TBuffer* table)
+{
+  lock_guard<mutex> lock(releasedMutex);
+  released.push_back(table);
+}
+
+static void DestroyReleased()
+{
+  lock_guard<mutex> lock(releasedMutex);
+
+  for(auto table : released)
+    AL_Buffer_Destroy(table);
+
+  released.clear();
+}
+
+/* one reference, as the ROI buffers the module gives */
+static AL_TBuffer* CreateTable()
+{
+  auto table = AL_Buffer_Create_And_Allocate(AL_GetDefaultAllocator(), 64, ReleaseTable);
+  AL_Buffer_Ref(table);
+  return table;
+}
+
+static bool IsReleased(AL_TBuffer* table)
+{
+  lock_guard<mutex> lock(releasedMutex);
+  return find(released.begin(), released.end(), table) != released.end();
+}
+
+static size_t NumReleased()
+{
+  lock_guard<mutex> lock(releasedMutex);
+  return released.size();
+}
+
+static ErrorType Add(QuantizationParameterTables& tables, BufferHandleInterface* handle, AL_TBuffer*& table)
+{
+  table = nullptr;
+  return tables.Add(handle, [&] { return table = CreateTable(); });
+}
+
+TEST(QuantizationParameterTables, TableOfTheFrameThenTableOfTheNextFrame)
+{
+  QuantizationParameterTables tables;
+  Handle frame, other;
+  AL_TBuffer* forFrame;
+  AL_TBuffer* forNext;
+  tables.Open();
+
+  ASSERT_EQ(SUCCESS, Add(tables, &frame, forFrame));
+  ASSERT_EQ(SUCCESS, Add(tables, nullptr, forNext));
+
+  EXPECT_EQ(forFrame, tables.Pop(&frame));
+  EXPECT_EQ(forNext, tables.Pop(&frame));
+  EXPECT_EQ(nullptr, tables.Pop(&frame));
+
+  ASSERT_EQ(SUCCESS, Add(tables, nullptr, forNext));
+  EXPECT_EQ(forNext, tables.Pop(&other));
+  EXPECT_EQ(nullptr, tables.Pop(&other));
+
+  AL_Buffer_Unref(forFrame);
+  AL_Buffer_Unref(forNext);
+  tables.Close();
+  DestroyReleased();
+}
+
+TEST(QuantizationParameterTables, LastTableOfAFrameWins)
+{
+  QuantizationParameterTables tables;
+  Handle frame;
+  AL_TBuffer* first;
+  AL_TBuffer* second;
+  AL_TBuffer* firstNext;
+  AL_TBuffer* secondNext;
+  tables.Open();
+
+  ASSERT_EQ(SUCCESS, Add(tables, &frame, first));
+  ASSERT_EQ(SUCCESS, Add(tables, &frame, second));
+  ASSERT_EQ(SUCCESS, Add(tables, nullptr, firstNext));
+  ASSERT_EQ(SUCCESS, Add(tables, nullptr, secondNext));
+
+  EXPECT_TRUE(IsReleased(first));
+  EXPECT_TRUE(IsReleased(firstNext));
+  EXPECT_FALSE(IsReleased(second));
+  EXPECT_FALSE(IsReleased(secondNext));
+
+  EXPECT_EQ(second, tables.Pop(&frame));
+  EXPECT_EQ(secondNext, tables.Pop(&frame));
+
+  AL_Buffer_Unref(second);
+  AL_Buffer_Unref(secondNext);
+  tables.Close();
+  DestroyReleased();
+}
+
+TEST(QuantizationParameterTables, CloseReleasesThePendingTablesAndRefusesTheNextOnes)
+{
+  QuantizationParameterTables tables;
+  Handle frame;
+  AL_TBuffer* forFrame;
+  AL_TBuffer* forNext;
+  AL_TBuffer* late;
+
+  EXPECT_EQ(ERROR_UNDEFINED, Add(tables, &frame, late)) << "no encoder yet";
+  EXPECT_EQ(nullptr, late);
+
+  tables.Open();
+  ASSERT_EQ(SUCCESS, Add(tables, &frame, forFrame));
+  ASSERT_EQ(SUCCESS, Add(tables, nullptr, forNext));
+  tables.Close();
+
+  EXPECT_TRUE(IsReleased(forFrame));
+  EXPECT_TRUE(IsReleased(forNext));
+  EXPECT_EQ(nullptr, tables.Pop(&frame));
+
+  // a table given once the encoder is destroyed isn't even created
+  EXPECT_EQ(ERROR_UNDEFINED, Add(tables, &frame, late));
+  EXPECT_EQ(nullptr, late);
+
+  tables.Open();
+  ASSERT_EQ(SUCCESS, Add(tables, &frame, forFrame));
+  tables.Close();
+  EXPECT_TRUE(IsReleased(forFrame));
+  DestroyReleased();
+}
+
+TEST(QuantizationParameterTables, FailedCreationIsABadParameter)
+{
+  QuantizationParameterTables tables;
+  Handle frame;
+  tables.Open();
+
+  EXPECT_EQ(ERROR_BAD_PARAMETER, tables.Add(&frame, [] { return static_cast<AL_TBuffer*>(nullptr); }));
+  EXPECT_EQ(nullptr, tables.Pop(&frame));
+  tables.Close();
+}
+
+/* the client thread gives tables while the encoder is created and destroyed: none is left behind */
+TEST(QuantizationParameterTables, TablesGivenWhileTheEncoderIsDestroyedAreReleased)
+{
+  QuantizationParameterTables tables;
+  Handle frames[4];
+  atomic<bool> stop(false);
+  atomic<int> created(0);
+  atomic<int> attempts(0);
+
+  thread client([&]
+  {
+    for(int i = 0; !stop.load(); ++i)
+    {
+      BufferHandleInterface* handle = (i % 5) ? &frames[i % 4] : nullptr;
+      tables.Add(handle, [&] { ++created; return CreateTable(); });
+      ++attempts;
+    }
+  });
+
+  for(int run = 0; run < 2000; ++run)
+  {
+    tables.Open();
+    auto table = tables.Pop(&frames[run % 4]);
+
+    if(table)
+      AL_Buffer_Unref(table);
+    tables.Close();
+  }
+
+  // some tables are given after the last destruction
+  for(auto last = attempts.load(); attempts.load() < last + 100;)
+    this_thread::yield();
+
+  stop.store(true);
+  client.join();
+
+  EXPECT_EQ(static_cast<size_t>(created.load()), NumReleased());
+  DestroyReleased();
+}
@@ -0,0 +1,190 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "base/omx_module/RoiMapHistory.h"
+
+using namespace std;
+
+static AL_ERoiQuality const QUALITIES[] = { AL_ROI_QUALITY_HIGH, AL_ROI_QUALITY_MEDIUM, AL_ROI_QUALITY_LOW, AL_ROI_QUALITY_DONT_CARE };
+static size_t const HISTORY_SIZE = 8;
+
+struct Roi
+{
+  int x;
+  int y;
+  int width;
+  int height;
+  AL_ERoiQuality quality;
+};
+
+struct PooledMap
+{
+  vector<uint8_t> lcus;
+  uint32_t generation;
+};
+
+static Roi RandomRoi(mt19937& random, int width, int height)
+{
+  Roi roi;
+  roi.x = uniform_int_distribution<int>(0, width - 1)(random);
+  roi.y = uniform_int_distribution<int>(0, height - 1)(random);
+  roi.width = uniform_int_distribution<int>(1, width / 2 + 1)(random);
+  roi.height = uniform_int_distribution<int>(1, height / 2 + 1)(random);
+  roi.quality = QUALITIES[uniform_int_distribution<int>(0, 3)(random)];
+  return roi;
+}
+
+/* one frame of the client: some regions are added, moved or removed, then all of them are sent again */
+static void EditRois(mt19937& random, vector<Roi>& rois, int width, int height)
+{
+  auto edits = uniform_int_distribution<int>(0, 3)(random);
+
+  for(int i = 0; i < edits; ++i)
+  {
+    auto edit = uniform_int_distribution<int>(0, 3)(random);
+
+    if(edit == 0 || rois.empty())
+      rois.push_back(RandomRoi(random, width, height));
+    else
+    {
+      auto& roi = rois[uniform_int_distribution<size_t>(0, rois.size() - 1)(random)];
+
+      if(edit == 1)
+      {
+        roi.x = uniform_int_distribution<int>(0, width - 1)(random);
+        roi.y = uniform_int_distribution<int>(0, height - 1)(random);
+      }
+      else if(edit == 2)
+        roi.quality = QUALITIES[uniform_int_distribution<int>(0, 3)(random)];
+      else
+      {
+        roi = rois.back();
+        rois.pop_back();
+      }
+    }
+  }
+}
+
+/* Recycled maps patched with the changes since they were written must match a map filled from scratch */
+TEST(RoiMapHistory, PatchedMapsMatchAFreshFill)
+{
+  mt19937 random(12);
+
+  for(int sequence = 0; sequence < 200; ++sequence)
+  {
+    auto width = uniform_int_distribution<int>(16, 1920)(random);
+    auto height = uniform_int_distribution<int>(16, 1080)(random);
+    auto profile = bernoulli_distribution(0.5)(random) ? AL_PROFILE_AVC_HIGH : AL_PROFILE_HEVC_MAIN;
+    auto order = bernoulli_distribution(0.5)(random) ? AL_ROI_QUALITY_ORDER : AL_ROI_INCOMING_ORDER;
+    auto ctx = AL_RoiMngr_Create(width, height, profile, AL_ROI_QUALITY_MEDIUM, order);
+    ASSERT_NE(nullptr, ctx);
+
+    RoiMapHistory history(HISTORY_SIZE);
+    vector<PooledMap> pool(uniform_int_distribution<int>(1, 12)(random), PooledMap { vector<uint8_t>(ctx->iNumLCUs, 0xEE), 0 });
+    vector<uint8_t> fresh(ctx->iNumLCUs);
+    vector<Roi> rois;
+
+    for(int frame = 0; frame < 100; ++frame)
+    {
+      if(bernoulli_distribution(0.7)(random))
+        EditRois(random, rois, width, height);
+
+      AL_RoiMngr_Clear(ctx);
+
+      for(auto& roi : rois)
+        AL_RoiMngr_AddROI(ctx, roi.x, roi.y, roi.width, roi.height, roi.quality);
+
+      history.Update(ctx);
+
+      /* the buffers don't come back in order, and some were written by the client in between */
+      auto& map = pool[uniform_int_distribution<size_t>(0, pool.size() - 1)(random)];
+
+      if(bernoulli_distribution(0.05)(random))
+        map.generation = 0;
+
+      if(history.CanPatch(map.generation))
+        history.Patch(ctx, map.generation, map.lcus.data());
+      else
+      {
+        AL_TRoiRect all = { 0, 0, ctx->iLcuWidth, ctx->iLcuHeight };
+        AL_RoiMngr_CopyMap(ctx, &all, map.lcus.data());
+      }
+
+      map.generation = history.Generation();
+
+      AL_RoiMngr_FillBuff(ctx, 1, 1, fresh.data());
+      ASSERT_EQ(fresh, map.lcus) << "sequence " << sequence << " frame " << frame;
+    }
+
+    AL_RoiMngr_Destroy(ctx);
+  }
+}
+
+TEST(RoiMapHistory, OnlyRecentMapsCanBePatched)
+{
+  auto ctx = AL_RoiMngr_Create(1920, 1080, AL_PROFILE_HEVC_MAIN, AL_ROI_QUALITY_MEDIUM, AL_ROI_INCOMING_ORDER);
+  RoiMapHistory history(HISTORY_SIZE);
+  auto first = history.Generation();
+
+  EXPECT_FALSE(history.CanPatch(0));
+  EXPECT_TRUE(history.CanPatch(first));
+
+  /* an unchanged map doesn't start a generation */
+  history.Update(ctx);
+  EXPECT_EQ(first, history.Generation());
+
+  for(size_t i = 0; i < HISTORY_SIZE + 1; ++i)
+  {
+    AL_RoiMngr_Clear(ctx);
+    AL_RoiMngr_AddROI(ctx, 64 * i, 0, 64, 64, AL_ROI_QUALITY_HIGH);
+    history.Update(ctx);
+  }
+
+  EXPECT_EQ(first + HISTORY_SIZE + 1, history.Generation());
+  EXPECT_FALSE(history.CanPatch(first));
+  EXPECT_TRUE(history.CanPatch(first + 1));
+
+  history.Reset();
+  EXPECT_EQ(first, history.Generation());
+
+  AL_RoiMngr_Destroy(ctx);
+}
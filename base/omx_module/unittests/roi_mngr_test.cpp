@@ -0,0 +1,379 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "base/omx_module/ROIMngr.h"
+
+using namespace std;
+
+/* AL_RoiMngr_FillBuff before the wide stores, byte per byte, painting the nodes in the given order */
+static int ReferenceClip3(int iVal, int iMin, int iMax)
+{
+  return ((iVal) < (iMin)) ? (iMin) : ((iVal) > (iMax)) ? (iMax) : (iVal);
+}
+
+static int8_t ReferenceGetDQp(uint8_t iDeltaQP)
+{
+  return (int8_t)((iDeltaQP & MASK_QP) << 2) >> 2;
+}
+
+static int8_t ReferenceMeanQuality(AL_TRoiMngrCtx* pCtx, uint8_t iDQp1, uint8_t iDQp2)
+{
+  auto eMask = (iDQp1 & MASK_FORCE_MV0) | (iDQp2 & MASK_FORCE_MV0);
+
+  int8_t iQP = ReferenceClip3((ReferenceGetDQp(iDQp1) + ReferenceGetDQp(iDQp2)) / 2, pCtx->iMinQP, pCtx->iMaxQP) & MASK_QP;
+  return iQP | eMask;
+}
+
+static void ReferenceUpdateTransitionHorz(AL_TRoiMngrCtx* pCtx, uint8_t* pLcu1, uint8_t* pLcu2, int iNumBytesPerLCU, int iLcuWidth, int iPosX, int iWidth, int8_t iQP)
+{
+  if(iPosX > 1)
+    pLcu1[-iNumBytesPerLCU] = ReferenceMeanQuality(pCtx, pLcu2[-2 * iNumBytesPerLCU], iQP);
+  else if(iPosX > 0)
+    pLcu1[-iNumBytesPerLCU] = ReferenceMeanQuality(pCtx, pLcu2[-iNumBytesPerLCU], iQP);
+
+  for(int w = 0; w < iWidth; ++w)
+    pLcu1[w * iNumBytesPerLCU] = ReferenceMeanQuality(pCtx, pLcu2[w * iNumBytesPerLCU], iQP);
+
+  if(iPosX + iWidth + 2 < iLcuWidth)
+    pLcu1[iWidth * iNumBytesPerLCU] = ReferenceMeanQuality(pCtx, pLcu2[(iWidth + 1) * iNumBytesPerLCU], iQP);
+  else if(iPosX + iWidth + 1 < iLcuWidth)
+    pLcu1[iWidth * iNumBytesPerLCU] = ReferenceMeanQuality(pCtx, pLcu2[iWidth * iNumBytesPerLCU], iQP);
+}
+
+static void ReferenceUpdateTransitionVert(AL_TRoiMngrCtx* pCtx, uint8_t* pLcu1, uint8_t* pLcu2, int iNumBytesPerLCU, int iLcuWidth, int iHeight, int8_t iQP)
+{
+  for(int h = 0; h < iHeight; ++h)
+  {
+    *pLcu1 = ReferenceMeanQuality(pCtx, *pLcu2, iQP);
+    pLcu1 += (iLcuWidth * iNumBytesPerLCU);
+    pLcu2 += (iLcuWidth * iNumBytesPerLCU);
+  }
+}
+
+static uint8_t* ReferenceLcu(AL_TRoiMngrCtx* pCtx, uint8_t* pBuf, int iLcuX, int iLcuY, int iNumBytesPerLCU)
+{
+  return pBuf + (iLcuY * pCtx->iLcuWidth + iLcuX) * iNumBytesPerLCU;
+}
+
+static void ReferenceComputeROI(AL_TRoiMngrCtx* pCtx, int iNumQPPerLCU, int iNumBytesPerLCU, uint8_t* pBuf, AL_TRoiNode const* pNode)
+{
+  auto* pLCU = ReferenceLcu(pCtx, pBuf, pNode->iPosX, pNode->iPosY, iNumBytesPerLCU);
+
+  for(int h = 0; h < pNode->iHeight; ++h)
+  {
+    for(int w = 0; w < pNode->iWidth; ++w)
+    {
+      for(int i = 0; i < iNumQPPerLCU; ++i)
+        pLCU[w * iNumBytesPerLCU + i] = pNode->iDeltaQP;
+    }
+
+    pLCU += iNumBytesPerLCU * pCtx->iLcuWidth;
+  }
+
+  if(pNode->iDeltaQP & MASK_FORCE_MV0)
+    return;
+
+  if(pNode->iPosY)
+  {
+    auto* pLcuTop1 = ReferenceLcu(pCtx, pBuf, pNode->iPosX, pNode->iPosY - 1, iNumBytesPerLCU);
+    auto* pLcuTop2 = pNode->iPosY > 1 ? ReferenceLcu(pCtx, pBuf, pNode->iPosX, pNode->iPosY - 2, iNumBytesPerLCU) : pLcuTop1;
+    ReferenceUpdateTransitionHorz(pCtx, pLcuTop1, pLcuTop2, iNumBytesPerLCU, pCtx->iLcuWidth, pNode->iPosX, pNode->iWidth, pNode->iDeltaQP);
+  }
+
+  if(pNode->iPosY + pNode->iHeight + 1 < pCtx->iLcuHeight)
+  {
+    auto* pLcuBot1 = ReferenceLcu(pCtx, pBuf, pNode->iPosX, pNode->iPosY + pNode->iHeight, iNumBytesPerLCU);
+    auto* pLcuBot2 = pNode->iPosY + pNode->iHeight + 2 < pCtx->iLcuHeight ? ReferenceLcu(pCtx, pBuf, pNode->iPosX, pNode->iPosY + pNode->iHeight + 1, iNumBytesPerLCU) : pLcuBot1;
+    ReferenceUpdateTransitionHorz(pCtx, pLcuBot1, pLcuBot2, iNumBytesPerLCU, pCtx->iLcuWidth, pNode->iPosX, pNode->iWidth, pNode->iDeltaQP);
+  }
+
+  if(pNode->iPosX)
+  {
+    auto* pLcuLeft1 = ReferenceLcu(pCtx, pBuf, pNode->iPosX - 1, pNode->iPosY, iNumBytesPerLCU);
+    auto* pLcuLeft2 = pNode->iPosX > 1 ? ReferenceLcu(pCtx, pBuf, pNode->iPosX - 2, pNode->iPosY, iNumBytesPerLCU) : pLcuLeft1;
+    ReferenceUpdateTransitionVert(pCtx, pLcuLeft1, pLcuLeft2, iNumBytesPerLCU, pCtx->iLcuWidth, pNode->iHeight, pNode->iDeltaQP);
+  }
+
+  if(pNode->iPosX + pNode->iWidth + 1 < pCtx->iLcuWidth)
+  {
+    auto* pLcuRight1 = ReferenceLcu(pCtx, pBuf, pNode->iPosX + pNode->iWidth, pNode->iPosY, iNumBytesPerLCU);
+    auto* pLcuRight2 = pNode->iPosX + pNode->iWidth + 2 < pCtx->iLcuWidth ? ReferenceLcu(pCtx, pBuf, pNode->iPosX + pNode->iWidth + 1, pNode->iPosY, iNumBytesPerLCU) : pLcuRight1;
+    ReferenceUpdateTransitionVert(pCtx, pLcuRight1, pLcuRight2, iNumBytesPerLCU, pCtx->iLcuWidth, pNode->iHeight, pNode->iDeltaQP);
+  }
+}
+
+static void ReferenceFillBuff(AL_TRoiMngrCtx* pCtx, vector<AL_TRoiNode> const& nodes, int iNumQPPerLCU, int iNumBytesPerLCU, uint8_t* pBuf)
+{
+  // GetNewDeltaQP: the sign extension of the quality keeps its 6 low bits
+  uint8_t uBkgQP = pCtx->eBkgQuality == MASK_FORCE_MV0 ? MASK_FORCE_MV0 : pCtx->eBkgQuality & MASK_QP;
+
+  for(int iLCU = 0; iLCU < pCtx->iNumLCUs; iLCU++)
+  {
+    int iFirst = iLCU * iNumBytesPerLCU;
+
+    for(int iQP = 0; iQP < iNumQPPerLCU; ++iQP)
+      pBuf[iFirst + iQP] = uBkgQP;
+  }
+
+  for(auto& node : nodes)
+    ReferenceComputeROI(pCtx, iNumQPPerLCU, iNumBytesPerLCU, pBuf, &node);
+}
+
+/* the nodes in painting order, as sorted by the last fill */
+static vector<AL_TRoiNode> PaintedNodes(AL_TRoiMngrCtx* pCtx)
+{
+  return vector<AL_TRoiNode>(pCtx->pNodes, pCtx->pNodes + pCtx->iNumNodes);
+}
+
+static AL_ERoiQuality const QUALITIES[] = { AL_ROI_QUALITY_HIGH, AL_ROI_QUALITY_MEDIUM, AL_ROI_QUALITY_LOW, AL_ROI_QUALITY_DONT_CARE };
+static uint8_t const UNTOUCHED = 0xEE;
+
+static AL_TRoiMngrCtx* CreateRandomLayout(mt19937& random)
+{
+  uniform_int_distribution<int> dimension(16, 4096);
+  uniform_int_distribution<int> quality(0, 3);
+  uniform_int_distribution<int> numRois(0, 8);
+  bernoulli_distribution isAvc(0.5), isQualityOrder(0.5);
+
+  auto width = dimension(random);
+  auto height = dimension(random);
+  auto ctx = AL_RoiMngr_Create(width, height, isAvc(random) ? AL_PROFILE_AVC_HIGH : AL_PROFILE_HEVC_MAIN, QUALITIES[quality(random)],
+                               isQualityOrder(random) ? AL_ROI_QUALITY_ORDER : AL_ROI_INCOMING_ORDER);
+
+  for(int i = numRois(random); i > 0; --i)
+  {
+    auto posX = uniform_int_distribution<int>(0, width - 1)(random);
+    auto posY = uniform_int_distribution<int>(0, height - 1)(random);
+    auto roiWidth = uniform_int_distribution<int>(1, width)(random);
+    auto roiHeight = uniform_int_distribution<int>(1, height)(random);
+    AL_RoiMngr_AddROI(ctx, posX, posY, roiWidth, roiHeight, QUALITIES[quality(random)]);
+  }
+
+  return ctx;
+}
+
+/* Packed LCUs go through the memset path of FillLCUs, LCUs with gap bytes through the per LCU loop:
+ * both must write the same QPs and the loop must leave the gaps alone */
+TEST(RoiMngr, PackedFillMatchesThePerLcuLoop)
+{
+  mt19937 random(11);
+
+  for(int i = 0; i < 3000; ++i)
+  {
+    auto ctx = CreateRandomLayout(random);
+    auto numQPPerLCU = (i % 2) ? 4 : 1;
+    auto numBytesPerLCU = numQPPerLCU + 3;
+
+    vector<uint8_t> packed(ctx->iNumLCUs * numQPPerLCU, UNTOUCHED);
+    vector<uint8_t> strided(ctx->iNumLCUs * numBytesPerLCU, UNTOUCHED);
+    AL_RoiMngr_FillBuff(ctx, numQPPerLCU, numQPPerLCU, packed.data());
+    AL_RoiMngr_FillBuff(ctx, numQPPerLCU, numBytesPerLCU, strided.data());
+
+    for(int lcu = 0; lcu < ctx->iNumLCUs; ++lcu)
+    {
+      for(int byte = 0; byte < numBytesPerLCU; ++byte)
+      {
+        auto expected = byte < numQPPerLCU ? packed[lcu * numQPPerLCU + byte] : UNTOUCHED;
+        ASSERT_EQ(expected, strided[lcu * numBytesPerLCU + byte]) << "layout " << i << " lcu " << lcu << " byte " << byte;
+      }
+    }
+
+    AL_RoiMngr_Destroy(ctx);
+  }
+}
+
+
+TEST(RoiMngr, FillBuffMatchesTheByteLoop)
+{
+  mt19937 random(12);
+
+  for(int i = 0; i < 3000; ++i)
+  {
+    auto ctx = CreateRandomLayout(random);
+    auto numQPPerLCU = (i % 2) ? 4 : 1;
+    auto numBytesPerLCU = (i % 3) ? numQPPerLCU : numQPPerLCU + 3;
+
+    vector<uint8_t> actual(ctx->iNumLCUs * numBytesPerLCU, UNTOUCHED);
+    vector<uint8_t> expected(ctx->iNumLCUs * numBytesPerLCU, UNTOUCHED);
+    AL_RoiMngr_FillBuff(ctx, numQPPerLCU, numBytesPerLCU, actual.data());
+    ReferenceFillBuff(ctx, PaintedNodes(ctx), numQPPerLCU, numBytesPerLCU, expected.data());
+
+    ASSERT_EQ(expected, actual) << "layout " << i;
+    AL_RoiMngr_Destroy(ctx);
+  }
+}
+
+TEST(RoiMngrBenchmark, FillBuffAgainstTheByteLoop)
+{
+  int const numFills = 200;
+  auto ctx = AL_RoiMngr_Create(3840, 2160, AL_PROFILE_AVC_HIGH, AL_ROI_QUALITY_MEDIUM, AL_ROI_QUALITY_ORDER);
+  mt19937 random(13);
+
+  for(int i = 0; i < 8; ++i)
+  {
+    auto posX = uniform_int_distribution<int>(0, 3000)(random);
+    auto posY = uniform_int_distribution<int>(0, 1600)(random);
+    AL_RoiMngr_AddROI(ctx, posX, posY, 800, 500, QUALITIES[i % 4]);
+  }
+
+  for(auto numQPPerLCU : { 1, 4 })
+  {
+    vector<uint8_t> buf(ctx->iNumLCUs * numQPPerLCU);
+    AL_RoiMngr_FillBuff(ctx, numQPPerLCU, numQPPerLCU, buf.data());
+    auto nodes = PaintedNodes(ctx);
+
+    auto start = chrono::steady_clock::now();
+
+    for(int i = 0; i < numFills; ++i)
+      ReferenceFillBuff(ctx, nodes, numQPPerLCU, numQPPerLCU, buf.data());
+
+    auto reference = chrono::steady_clock::now() - start;
+    start = chrono::steady_clock::now();
+
+    for(int i = 0; i < numFills; ++i)
+      AL_RoiMngr_FillBuff(ctx, numQPPerLCU, numQPPerLCU, buf.data());
+
+    auto fill = chrono::steady_clock::now() - start;
+
+    auto referenceUs = chrono::duration_cast<chrono::microseconds>(reference).count() / numFills;
+    auto fillUs = chrono::duration_cast<chrono::microseconds>(fill).count() / numFills;
+    cout << "2160p, " << numQPPerLCU << " QP per LCU: byte loop " << referenceUs << " us, wide stores " << fillUs << " us" << endl;
+    RecordProperty(numQPPerLCU == 1 ? "byte_loop_1qp_us" : "byte_loop_4qp_us", (int)referenceUs);
+    RecordProperty(numQPPerLCU == 1 ? "fill_1qp_us" : "fill_4qp_us", (int)fillUs);
+  }
+
+  AL_RoiMngr_Destroy(ctx);
+}
+
+static uint8_t QpOf(AL_ERoiQuality quality)
+{
+  return quality & MASK_QP;
+}
+
+static vector<uint8_t> FillMap(AL_TRoiMngrCtx* ctx)
+{
+  vector<uint8_t> map(ctx->iNumLCUs);
+  AL_RoiMngr_FillBuff(ctx, 1, 1, map.data());
+  return map;
+}
+
+static uint8_t QpAt(AL_TRoiMngrCtx* ctx, vector<uint8_t> const& map, int pixelX, int pixelY)
+{
+  return map[(pixelY >> ctx->uLcuSize) * ctx->iLcuWidth + (pixelX >> ctx->uLcuSize)];
+}
+
+struct Region
+{
+  int x;
+  int y;
+  int width;
+  int height;
+};
+
+/* 1080p HEVC: 20x10 and 20x10 LCUs, overlapping on 10x8 LCUs around (800, 500) */
+static Region const FIRST = { 320, 320, 640, 320 };
+static Region const SECOND = { 640, 384, 640, 320 };
+static int const OVERLAP_X = 800;
+static int const OVERLAP_Y = 500;
+
+/* two LCUs right of FIRST: the transitions of both regions meet */
+static Region const NEIGHBOUR = { 1024, 320, 320, 320 };
+
+static vector<uint8_t> PaintTwo(AL_ERoiOrder order, Region const& first, AL_ERoiQuality firstQuality, Region const& second, AL_ERoiQuality secondQuality)
+{
+  auto ctx = AL_RoiMngr_Create(1920, 1080, AL_PROFILE_HEVC_MAIN, AL_ROI_QUALITY_MEDIUM, order);
+  AL_RoiMngr_AddROI(ctx, first.x, first.y, first.width, first.height, firstQuality);
+  AL_RoiMngr_AddROI(ctx, second.x, second.y, second.width, second.height, secondQuality);
+  auto map = FillMap(ctx);
+  AL_RoiMngr_Destroy(ctx);
+  return map;
+}
+
+/* In quality order the best quality wins the overlap whatever the order of the regions,
+ * in incoming order the last region wins */
+TEST(RoiMngr, OverlapOfDifferentQualities)
+{
+  auto ctx = AL_RoiMngr_Create(1920, 1080, AL_PROFILE_HEVC_MAIN, AL_ROI_QUALITY_MEDIUM, AL_ROI_QUALITY_ORDER);
+
+  EXPECT_EQ(QpOf(AL_ROI_QUALITY_HIGH), QpAt(ctx, PaintTwo(AL_ROI_QUALITY_ORDER, FIRST, AL_ROI_QUALITY_HIGH, SECOND, AL_ROI_QUALITY_LOW), OVERLAP_X, OVERLAP_Y));
+  EXPECT_EQ(QpOf(AL_ROI_QUALITY_HIGH), QpAt(ctx, PaintTwo(AL_ROI_QUALITY_ORDER, FIRST, AL_ROI_QUALITY_LOW, SECOND, AL_ROI_QUALITY_HIGH), OVERLAP_X, OVERLAP_Y));
+  EXPECT_EQ(QpOf(AL_ROI_QUALITY_LOW), QpAt(ctx, PaintTwo(AL_ROI_QUALITY_ORDER, FIRST, AL_ROI_QUALITY_DONT_CARE, SECOND, AL_ROI_QUALITY_LOW), OVERLAP_X, OVERLAP_Y));
+
+  EXPECT_EQ(QpOf(AL_ROI_QUALITY_LOW), QpAt(ctx, PaintTwo(AL_ROI_INCOMING_ORDER, FIRST, AL_ROI_QUALITY_HIGH, SECOND, AL_ROI_QUALITY_LOW), OVERLAP_X, OVERLAP_Y));
+  EXPECT_EQ(QpOf(AL_ROI_QUALITY_HIGH), QpAt(ctx, PaintTwo(AL_ROI_INCOMING_ORDER, FIRST, AL_ROI_QUALITY_LOW, SECOND, AL_ROI_QUALITY_HIGH), OVERLAP_X, OVERLAP_Y));
+
+  AL_RoiMngr_Destroy(ctx);
+}
+
+/* Among equal qualities the first region is painted last: the map is the one of the
+ * regions painted in the reverse order. Their transitions meet, the order is visible */
+TEST(RoiMngr, EqualQualitiesKeepTheFirstRegionOnTop)
+{
+  for(auto quality : QUALITIES)
+  {
+    auto byQuality = PaintTwo(AL_ROI_QUALITY_ORDER, FIRST, quality, NEIGHBOUR, quality);
+    auto firstOnTop = PaintTwo(AL_ROI_INCOMING_ORDER, NEIGHBOUR, quality, FIRST, quality);
+    EXPECT_EQ(firstOnTop, byQuality) << "quality " << quality;
+  }
+
+  EXPECT_NE(PaintTwo(AL_ROI_INCOMING_ORDER, FIRST, AL_ROI_QUALITY_HIGH, NEIGHBOUR, AL_ROI_QUALITY_HIGH),
+            PaintTwo(AL_ROI_QUALITY_ORDER, FIRST, AL_ROI_QUALITY_HIGH, NEIGHBOUR, AL_ROI_QUALITY_HIGH));
+}
+
+/* A region sorted between two others used to be unlinked from the painting list */
+TEST(RoiMngr, QualityOrderPaintsEveryRegion)
+{
+  auto ctx = AL_RoiMngr_Create(1920, 1080, AL_PROFILE_HEVC_MAIN, AL_ROI_QUALITY_MEDIUM, AL_ROI_QUALITY_ORDER);
+  AL_RoiMngr_AddROI(ctx, 0, 0, 320, 320, AL_ROI_QUALITY_DONT_CARE);
+  AL_RoiMngr_AddROI(ctx, 1280, 0, 320, 320, AL_ROI_QUALITY_HIGH);
+  AL_RoiMngr_AddROI(ctx, 640, 640, 320, 320, AL_ROI_QUALITY_LOW);
+
+  auto map = FillMap(ctx);
+  EXPECT_EQ(QpOf(AL_ROI_QUALITY_DONT_CARE), QpAt(ctx, map, 100, 100));
+  EXPECT_EQ(QpOf(AL_ROI_QUALITY_HIGH), QpAt(ctx, map, 1400, 100));
+  EXPECT_EQ(QpOf(AL_ROI_QUALITY_LOW), QpAt(ctx, map, 800, 800));
+  EXPECT_EQ(QpOf(AL_ROI_QUALITY_MEDIUM), QpAt(ctx, map, 1800, 1000));
+
+  AL_RoiMngr_Destroy(ctx);
+}
@@ -0,0 +1,213 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "base/omx_module/SceneChangeDetector.h"
+
+using namespace std;
+
+static int const WIDTH = 327;
+static int const HEIGHT = 185;
+static int const PITCH = 333;
+static int const BLOCK_SIZE = 8;
+
+/* the plain loops the SIMD paths must match */
+static uint8_t ReferenceReduceBlock(uint8_t const* src, int pitch)
+{
+  int sum = 0;
+
+  for(int row = 0; row < BLOCK_SIZE; ++row)
+  {
+    for(int col = 0; col < BLOCK_SIZE; ++col)
+      sum += src[row * pitch + col];
+  }
+
+  return static_cast<uint8_t>(sum / (BLOCK_SIZE * BLOCK_SIZE));
+}
+
+static int64_t ReferenceDifference(uint8_t const* a, uint8_t const* b, int size)
+{
+  int64_t difference = 0;
+
+  for(int i = 0; i < size; ++i)
+    difference += abs(a[i] - b[i]);
+
+  return difference;
+}
+
+TEST(SceneChangeDetector, ReduceBlockRowMatchesTheScalarLoop)
+{
+  mt19937 random(20);
+  uniform_int_distribution<int> level(0, 255);
+  vector<uint8_t> luma(PITCH * BLOCK_SIZE + 1);
+
+  for(auto& pixel : luma)
+    pixel = level(random);
+
+  // odd counts of blocks leave a block to the scalar tail, an odd offset unaligns the loads
+  for(int numBlocks = 0; numBlocks <= PITCH / BLOCK_SIZE; ++numBlocks)
+  {
+    vector<uint8_t> blocks(numBlocks);
+    SceneChangeDetector::ReduceBlockRow(luma.data() + 1, PITCH, numBlocks, blocks.data());
+
+    for(int block = 0; block < numBlocks; ++block)
+      ASSERT_EQ(ReferenceReduceBlock(luma.data() + 1 + block * BLOCK_SIZE, PITCH), blocks[block]) << "block " << block << " of " << numBlocks;
+  }
+}
+
+TEST(SceneChangeDetector, ComputeDifferenceMatchesTheScalarLoop)
+{
+  mt19937 random(21);
+  uniform_int_distribution<int> level(0, 255);
+  vector<uint8_t> a(1001);
+  vector<uint8_t> b(1001);
+
+  for(size_t i = 0; i < a.size(); ++i)
+  {
+    a[i] = level(random);
+    b[i] = level(random);
+  }
+
+  for(int size = 0; size < 1000; size += 1 + size / 16)
+  {
+    ASSERT_EQ(ReferenceDifference(a.data() + 1, b.data() + 1, size), SceneChangeDetector::ComputeDifference(a.data() + 1, b.data() + 1, size)) << "size " << size;
+    ASSERT_EQ(ReferenceDifference(a.data(), a.data() + 1, size), SceneChangeDetector::ComputeDifference(a.data(), a.data() + 1, size)) << "size " << size;
+  }
+}
+
+/* A textured scene larger than the frame, the frames are windows on it */
+struct Scene
+{
+  Scene(int seed, int mean, int contrast) : width(4 * WIDTH), height(HEIGHT), levels(width * height)
+  {
+    mt19937 random(seed);
+    uniform_int_distribution<int> noise(-8, 8);
+    uniform_real_distribution<double> period(9.0, 40.0);
+    auto periodX = period(random);
+    auto periodY = period(random);
+
+    for(int y = 0; y < height; ++y)
+    {
+      for(int x = 0; x < width; ++x)
+      {
+        auto level = mean + contrast * sin(x / periodX) * cos(y / periodY) + noise(random);
+        levels[y * width + x] = static_cast<uint8_t>(min(255.0, max(0.0, level)));
+      }
+    }
+  }
+
+  /* the frame at a horizontal offset in the scene, plus a brightness offset */
+  vector<uint8_t> Frame(int offset, int brightness = 0) const
+  {
+    vector<uint8_t> frame(PITCH * HEIGHT, 0);
+
+    for(int y = 0; y < HEIGHT; ++y)
+    {
+      for(int x = 0; x < WIDTH; ++x)
+        frame[y * PITCH + x] = static_cast<uint8_t>(min(255, levels[y * width + x + offset] + brightness));
+    }
+
+    return frame;
+  }
+
+  int const width;
+  int const height;
+  vector<uint8_t> levels;
+};
+
+static vector<int> SceneChanges(vector<vector<uint8_t>> const& frames)
+{
+  SceneChangeDetector detector(WIDTH, HEIGHT, PITCH);
+  vector<int> sceneChanges;
+
+  for(size_t i = 0; i < frames.size(); ++i)
+  {
+    if(detector.IsSceneChange(frames[i].data()))
+      sceneChanges.push_back(i);
+  }
+
+  return sceneChanges;
+}
+
+TEST(SceneChangeDetector, DetectsACut)
+{
+  Scene day(1, 150, 60);
+  Scene night(2, 60, 40);
+  vector<vector<uint8_t>> frames;
+
+  for(int i = 0; i < 12; ++i)
+    frames.push_back(day.Frame(2 * i));
+
+  for(int i = 0; i < 12; ++i)
+    frames.push_back(night.Frame(2 * i));
+
+  EXPECT_EQ(vector<int>({ 12 }), SceneChanges(frames));
+}
+
+TEST(SceneChangeDetector, AFastPanIsTheSameScene)
+{
+  Scene landscape(3, 128, 80);
+  vector<vector<uint8_t>> frames;
+
+  for(int i = 0; i < 40; ++i)
+    frames.push_back(landscape.Frame(24 * i));
+
+  EXPECT_EQ(vector<int>(), SceneChanges(frames));
+}
+
+TEST(SceneChangeDetector, AFlashStartsOneSceneAtMost)
+{
+  Scene room(4, 90, 50);
+  vector<vector<uint8_t>> frames;
+
+  for(int i = 0; i < 10; ++i)
+    frames.push_back(room.Frame(i));
+
+  frames.push_back(room.Frame(10, 120));
+
+  for(int i = 11; i < 20; ++i)
+    frames.push_back(room.Frame(i));
+
+  // the frames after the flash are too close to it to start a scene again
+  EXPECT_EQ(vector<int>({ 10 }), SceneChanges(frames));
+}
@@ -0,0 +1,106 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include "base/omx_module/SyncIp.h"
+#include "base/omx_module/DummySyncDriver.h"
+#include "base/omx_module/unittests/source_buffer.h"
+
+using namespace std;
+
+static int NumBusyFrameBuffers(ChannelStatus const& status)
+{
+  int busy = 0;
+
+  for(int i = 0; i < MAX_FB_NUMBER; ++i)
+    busy += !status.fbAvail[i];
+
+  return busy;
+}
+
+/* The end of frame path: a framebuffer is written, the channel refills the freed slot */
+TEST(SyncChannel, RefillLatency)
+{
+  int const numFrames = 10000;
+  auto driver = AL_InitDummyDriver(true, 4);
+  SyncIp sync(driver, "/dev/xvsfsync0");
+
+  {
+    SyncChannel channel(&sync, sync.getFreeChannel());
+
+    for(int i = 0; i < MAX_FB_NUMBER + 1; ++i)
+    {
+      auto buf = CreateSourceBuffer(64, 64);
+      ASSERT_NE(nullptr, buf);
+      AL_Buffer_Ref(buf);
+      channel.addBuffer(buf);
+      AL_Buffer_Unref(buf);
+    }
+
+    channel.enable();
+    ASSERT_EQ(MAX_FB_NUMBER, NumBusyFrameBuffers(sync.getStatus(channel.id)));
+
+    /* no free slot: the refill is a no-op, not an error */
+    channel.addBuffer(nullptr);
+    ASSERT_EQ(MAX_FB_NUMBER, NumBusyFrameBuffers(sync.getStatus(channel.id)));
+
+    driver->ClearLatencies();
+    chrono::steady_clock::duration refill {};
+
+    for(int frame = 0; frame < numFrames; ++frame)
+    {
+      driver->FinalizeBuffer(channel.id);
+
+      auto start = chrono::steady_clock::now();
+      channel.addBuffer(nullptr);
+      refill += chrono::steady_clock::now() - start;
+
+      ASSERT_EQ(MAX_FB_NUMBER, NumBusyFrameBuffers(sync.getStatus(channel.id)));
+    }
+
+    EXPECT_EQ(numFrames, (int)driver->GetLatencies(channel.id).size());
+
+    auto perRefill = chrono::duration_cast<chrono::nanoseconds>(refill).count() / numFrames;
+    cout << "refill: " << perRefill << " ns" << endl;
+    RecordProperty("refill_ns", (int)perRefill);
+  }
+}
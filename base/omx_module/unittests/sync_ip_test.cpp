@@ -0,0 +1,168 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <set>
+#include <thread>
+
+#include "base/omx_module/SyncIp.h"
+#include "base/omx_module/DummySyncDriver.h"
+
+using namespace std;
+
+static char const* device = "/dev/xvsfsync0";
+
+TEST(SyncIp, SharedIsReusedWhileHeld)
+{
+  auto driver = AL_InitDummyDriver(true, 4);
+  auto first = SyncIp::Shared(driver, device);
+  auto second = SyncIp::Shared(driver, device);
+  EXPECT_EQ(first.get(), second.get());
+
+  first.reset();
+  second.reset();
+  /* the dummy driver only opens one device at a time, the old one was closed */
+  auto third = SyncIp::Shared(driver, device);
+  EXPECT_NE(nullptr, third.get());
+}
+
+TEST(SyncIp, FreeChannelsAreDistinct)
+{
+  auto driver = AL_InitDummyDriver(true, 4);
+  SyncIp sync(driver, device);
+
+  set<int> channels;
+
+  for(int i = 0; i < sync.maxChannels; ++i)
+    channels.insert(sync.getFreeChannel());
+
+  EXPECT_EQ(sync.maxChannels, (int)channels.size());
+  EXPECT_THROW(sync.getFreeChannel(), runtime_error);
+
+  sync.releaseChannel(2);
+  EXPECT_EQ(2, sync.getFreeChannel());
+}
+
+TEST(SyncIp, ErrorIsDispatchedOnce)
+{
+  auto driver = AL_InitDummyDriver(true, 4);
+  SyncIp sync(driver, device);
+  atomic<int> syncErrors { 0 };
+  atomic<int> watchdogErrors { 0 };
+  atomic<int> otherChannel { 0 };
+
+  sync.addListener(1, [&](ChannelStatus& status)
+  {
+    syncErrors += status.syncError;
+    watchdogErrors += status.watchdogError;
+  });
+  sync.addListener(3, [&](ChannelStatus &)
+  {
+    ++otherChannel;
+  });
+
+  driver->SignalSyncError(1);
+
+  for(int i = 0; i < 100 && syncErrors == 0; ++i)
+    this_thread::sleep_for(chrono::milliseconds(1));
+
+  /* leave time for a spurious second dispatch */
+  this_thread::sleep_for(chrono::milliseconds(50));
+
+  EXPECT_EQ(1, syncErrors);
+  EXPECT_EQ(0, watchdogErrors);
+  EXPECT_EQ(0, otherChannel);
+  EXPECT_FALSE(sync.getStatus(1).syncError);
+
+  sync.removeListener(1);
+  sync.removeListener(3);
+}
+
+/* forwards to the dummy driver, but can't read the sync ip configuration */
+struct NoConfigDriver : public AL_TDriver
+{
+  NoConfigDriver(DummyDriver* dummy) : dummy{dummy}
+  {
+    static const AL_DriverVtable noConfigVtable =
+    {
+      [](AL_TDriver* driver, const char* device) {
+        return static_cast<NoConfigDriver*>(driver)->dummy->Open(device);
+      },
+      [](AL_TDriver* driver, int fd) {
+        static_cast<NoConfigDriver*>(driver)->dummy->Close(fd);
+      },
+      [](AL_TDriver*, int, long unsigned int, void*) {
+        return DRIVER_ERROR_UNKNOWN;
+      },
+    };
+
+    AL_TDriver::vtable = &noConfigVtable;
+  }
+
+  DummyDriver* dummy;
+};
+
+TEST(SyncIp, FailedConstructionClosesTheDevice)
+{
+  auto driver = AL_InitDummyDriver(true, 4);
+  NoConfigDriver noConfig(driver);
+
+  EXPECT_THROW(SyncIp failing(&noConfig, device), runtime_error);
+  EXPECT_EQ(-1, driver->eventFd);
+
+  /* the dummy driver only opens one device at a time */
+  SyncIp sync(driver, device);
+  EXPECT_EQ(4, sync.maxChannels);
+}
+
+TEST(SyncIp, DestructionWakesTheEventThread)
+{
+  auto driver = AL_InitDummyDriver(true, 4);
+  unique_ptr<SyncIp> sync(new SyncIp(driver, device));
+
+  /* let the event thread block on the driver */
+  this_thread::sleep_for(chrono::milliseconds(10));
+
+  auto start = chrono::steady_clock::now();
+  sync.reset();
+  auto elapsed = chrono::steady_clock::now() - start;
+
+  EXPECT_LT(elapsed, chrono::milliseconds(50));
+}
@@ -0,0 +1,174 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "base/omx_module/SyncIp.h"
+#include "base/omx_module/DummySyncDriver.h"
+#include "base/omx_module/unittests/source_buffer.h"
+
+using namespace std;
+
+static void AddSourceBuffers(SyncChannel& channel, int numBuffers)
+{
+  for(int i = 0; i < numBuffers; ++i)
+  {
+    auto buf = CreateSourceBuffer(64, 64);
+    ASSERT_NE(nullptr, buf);
+    AL_Buffer_Ref(buf);
+    channel.addBuffer(buf);
+    AL_Buffer_Unref(buf);
+  }
+}
+
+/* the errors are dispatched on the event thread */
+static void WaitErrorsCleared(SyncIp& sync, int chanId)
+{
+  for(int i = 0; i < 10000 && sync.getStatus(chanId).syncError; ++i)
+    this_thread::sleep_for(chrono::microseconds(100));
+}
+
+/* One channel fed at 60 fps with jitter and 10% sync errors, refilled every millisecond.
+ * The clock is simulated: the schedule and the latencies don't depend on the machine load */
+TEST(SyncSimulation, LatencyAt60Fps)
+{
+  DummySyncSimulation simulation;
+  simulation.framerate = 60;
+  simulation.jitter = chrono::milliseconds(2);
+  simulation.syncErrorRate = 0.1;
+  simulation.seed = 42;
+  simulation.manualClock = true;
+
+  auto driver = AL_InitDummyDriver(true, 1);
+  driver->StartSimulation(simulation);
+
+  vector<chrono::microseconds> latencies;
+  atomic<int> syncErrors { 0 };
+
+  {
+    SyncIp sync(driver, "/dev/xvsfsync0");
+    SyncChannel channel(&sync, sync.getFreeChannel());
+    sync.addListener(channel.id, [&](ChannelStatus& status)
+    {
+      syncErrors += status.syncError;
+    });
+
+    AddSourceBuffers(channel, MAX_FB_NUMBER + 1);
+    driver->ClearLatencies();
+    channel.enable();
+
+    for(int ms = 0; ms < 1000; ++ms)
+    {
+      driver->AdvanceSimulation(chrono::milliseconds(1));
+      WaitErrorsCleared(sync, channel.id);
+      channel.addBuffer(nullptr);
+    }
+
+    latencies = driver->GetLatencies(channel.id);
+  }
+
+  driver->StopSimulation();
+
+  /* every error reached the listener once */
+  EXPECT_GT(syncErrors, 0);
+  EXPECT_EQ(driver->GetSimulatedErrors(0), syncErrors);
+
+  /* one framebuffer per tick: the 60th tick can be moved past the second by the jitter */
+  ASSERT_GE((int)latencies.size(), 59);
+  ASSERT_LE((int)latencies.size(), 60);
+
+  auto const period = chrono::duration_cast<chrono::microseconds>(chrono::seconds(1)) / simulation.framerate;
+  auto const jitter = chrono::duration_cast<chrono::microseconds>(simulation.jitter);
+  auto const refillDelay = chrono::milliseconds(1);
+
+  /* the framebuffers programmed when the channel was enabled are written on the first ticks */
+  for(int i = 0; i < MAX_FB_NUMBER; ++i)
+  {
+    EXPECT_GE(latencies[i].count(), (period * (i + 1) - jitter).count());
+    EXPECT_LE(latencies[i].count(), (period * (i + 1) + jitter).count());
+  }
+
+  /* then every slot is kept busy: a framebuffer waits MAX_FB_NUMBER ticks */
+  auto const expected = period * MAX_FB_NUMBER;
+
+  for(size_t i = MAX_FB_NUMBER; i < latencies.size(); ++i)
+  {
+    EXPECT_GT(latencies[i].count(), (expected - 2 * jitter - refillDelay).count());
+    EXPECT_LE(latencies[i].count(), (expected + 2 * jitter).count());
+  }
+
+  sort(latencies.begin(), latencies.end());
+  auto const median = latencies[latencies.size() / 2];
+  cout << "latency median: " << median.count() << " us, sync errors: " << syncErrors << endl;
+  RecordProperty("latency_median_us", (int)median.count());
+}
+
+/* With the real clock the producer thread only runs while the device is open */
+TEST(SyncSimulation, ProducerStopsWithTheDevice)
+{
+  DummySyncSimulation simulation;
+  simulation.framerate = 240;
+
+  auto driver = AL_InitDummyDriver(true, 1);
+  driver->StartSimulation(simulation);
+
+  {
+    SyncIp sync(driver, "/dev/xvsfsync0");
+    SyncChannel channel(&sync, sync.getFreeChannel());
+    AddSourceBuffers(channel, MAX_FB_NUMBER);
+    driver->ClearLatencies();
+    channel.enable();
+
+    for(int i = 0; i < 1000 && driver->GetLatencies(channel.id).empty(); ++i)
+      this_thread::sleep_for(chrono::milliseconds(1));
+
+    EXPECT_FALSE(driver->GetLatencies(channel.id).empty());
+  }
+
+  auto const numWritten = driver->GetLatencies(0).size();
+  this_thread::sleep_for(chrono::milliseconds(20));
+  EXPECT_EQ(numWritten, driver->GetLatencies(0).size());
+
+  driver->StopSimulation();
+}
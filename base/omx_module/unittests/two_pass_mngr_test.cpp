@@ -0,0 +1,345 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "base/omx_module/TwoPassMngr.h"
+
+using namespace std;
+
+static int const LOCAL_RANGE = 5;
+static int const SEQUENCE_SIZE = 1000;
+static int const NUM_FRAMES = 100000;
+
+/* ComputeComplexity as it was: every window rescans a copy of the whole sequence */
+static int ReferenceLocalComplexity(vector<AL_TLookAheadMetaData> tFrames, int iLocalIndex, int iIndexMax, size_t zPicSizeMoy)
+{
+  if(iIndexMax - iLocalIndex < LOCAL_RANGE)
+    return 1000;
+
+  size_t zSumLocal = 0;
+
+  for(int k = 0; k < LOCAL_RANGE; k++)
+    zSumLocal += tFrames[iLocalIndex + k].iPictureSize;
+
+  return 1000 * (zSumLocal / LOCAL_RANGE) / zPicSizeMoy;
+}
+
+static void ReferenceComplexity(vector<AL_TLookAheadMetaData>& tFrames)
+{
+  auto iSequenceSize = static_cast<int>(tFrames.size());
+  size_t zSumPicSize = 0;
+
+  for(auto frame: tFrames)
+    zSumPicSize += frame.iPictureSize;
+
+  auto zPicSizeMoy = zSumPicSize / iSequenceSize;
+  int iComplexity = 1000;
+
+  for(int k = 0; k < iSequenceSize; k++)
+  {
+    if(k % LOCAL_RANGE == 0)
+      iComplexity = ReferenceLocalComplexity(tFrames, k, iSequenceSize, zPicSizeMoy);
+    tFrames[k].iComplexity = iComplexity;
+  }
+}
+
+static vector<AL_TLookAheadMetaData> RandomSequence(mt19937& random, int size)
+{
+  uniform_int_distribution<int> pictureSize(1, 2000000);
+  vector<AL_TLookAheadMetaData> sequence(size);
+
+  for(auto& frame : sequence)
+    frame.iPictureSize = pictureSize(random);
+
+  return sequence;
+}
+
+TEST(TwoPassMngr, ComputeComplexityMatchesTheWindowRescan)
+{
+  mt19937 random(15);
+  uniform_int_distribution<int> sequenceSize(1, SEQUENCE_SIZE);
+  TwoPassMngr manager("", 0);
+
+  for(int i = 0; i < 2000; ++i)
+  {
+    auto expected = RandomSequence(random, sequenceSize(random));
+    manager.tFrames = expected;
+    manager.ComputeComplexity();
+    ReferenceComplexity(expected);
+
+    for(size_t k = 0; k < expected.size(); ++k)
+      ASSERT_EQ(expected[k].iComplexity, manager.tFrames[k].iComplexity) << "frame " << k << " of " << expected.size();
+  }
+}
+
+/* 100k frames, cut in sequences of the size the second pass reads at once */
+TEST(TwoPassMngrBenchmark, ComputeComplexityOn100kFrames)
+{
+  mt19937 random(100000);
+  vector<vector<AL_TLookAheadMetaData>> sequences;
+
+  for(int i = 0; i < NUM_FRAMES / SEQUENCE_SIZE; ++i)
+    sequences.push_back(RandomSequence(random, SEQUENCE_SIZE));
+
+  TwoPassMngr manager("", 0);
+  auto start = chrono::steady_clock::now();
+
+  for(auto& sequence : sequences)
+  {
+    manager.tFrames = sequence;
+    manager.ComputeComplexity();
+  }
+
+  chrono::duration<double, milli> singlePass = chrono::steady_clock::now() - start;
+
+  start = chrono::steady_clock::now();
+
+  for(auto& sequence : sequences)
+    ReferenceComplexity(sequence);
+
+  chrono::duration<double, milli> rescan = chrono::steady_clock::now() - start;
+
+  cout << "100k frames: window rescan " << rescan.count() << " ms, single pass " << singlePass.count() << " ms" << endl;
+  RecordProperty("rescan_us", static_cast<int>(rescan.count() * 1000));
+  RecordProperty("single_pass_us", static_cast<int>(singlePass.count() * 1000));
+}
+
+/* Pass 1 logs of the same frames, compared through the second pass */
+static vector<AL_TLookAheadMetaData> RandomFrames(mt19937& random, int size)
+{
+  uniform_int_distribution<int> pictureSize(1, 2000000);
+  uniform_int_distribution<int> percent(0, 100);
+  vector<AL_TLookAheadMetaData> frames(size);
+
+  for(auto& frame : frames)
+  {
+    frame.iPictureSize = pictureSize(random);
+    frame.iPercentIntra = percent(random);
+    frame.iPercentSkip = percent(random);
+  }
+
+  return frames;
+}
+
+static string LogFileName(string name)
+{
+  return testing::TempDir() + "two_pass_mngr_test_" + name;
+}
+
+static void WriteLog(string fileName, TwoPassLogFormat format, vector<AL_TLookAheadMetaData> frames)
+{
+  TwoPassMngr firstPass(fileName, 1, format);
+
+  for(auto& frame : frames)
+    firstPass.AddFrame(&frame);
+
+  firstPass.Flush();
+}
+
+static vector<AL_TLookAheadMetaData> ReadLog(string fileName)
+{
+  TwoPassMngr secondPass(fileName, 2);
+  vector<AL_TLookAheadMetaData> frames(secondPass.GetNumFrames());
+
+  for(auto& frame : frames)
+    secondPass.GetFrame(&frame);
+
+  return frames;
+}
+
+static void ExpectSameFrame(AL_TLookAheadMetaData const& expected, AL_TLookAheadMetaData const& actual, int frame)
+{
+  EXPECT_EQ(expected.iPictureSize, actual.iPictureSize) << "frame " << frame;
+  EXPECT_EQ(expected.iPercentIntra, actual.iPercentIntra) << "frame " << frame;
+  EXPECT_EQ(expected.iPercentSkip, actual.iPercentSkip) << "frame " << frame;
+  EXPECT_EQ(expected.iComplexity, actual.iComplexity) << "frame " << frame;
+  EXPECT_EQ(expected.bNextSceneChange, actual.bNextSceneChange) << "frame " << frame;
+  EXPECT_EQ(expected.iIPRatio, actual.iIPRatio) << "frame " << frame;
+}
+
+static string ReadFile(string fileName)
+{
+  ifstream file(fileName, ios::binary);
+  return string(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+}
+
+static void WriteFile(string fileName, string const& content)
+{
+  ofstream file(fileName, ios::binary | ios::trunc);
+  file.write(content.data(), content.size());
+}
+
+static string RejectionOf(string fileName)
+{
+  try
+  {
+    TwoPassMngr secondPass(fileName, 2);
+  }
+  catch(runtime_error const& error)
+  {
+    return error.what();
+  }
+
+  return "accepted";
+}
+
+TEST(TwoPassMngr, BinaryAndTextLogsGiveTheSameSecondPass)
+{
+  mt19937 random(16);
+  auto frames = RandomFrames(random, 2 * SEQUENCE_SIZE + 345);
+  auto binaryName = LogFileName("round_trip.bin");
+  auto textName = LogFileName("round_trip.txt");
+
+  WriteLog(binaryName, TWOPASS_LOG_BINARY, frames);
+  WriteLog(textName, TWOPASS_LOG_TEXT, frames);
+
+  auto binary = ReadLog(binaryName);
+  auto text = ReadLog(textName);
+
+  ASSERT_EQ(frames.size(), binary.size());
+  ASSERT_EQ(frames.size(), text.size());
+
+  for(size_t k = 0; k < frames.size(); ++k)
+  {
+    ASSERT_EQ(frames[k].iPictureSize, binary[k].iPictureSize) << "frame " << k;
+    ASSERT_EQ(frames[k].iPercentIntra, binary[k].iPercentIntra) << "frame " << k;
+    ASSERT_EQ(frames[k].iPercentSkip, binary[k].iPercentSkip) << "frame " << k;
+    ExpectSameFrame(text[k], binary[k], k);
+  }
+
+  remove(binaryName.c_str());
+  remove(textName.c_str());
+}
+
+TEST(TwoPassMngr, BinaryLogRejectsABadVersion)
+{
+  mt19937 random(17);
+  auto fileName = LogFileName("bad_version.bin");
+  WriteLog(fileName, TWOPASS_LOG_BINARY, RandomFrames(random, 100));
+
+  auto content = ReadFile(fileName);
+  uint32_t version = 2;
+  content.replace(offsetof(TwoPassLogHeader, uVersion), sizeof(version), reinterpret_cast<char const*>(&version), sizeof(version));
+  WriteFile(fileName, content);
+
+  EXPECT_NE(string::npos, RejectionOf(fileName).find("Unsupported"));
+  remove(fileName.c_str());
+}
+
+TEST(TwoPassMngr, BinaryLogRejectsAFirstPassThatWasNotClosed)
+{
+  mt19937 random(18);
+  auto fileName = LogFileName("not_closed.bin");
+  auto frames = RandomFrames(random, SEQUENCE_SIZE + 10);
+
+  {
+    TwoPassMngr firstPass(fileName, 1, TWOPASS_LOG_BINARY);
+
+    for(auto& frame : frames)
+      firstPass.AddFrame(&frame);
+
+    firstPass.Flush();
+    firstPass.outputFile.flush();
+
+    /* the records are there, the header still says there are none */
+    EXPECT_NE(string::npos, RejectionOf(fileName).find("Incomplete"));
+  }
+
+  EXPECT_EQ(frames.size(), ReadLog(fileName).size());
+
+  WriteFile(fileName, ReadFile(fileName).substr(0, sizeof(TwoPassLogHeader) - 1));
+  EXPECT_NE(string::npos, RejectionOf(fileName).find("Truncated"));
+  remove(fileName.c_str());
+}
+
+TEST(TwoPassMngr, BinaryLogRejectsAFlippedByte)
+{
+  mt19937 random(19);
+  auto fileName = LogFileName("flipped.bin");
+  WriteLog(fileName, TWOPASS_LOG_BINARY, RandomFrames(random, 100));
+
+  auto content = ReadFile(fileName);
+  content[sizeof(TwoPassLogHeader) + 50 * sizeof(TwoPassLogRecord) + 1] ^= 0x04;
+  WriteFile(fileName, content);
+
+  EXPECT_NE(string::npos, RejectionOf(fileName).find("Corrupted"));
+  remove(fileName.c_str());
+}
+
+TEST(TwoPassMngr, SeekFrameMatchesASequentialRead)
+{
+  mt19937 random(20);
+  auto frames = RandomFrames(random, 2 * SEQUENCE_SIZE + 345);
+
+  for(auto format : { TWOPASS_LOG_BINARY, TWOPASS_LOG_TEXT })
+  {
+    auto fileName = LogFileName(format == TWOPASS_LOG_BINARY ? "seek.bin" : "seek.txt");
+    WriteLog(fileName, format, frames);
+    auto sequential = ReadLog(fileName);
+
+    TwoPassMngr secondPass(fileName, 2);
+
+    /* back and forth across the sequence boundaries, reading on after each seek */
+    for(int start : { 1500, 0, SEQUENCE_SIZE - 1, 2 * SEQUENCE_SIZE + 344, SEQUENCE_SIZE, 2 * SEQUENCE_SIZE - 2, 1 })
+    {
+      secondPass.SeekFrame(start);
+
+      for(int k = start; k < min(start + 5, static_cast<int>(sequential.size())); ++k)
+      {
+        AL_TLookAheadMetaData frame;
+        secondPass.GetFrame(&frame);
+        ExpectSameFrame(sequential[k], frame, k);
+      }
+    }
+
+    EXPECT_THROW(secondPass.SeekFrame(sequential.size()), runtime_error);
+    EXPECT_THROW(secondPass.SeekFrame(-1), runtime_error);
+    remove(fileName.c_str());
+  }
+}
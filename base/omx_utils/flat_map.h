@@ -0,0 +1,345 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/* Open addressing map for small trivially copyable keys and values
+ * (pointers, file descriptors). The table is pre-sized so that the common path
+ * never allocates. Writers are serialized by a mutex, readers are lock-free:
+ * they probe optimistically and retry if a writer ran concurrently (seqlock).
+ * Tables replaced on growth are kept alive until destruction so that a reader
+ * never touches freed memory. */
+template<class K, class V>
+class FlatMap
+{
+public:
+  explicit FlatMap(size_t capacity = 64) :
+    version{0}, size{0}
+  {
+    current.store(NewTable(capacity), std::memory_order_relaxed);
+  }
+
+  ~FlatMap()
+  {
+    delete current.load(std::memory_order_relaxed);
+  }
+
+  FlatMap(FlatMap const &) = delete;
+  FlatMap & operator = (FlatMap const &) = delete;
+
+  void Reserve(size_t count)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if(!NeedGrowth(count))
+      return;
+
+    BeginWrite();
+    Grow(count);
+    EndWrite();
+  }
+
+  void Add(K const& key, V value)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    BeginWrite();
+
+    if(NeedGrowth(size + 1))
+      Grow(size + 1);
+
+    auto table = current.load(std::memory_order_relaxed);
+
+    if(_Insert(table, key, value))
+      ++size;
+    EndWrite();
+  }
+
+  void Remove(K const& key)
+  {
+    V value;
+    TryPop(key, value);
+  }
+
+  V Get(K const& key)
+  {
+    V value {};
+    TryGet(key, value);
+    return value;
+  }
+
+  V Pop(K const& key)
+  {
+    V value {};
+    TryPop(key, value);
+    return value;
+  }
+
+  bool Exist(K const& key)
+  {
+    V value;
+    return TryGet(key, value);
+  }
+
+  /* Lookup and remove in a single critical section */
+  bool TryPop(K const& key, V& value)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto table = current.load(std::memory_order_relaxed);
+    auto slot = _Find(table, key);
+
+    if(slot == NOT_FOUND)
+      return false;
+
+    value = table->slots[slot].value.load(std::memory_order_relaxed);
+    BeginWrite();
+    _Erase(table, slot);
+    --size;
+    EndWrite();
+    return true;
+  }
+
+  /* Empties the map and hands back the values */
+  std::vector<V> PopAll()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto table = current.load(std::memory_order_relaxed);
+    std::vector<V> values;
+    values.reserve(size);
+
+    BeginWrite();
+
+    for(size_t i = 0; i <= table->mask; ++i)
+    {
+      auto& slot = table->slots[i];
+
+      if(slot.used.load(std::memory_order_relaxed))
+      {
+        values.push_back(slot.value.load(std::memory_order_relaxed));
+        slot.used.store(false, std::memory_order_relaxed);
+      }
+    }
+
+    size = 0;
+    EndWrite();
+    return values;
+  }
+
+  bool TryGet(K const& key, V& value)
+  {
+    for(;;)
+    {
+      auto before = version.load(std::memory_order_acquire);
+
+      if(before & 1)
+        continue;
+
+      auto table = current.load(std::memory_order_acquire);
+      auto slot = _Find(table, key);
+      bool found = slot != NOT_FOUND;
+
+      if(found)
+        value = table->slots[slot].value.load(std::memory_order_relaxed);
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+
+      if(version.load(std::memory_order_relaxed) == before)
+        return found;
+    }
+  }
+
+private:
+  static size_t constexpr NOT_FOUND = SIZE_MAX;
+
+  struct Slot
+  {
+    std::atomic<K> key;
+    std::atomic<V> value;
+    std::atomic<bool> used;
+  };
+
+  struct Table
+  {
+    std::unique_ptr<Slot[]> slots;
+    size_t mask;
+  };
+
+  static Table* NewTable(size_t count)
+  {
+    size_t capacity = 8;
+
+    /* keep the load factor under 3/4 so probe sequences stay short */
+    while(capacity * 3 < count * 4)
+      capacity <<= 1;
+
+    auto table = new Table;
+    table->slots.reset(new Slot[capacity]);
+    table->mask = capacity - 1;
+
+    for(size_t i = 0; i < capacity; ++i)
+      table->slots[i].used.store(false, std::memory_order_relaxed);
+
+    return table;
+  }
+
+  static size_t Hash(K const& key)
+  {
+    auto h = static_cast<uint64_t>((uintptr_t)key);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return static_cast<size_t>(h);
+  }
+
+  bool NeedGrowth(size_t count) const
+  {
+    auto table = current.load(std::memory_order_relaxed);
+    return (table->mask + 1) * 3 < count * 4;
+  }
+
+  void BeginWrite()
+  {
+    version.store(version.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  void EndWrite()
+  {
+    version.store(version.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  void Grow(size_t count)
+  {
+    auto old = current.load(std::memory_order_relaxed);
+    auto table = NewTable(count * 2);
+
+    for(size_t i = 0; i <= old->mask; ++i)
+    {
+      auto& slot = old->slots[i];
+
+      if(slot.used.load(std::memory_order_relaxed))
+        _Insert(table, slot.key.load(std::memory_order_relaxed), slot.value.load(std::memory_order_relaxed));
+    }
+
+    retired.emplace_back(old);
+    current.store(table, std::memory_order_release);
+  }
+
+  /* Probing is bounded by the table size so that a torn read cannot loop forever */
+  static size_t _Find(Table const* table, K const& key)
+  {
+    auto index = Hash(key) & table->mask;
+
+    for(size_t probe = 0; probe <= table->mask; ++probe)
+    {
+      auto& slot = table->slots[index];
+
+      if(!slot.used.load(std::memory_order_relaxed))
+        return NOT_FOUND;
+
+      if(slot.key.load(std::memory_order_relaxed) == key)
+        return index;
+
+      index = (index + 1) & table->mask;
+    }
+
+    return NOT_FOUND;
+  }
+
+  /* Returns false when the key was already present (keeps the old value like std::map::insert) */
+  static bool _Insert(Table* table, K const& key, V value)
+  {
+    auto index = Hash(key) & table->mask;
+
+    for(;;)
+    {
+      auto& slot = table->slots[index];
+
+      if(!slot.used.load(std::memory_order_relaxed))
+      {
+        slot.key.store(key, std::memory_order_relaxed);
+        slot.value.store(value, std::memory_order_relaxed);
+        slot.used.store(true, std::memory_order_relaxed);
+        return true;
+      }
+
+      if(slot.key.load(std::memory_order_relaxed) == key)
+        return false;
+
+      index = (index + 1) & table->mask;
+    }
+  }
+
+  /* Backward shift deletion: no tombstones, so lookups never degrade over time */
+  static void _Erase(Table* table, size_t hole)
+  {
+    auto index = hole;
+
+    for(;;)
+    {
+      index = (index + 1) & table->mask;
+      auto& slot = table->slots[index];
+
+      if(!slot.used.load(std::memory_order_relaxed))
+        break;
+
+      auto key = slot.key.load(std::memory_order_relaxed);
+      auto home = Hash(key) & table->mask;
+
+      /* the entry can move into the hole only if its home is not in (hole, index] */
+      if(((index - home) & table->mask) < ((index - hole) & table->mask))
+        continue;
+
+      table->slots[hole].key.store(key, std::memory_order_relaxed);
+      table->slots[hole].value.store(slot.value.load(std::memory_order_relaxed), std::memory_order_relaxed);
+      hole = index;
+    }
+
+    table->slots[hole].used.store(false, std::memory_order_relaxed);
+  }
+
+  std::mutex mutex;
+  std::atomic<uint32_t> version;
+  std::atomic<Table*> current;
+  std::vector<std::unique_ptr<Table>> retired;
+  size_t size;
+};
@@ -0,0 +1,252 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief A bounded multi-producer multi-consumer FIFO queue. try_push and
+ * try_pop are safe from any number of threads and never take a lock.
+ *
+ * The blocking pop is restricted to a single consumer: it only parks on a
+ * condition variable when the ring is empty, and producers only take the park
+ * mutex when that consumer is actually parked.
+ *
+ * Like locked_queue, there is no "size" function : its result would be
+ * obsolete as soon as the call would have returned.
+ */
+template<typename T>
+class lockfree_queue
+{
+public:
+  /**
+   * @param capacity the number of elements the ring can hold. Rounded up to the
+   * next power of two.
+   */
+  explicit lockfree_queue(size_t capacity = 1024) :
+    m_Cells(RoundUpPowerOfTwo(capacity)),
+    m_Mask(m_Cells.size() - 1),
+    m_EnqueuePos(0),
+    m_DequeuePos(0),
+    m_Parked(false)
+  {
+    for(size_t i = 0; i < m_Cells.size(); ++i)
+      m_Cells[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  lockfree_queue(lockfree_queue const &) = delete;
+  lockfree_queue & operator = (lockfree_queue const &) = delete;
+
+  /**
+   * @brief Tries to add a new element at the end of the queue
+   *
+   * @param val the element to add (will be moved)
+   *
+   * @return false if the ring is full
+   */
+  bool try_push(T& val)
+  {
+    auto pos = m_EnqueuePos.load(std::memory_order_relaxed);
+    Cell* cell;
+
+    while(true)
+    {
+      cell = &m_Cells[pos & m_Mask];
+      auto sequence = cell->sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+
+      if(diff == 0)
+      {
+        if(m_EnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+          break;
+      }
+      else if(diff < 0)
+        return false;
+      else
+        pos = m_EnqueuePos.load(std::memory_order_relaxed);
+    }
+
+    cell->data = std::move(val);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    Wake();
+    return true;
+  }
+
+  /**
+   * @brief Adds a new element at the end of the queue. Yields until a slot is
+   * free if the ring is full.
+   *
+   * @param val the element to add (will be moved)
+   */
+  void push(T val)
+  {
+    while(!try_push(val))
+      std::this_thread::yield();
+  }
+
+  /**
+   * @brief Tries to get the next element from the head of the queue. Can be
+   * called from any thread, which lets the queue also be used as a free list.
+   *
+   * @param val a reference to a variable which will be filled with the element
+   *
+   * @return false if the queue is empty
+   */
+  bool try_pop(T& val)
+  {
+    auto pos = m_DequeuePos.load(std::memory_order_relaxed);
+    Cell* cell;
+
+    while(true)
+    {
+      cell = &m_Cells[pos & m_Mask];
+      auto sequence = cell->sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+
+      if(diff == 0)
+      {
+        if(m_DequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+          break;
+      }
+      else if(diff < 0)
+        return false;
+      else
+        pos = m_DequeuePos.load(std::memory_order_relaxed);
+    }
+
+    val = std::move(cell->data);
+    cell->sequence.store(pos + m_Mask + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Gets the next element from the head of the queue. Spins a little,
+   * then parks until one element is available. Must only be called by the
+   * consumer.
+   */
+  T pop()
+  {
+    T val;
+
+    for(int spin = 0; spin < SPIN_COUNT; ++spin)
+    {
+      if(try_pop(val))
+        return val;
+    }
+
+    while(!try_pop(val))
+      Park();
+
+    return val;
+  }
+
+private:
+  static int const SPIN_COUNT = 64;
+
+  struct Cell
+  {
+    std::atomic<size_t> sequence;
+    T data;
+  };
+
+  static size_t RoundUpPowerOfTwo(size_t value)
+  {
+    assert(value > 0);
+    size_t power = 1;
+
+    while(power < value)
+      power <<= 1;
+
+    return power;
+  }
+
+  bool IsEmpty() const
+  {
+    auto pos = m_DequeuePos.load(std::memory_order_relaxed);
+    auto sequence = m_Cells[pos & m_Mask].sequence.load(std::memory_order_acquire);
+    return static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1) < 0;
+  }
+
+  /* The parked flag and the cell sequences form a Dekker pair: the consumer
+   * publishes it is parked then re-checks the ring, the producer publishes an
+   * element then checks the flag. The full fences make sure at least one side
+   * sees the other. */
+  void Park()
+  {
+    std::unique_lock<std::mutex> lock(m_ParkMutex);
+    m_Parked.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    while(IsEmpty())
+      m_ParkCondition.wait(lock);
+
+    m_Parked.store(false, std::memory_order_relaxed);
+  }
+
+  void Wake()
+  {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if(!m_Parked.load(std::memory_order_relaxed))
+      return;
+
+    std::lock_guard<std::mutex> lock(m_ParkMutex);
+    m_ParkCondition.notify_one();
+  }
+
+  /* Padding keeps the producer and consumer indexes on separate cache lines.
+   * alignas is not used as operator new does not honor it before c++17 */
+  static size_t const CACHE_LINE_SIZE = 64;
+
+  std::vector<Cell> m_Cells;
+  size_t const m_Mask;
+  char m_Pad0[CACHE_LINE_SIZE];
+  std::atomic<size_t> m_EnqueuePos;
+  char m_Pad1[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+  std::atomic<size_t> m_DequeuePos;
+  char m_Pad2[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+  std::atomic<bool> m_Parked;
+  std::mutex m_ParkMutex;
+  std::condition_variable m_ParkCondition;
+};
@@ -0,0 +1,252 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include "parallel_copy.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+static size_t constexpr MIN_CHUNK_SIZE = 1024 * 1024;
+static size_t constexpr MAX_COPY_THREADS = 4;
+
+#if defined(__SSE2__)
+static void StreamCopy(uint8_t* dst, uint8_t const* src, size_t size)
+{
+  /* align the destination: streaming stores need 16 bytes alignment */
+  auto head = min(size, static_cast<size_t>((16 - ((uintptr_t)dst & 15)) & 15));
+  memcpy(dst, src, head);
+  dst += head;
+  src += head;
+  size -= head;
+
+  auto blocks = size / 64;
+
+  for(size_t i = 0; i < blocks; ++i)
+  {
+    auto s = reinterpret_cast<__m128i const*>(src);
+    auto d = reinterpret_cast<__m128i*>(dst);
+    auto a = _mm_loadu_si128(s);
+    auto b = _mm_loadu_si128(s + 1);
+    auto c = _mm_loadu_si128(s + 2);
+    auto e = _mm_loadu_si128(s + 3);
+    _mm_stream_si128(d, a);
+    _mm_stream_si128(d + 1, b);
+    _mm_stream_si128(d + 2, c);
+    _mm_stream_si128(d + 3, e);
+    src += 64;
+    dst += 64;
+  }
+
+  _mm_sfence();
+  memcpy(dst, src, size % 64);
+}
+
+#elif defined(__aarch64__) && AL_STREAM_COPY_AARCH64
+/* opt-in until validated on the target: the other builds use memcpy */
+static void StreamCopy(uint8_t* dst, uint8_t const* src, size_t size)
+{
+  /* stnp has no alignment requirement on normal memory, it only hints that the lines
+   * won't be read back soon. The mutex handing the chunk back orders the stores */
+  auto blocks = size / 64;
+
+  for(size_t i = 0; i < blocks; ++i)
+  {
+    asm volatile (
+      "ldp q0, q1, [%[src]]\n\t"
+      "ldp q2, q3, [%[src], #32]\n\t"
+      "stnp q0, q1, [%[dst]]\n\t"
+      "stnp q2, q3, [%[dst], #32]\n\t"
+      :
+      : [src] "r" (src), [dst] "r" (dst)
+      : "v0", "v1", "v2", "v3", "memory");
+    src += 64;
+    dst += 64;
+  }
+
+  memcpy(dst, src, size % 64);
+}
+
+#else
+static void StreamCopy(uint8_t* dst, uint8_t const* src, size_t size)
+{
+  memcpy(dst, src, size);
+}
+
+#endif
+
+namespace
+{
+struct CopyTask
+{
+  uint8_t* dst;
+  uint8_t const* src;
+  size_t size;
+  size_t chunkSize;
+  size_t numChunks;
+  size_t nextChunk;
+  size_t remaining;
+};
+
+/* Threads kept for the whole process: a copy only wakes them up.
+ * The caller copies chunks too, so a copy never waits for a worker to start. */
+class CopyWorkers
+{
+public:
+  explicit CopyWorkers(int numWorkers) : quit(false)
+  {
+    for(int i = 0; i < numWorkers; ++i)
+      workers.push_back(thread(&CopyWorkers::Worker, this));
+  }
+
+  ~CopyWorkers()
+  {
+    {
+      lock_guard<mutex> lock(tasksMutex);
+      quit = true;
+    }
+    ready.notify_all();
+
+    for(auto& worker : workers)
+      worker.join();
+  }
+
+  void Copy(CopyTask& task)
+  {
+    unique_lock<mutex> lock(tasksMutex);
+    tasks.push_back(&task);
+    ready.notify_all();
+
+    size_t chunk;
+
+    while(Take(task, chunk))
+    {
+      lock.unlock();
+      CopyChunk(task, chunk);
+      lock.lock();
+      --task.remaining;
+    }
+
+    finished.wait(lock, [&] { return task.remaining == 0;
+                  });
+  }
+
+private:
+  vector<thread> workers;
+  deque<CopyTask*> tasks;
+  mutex tasksMutex;
+  condition_variable ready;
+  condition_variable finished;
+  bool quit;
+
+  /* under tasksMutex: a taken chunk keeps the task alive until it is counted done */
+  bool Take(CopyTask& task, size_t& chunk)
+  {
+    if(task.nextChunk == task.numChunks)
+      return false;
+
+    chunk = task.nextChunk++;
+
+    if(task.nextChunk == task.numChunks)
+      tasks.erase(find(tasks.begin(), tasks.end(), &task));
+
+    return true;
+  }
+
+  static void CopyChunk(CopyTask& task, size_t chunk)
+  {
+    auto offset = chunk * task.chunkSize;
+    StreamCopy(task.dst + offset, task.src + offset, min(task.chunkSize, task.size - offset));
+  }
+
+  void Worker()
+  {
+    unique_lock<mutex> lock(tasksMutex);
+
+    while(true)
+    {
+      ready.wait(lock, [&] { return quit || !tasks.empty();
+                 });
+
+      if(quit)
+        break;
+
+      auto& task = *tasks.front();
+      size_t chunk;
+      Take(task, chunk);
+      lock.unlock();
+      CopyChunk(task, chunk);
+      lock.lock();
+
+      if(--task.remaining == 0)
+        finished.notify_all();
+    }
+  }
+};
+}
+
+void ParallelCopy(uint8_t* dst, uint8_t const* src, size_t size)
+{
+  static size_t const hardwareThreads = max(1u, thread::hardware_concurrency());
+  auto numChunks = min({ size / MIN_CHUNK_SIZE, MAX_COPY_THREADS, hardwareThreads });
+
+  if(numChunks <= 1)
+  {
+    if(size < MIN_CHUNK_SIZE)
+      memcpy(dst, src, size);
+    else
+      StreamCopy(dst, src, size);
+    return;
+  }
+
+  static CopyWorkers workers(static_cast<int>(min(MAX_COPY_THREADS, hardwareThreads)) - 1);
+
+  auto chunkSize = (size / numChunks + 63) & ~static_cast<size_t>(63);
+  CopyTask task { dst, src, size, chunkSize, (size + chunkSize - 1) / chunkSize, 0, 0 };
+  task.remaining = task.numChunks;
+  workers.Copy(task);
+}
@@ -38,7 +38,8 @@
 #pragma once
 
 #include "processor_interface.h"
-#include "locked_queue.h"
+#include "lockfree_queue.h"
+#include <atomic>
 #include <thread>
 #include <cassert>
 #include <functional>
@@ -47,7 +48,7 @@ class ProcessorFifo : ProcessorInterface
 {
 public:
   ProcessorFifo(std::function<void(void*)> _process, std::function<void(void*)> _delete) :
-    _process(_process), _delete(_delete)
+    _process(_process), _delete(_delete), deleting(false)
   {
     assert(_process);
     assert(_delete);
@@ -56,10 +57,7 @@ public:
 
   ~ProcessorFifo()
   {
-    {
-      std::unique_lock<std::mutex> sync(mutex);
-      _process = _delete;
-    }
+    deleting.store(true, std::memory_order_release);
     tasks.push(Task { true, nullptr });
     thread.join();
   }
@@ -77,10 +75,10 @@ private:
   };
 
   std::thread thread;
-  locked_queue<Task> tasks;
-  std::mutex mutex;
+  lockfree_queue<Task> tasks;
   std::function<void(void*)> _process;
   std::function<void(void*)> _delete;
+  std::atomic<bool> deleting;
 
   void Worker(void)
   {
@@ -91,12 +89,10 @@ private:
       if(task.quit)
         break;
 
-      std::function<void(void*)> p;
-      {
-        std::unique_lock<std::mutex> sync(mutex);
-        p = _process;
-      }
-      p(task.data);
+      if(deleting.load(std::memory_order_acquire))
+        _delete(task.data);
+      else
+        _process(task.data);
     }
   }
 };
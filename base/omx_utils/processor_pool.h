@@ -0,0 +1,216 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#pragma once
+
+#include "processor_interface.h"
+#include "lockfree_queue.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ProcessorPool;
+
+/**
+ * @brief A queue of work run by a ProcessorPool. The elements of one strand are
+ * processed in order and never concurrently, but not always by the same thread:
+ * a strand only takes a worker while it has pending elements.
+ *
+ * Queueing does not allocate, the elements are handed over as is.
+ */
+class ProcessorStrand : public ProcessorInterface
+{
+public:
+  ProcessorStrand(std::shared_ptr<ProcessorPool> pool, std::function<void(void*)> _process, std::function<void(void*)> _delete) :
+    pool(pool), _process(_process), _delete(_delete), pending(0), deleting(false)
+  {
+    assert(pool);
+    assert(_process);
+    assert(_delete);
+  }
+
+  /* The elements still pending are deleted, waits for the worker to leave the strand */
+  ~ProcessorStrand()
+  {
+    deleting.store(true, std::memory_order_release);
+    std::unique_lock<std::mutex> lock(idleMutex);
+    idle.wait(lock, [&] { return pending.load(std::memory_order_acquire) == 0;
+              });
+  }
+
+  void queue(void* process) override;
+
+private:
+  friend class ProcessorPool;
+
+  /* Elements run before the strand gives its worker back to the other strands */
+  static int const BATCH_SIZE = 16;
+
+  std::shared_ptr<ProcessorPool> const pool;
+  lockfree_queue<void*> elements;
+  std::function<void(void*)> _process;
+  std::function<void(void*)> _delete;
+  std::atomic<int> pending;
+  std::atomic<bool> deleting;
+  std::mutex idleMutex;
+  std::condition_variable idle;
+
+  void Run();
+};
+
+/**
+ * @brief Worker threads shared by all the strands of the process, one per core.
+ * The pool lives as long as one strand uses it.
+ */
+class ProcessorPool
+{
+public:
+  explicit ProcessorPool(int numWorkers) : quit(false)
+  {
+    assert(numWorkers > 0);
+
+    for(int i = 0; i < numWorkers; ++i)
+      workers.push_back(std::thread(&ProcessorPool::Worker, this));
+  }
+
+  ~ProcessorPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      quit = true;
+    }
+    ready.notify_all();
+
+    for(auto& worker: workers)
+      worker.join();
+  }
+
+  static std::shared_ptr<ProcessorPool> Shared()
+  {
+    static std::mutex sharedMutex;
+    static std::weak_ptr<ProcessorPool> shared;
+
+    std::lock_guard<std::mutex> lock(sharedMutex);
+    auto pool = shared.lock();
+
+    if(!pool)
+    {
+      pool = std::make_shared<ProcessorPool>(std::max(1, static_cast<int>(std::thread::hardware_concurrency())));
+      shared = pool;
+    }
+    return pool;
+  }
+
+  void schedule(ProcessorStrand* strand)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      strands.push_back(strand);
+    }
+    ready.notify_one();
+  }
+
+private:
+  std::vector<std::thread> workers;
+  std::deque<ProcessorStrand*> strands;
+  std::mutex mutex;
+  std::condition_variable ready;
+  bool quit;
+
+  void Worker(void)
+  {
+    while(true)
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      ready.wait(lock, [&] { return quit || !strands.empty();
+                 });
+
+      if(strands.empty())
+        break;
+
+      auto strand = strands.front();
+      strands.pop_front();
+      lock.unlock();
+
+      strand->Run();
+    }
+  }
+};
+
+/* The producer counting the first pending element schedules the strand */
+inline void ProcessorStrand::queue(void* process)
+{
+  elements.push(process);
+
+  if(pending.fetch_add(1, std::memory_order_acq_rel) == 0)
+    pool->schedule(this);
+}
+
+inline void ProcessorStrand::Run()
+{
+  for(int i = 0; i < BATCH_SIZE; ++i)
+  {
+    void* element;
+    auto popped = elements.try_pop(element);
+    assert(popped);
+    (void)popped;
+
+    if(deleting.load(std::memory_order_acquire))
+      _delete(element);
+    else
+      _process(element);
+
+    /* the destructor can only return once the worker has left the strand */
+    std::lock_guard<std::mutex> lock(idleMutex);
+
+    if(pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+      idle.notify_all();
+      return;
+    }
+  }
+
+  pool->schedule(this);
+}
+
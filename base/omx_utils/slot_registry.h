@@ -0,0 +1,154 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#pragma once
+#include <atomic>
+#include <cassert>
+#include <mutex>
+#include <vector>
+
+/* Per buffer records indexed by the dense slot number handed out when the buffer is created.
+ * Finding the record of a slot is an array access: O(1) and lock-free. Slots are only taken
+ * and given back, under a mutex, when buffers are created or invalidated.
+ * Records live in fixed chunks that never move, so a lookup never races with growth.
+ * A record is value-initialized once: a given back slot keeps the values its owner left. */
+template<class T>
+class SlotRegistry
+{
+public:
+  static int constexpr CHUNK_SIZE = 64;
+  static int constexpr MAX_CHUNKS = 64;
+
+  SlotRegistry() : numSlots{0}
+  {
+    for(auto& chunk : chunks)
+      chunk.store(nullptr, std::memory_order_relaxed);
+  }
+
+  ~SlotRegistry()
+  {
+    for(auto& chunk : chunks)
+      delete[] chunk.load(std::memory_order_relaxed);
+  }
+
+  SlotRegistry(SlotRegistry const &) = delete;
+  SlotRegistry & operator = (SlotRegistry const &) = delete;
+
+  /* Allocates the records of the first count slots up front */
+  void Reserve(int count)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for(int slot = 0; slot < count; slot += CHUNK_SIZE)
+      EnsureChunk(slot);
+  }
+
+  int Acquire()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    int slot;
+
+    if(freeSlots.empty())
+    {
+      slot = numSlots.load(std::memory_order_relaxed);
+      assert(slot < CHUNK_SIZE * MAX_CHUNKS);
+      EnsureChunk(slot);
+      numSlots.store(slot + 1, std::memory_order_release);
+    }
+    else
+    {
+      slot = freeSlots.back();
+      freeSlots.pop_back();
+    }
+
+    return slot;
+  }
+
+  void Release(int slot)
+  {
+    assert(IsValid(slot));
+    std::lock_guard<std::mutex> lock(mutex);
+    freeSlots.push_back(slot);
+  }
+
+  /* true for every slot handed out once, given back or not */
+  bool IsValid(int slot) const
+  {
+    return slot >= 0 && slot < numSlots.load(std::memory_order_acquire);
+  }
+
+  T& operator [] (int slot)
+  {
+    assert(IsValid(slot));
+    return chunks[slot / CHUNK_SIZE].load(std::memory_order_acquire)[slot % CHUNK_SIZE];
+  }
+
+  /* Calls f(slot, record) on the slots currently handed out */
+  template<typename F>
+  void ForEach(F f)
+  {
+    std::vector<bool> isFree;
+    {
+      /* a slot acquired and released concurrently is in freeSlots: it must be counted */
+      std::lock_guard<std::mutex> lock(mutex);
+      isFree.assign(numSlots.load(std::memory_order_relaxed), false);
+
+      for(auto slot : freeSlots)
+        isFree[slot] = true;
+    }
+
+    for(int slot = 0; slot < static_cast<int>(isFree.size()); ++slot)
+    {
+      if(!isFree[slot])
+        f(slot, (*this)[slot]);
+    }
+  }
+
+private:
+  void EnsureChunk(int slot)
+  {
+    auto& chunk = chunks[slot / CHUNK_SIZE];
+
+    if(!chunk.load(std::memory_order_relaxed))
+      chunk.store(new T[CHUNK_SIZE](), std::memory_order_release);
+  }
+
+  std::mutex mutex;
+  std::atomic<T*> chunks[MAX_CHUNKS];
+  std::atomic<int> numSlots;
+  std::vector<int> freeSlots;
+};
@@ -0,0 +1,208 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "base/omx_utils/lockfree_queue.h"
+#include "base/omx_utils/locked_queue.h"
+
+using namespace std;
+
+TEST(LockfreeQueue, CapacityIsRoundedUpToAPowerOfTwo)
+{
+  lockfree_queue<int> queue(5);
+
+  for(int i = 0; i < 8; ++i)
+    EXPECT_TRUE(queue.try_push(i));
+
+  int val = 8;
+  EXPECT_FALSE(queue.try_push(val));
+
+  for(int i = 0; i < 8; ++i)
+  {
+    EXPECT_TRUE(queue.try_pop(val));
+    EXPECT_EQ(i, val);
+  }
+
+  EXPECT_FALSE(queue.try_pop(val));
+}
+
+TEST(LockfreeQueue, KeepsTheOrderOfEachProducer)
+{
+  static int const NUM_PRODUCERS = 4;
+  static int const NUM_ELEMENTS = 100000;
+  lockfree_queue<uint64_t> queue(256);
+  vector<thread> producers;
+
+  for(int producer = 0; producer < NUM_PRODUCERS; ++producer)
+  {
+    producers.push_back(thread([&, producer] {
+      for(uint64_t i = 0; i < NUM_ELEMENTS; ++i)
+        queue.push((static_cast<uint64_t>(producer) << 32) | i);
+    }));
+  }
+
+  vector<uint64_t> next(NUM_PRODUCERS, 0);
+
+  for(int i = 0; i < NUM_PRODUCERS * NUM_ELEMENTS; ++i)
+  {
+    auto val = queue.pop();
+    auto producer = val >> 32;
+    ASSERT_LT(producer, static_cast<uint64_t>(NUM_PRODUCERS));
+    ASSERT_EQ(next[producer], val & 0xFFFFFFFF);
+    ++next[producer];
+  }
+
+  for(auto& producer: producers)
+    producer.join();
+
+  uint64_t val;
+  EXPECT_FALSE(queue.try_pop(val));
+}
+
+/* Every element is popped exactly once when several threads use try_pop, as the free Task list does */
+TEST(LockfreeQueue, TryPopFromSeveralConsumers)
+{
+  static int const NUM_CONSUMERS = 4;
+  static int const NUM_ELEMENTS = 200000;
+  lockfree_queue<int> queue(NUM_ELEMENTS);
+
+  for(int i = 0; i < NUM_ELEMENTS; ++i)
+    ASSERT_TRUE(queue.try_push(i));
+
+  vector<vector<int>> popped(NUM_CONSUMERS);
+  vector<thread> consumers;
+
+  for(int consumer = 0; consumer < NUM_CONSUMERS; ++consumer)
+  {
+    consumers.push_back(thread([&, consumer] {
+      int val;
+
+      while(queue.try_pop(val))
+        popped[consumer].push_back(val);
+    }));
+  }
+
+  for(auto& consumer: consumers)
+    consumer.join();
+
+  vector<int> seen(NUM_ELEMENTS, 0);
+
+  for(auto& elements: popped)
+  {
+    for(auto val: elements)
+      ++seen[val];
+  }
+
+  for(int i = 0; i < NUM_ELEMENTS; ++i)
+    ASSERT_EQ(1, seen[i]);
+}
+
+/* Burst: a few producers filling the queue while one consumer drains it */
+template<typename Queue>
+static double MeasureBurstRate(Queue& queue)
+{
+  static int const NUM_PRODUCERS = 3;
+  static int const NUM_ELEMENTS = 200000;
+  auto start = chrono::steady_clock::now();
+  vector<thread> producers;
+
+  for(int producer = 0; producer < NUM_PRODUCERS; ++producer)
+  {
+    producers.push_back(thread([&] {
+      for(int i = 0; i < NUM_ELEMENTS; ++i)
+        queue.push(i);
+    }));
+  }
+
+  for(int i = 0; i < NUM_PRODUCERS * NUM_ELEMENTS; ++i)
+    queue.pop();
+
+  for(auto& producer: producers)
+    producer.join();
+
+  chrono::duration<double, micro> elapsed = chrono::steady_clock::now() - start;
+  return NUM_PRODUCERS * NUM_ELEMENTS / elapsed.count();
+}
+
+/* ProcessorFifo pattern: one task at a time, the consumer wakes up for each of them */
+template<typename Queue>
+static double MeasureRoundTrip(Queue& request, Queue& reply)
+{
+  static int const NUM_ROUND_TRIPS = 20000;
+  thread consumer([&] {
+    for(int i = 0; i < NUM_ROUND_TRIPS; ++i)
+      reply.push(request.pop());
+  });
+
+  auto start = chrono::steady_clock::now();
+
+  for(int i = 0; i < NUM_ROUND_TRIPS; ++i)
+  {
+    request.push(i);
+    reply.pop();
+  }
+
+  chrono::duration<double, micro> elapsed = chrono::steady_clock::now() - start;
+  consumer.join();
+  return elapsed.count() / NUM_ROUND_TRIPS;
+}
+
+TEST(LockfreeQueueBenchmark, AgainstLockedQueue)
+{
+  locked_queue<int> locked[3];
+  lockfree_queue<int> lockfree[3];
+
+  auto lockedRate = MeasureBurstRate(locked[0]);
+  auto lockfreeRate = MeasureBurstRate(lockfree[0]);
+  cout << "burst: locked_queue " << lockedRate << " M/s, lockfree_queue " << lockfreeRate << " M/s" << endl;
+
+  auto lockedRoundTrip = MeasureRoundTrip(locked[1], locked[2]);
+  auto lockfreeRoundTrip = MeasureRoundTrip(lockfree[1], lockfree[2]);
+  cout << "round trip: locked_queue " << lockedRoundTrip << " us, lockfree_queue " << lockfreeRoundTrip << " us" << endl;
+
+  RecordProperty("burst_locked_kps", static_cast<int>(lockedRate * 1000));
+  RecordProperty("burst_lockfree_kps", static_cast<int>(lockfreeRate * 1000));
+  RecordProperty("round_trip_locked_ns", static_cast<int>(lockedRoundTrip * 1000));
+  RecordProperty("round_trip_lockfree_ns", static_cast<int>(lockfreeRoundTrip * 1000));
+}
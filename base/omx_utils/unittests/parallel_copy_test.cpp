@@ -0,0 +1,104 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "base/omx_utils/parallel_copy.h"
+
+using namespace std;
+
+static vector<uint8_t> Pattern(size_t size, int seed)
+{
+  vector<uint8_t> pattern(size);
+
+  for(size_t i = 0; i < size; ++i)
+    pattern[i] = static_cast<uint8_t>(i * 31 + seed);
+
+  return pattern;
+}
+
+TEST(ParallelCopy, CopiesUnalignedBuffersOfAnySize)
+{
+  size_t const sizes[] = { 0, 1, 63, 65, 1024 * 1024 - 1, 1024 * 1024 + 17, 4 * 1024 * 1024 + 3, 12441600 };
+
+  for(auto size : sizes)
+  {
+    for(size_t misalign = 0; misalign < 3; ++misalign)
+    {
+      auto src = Pattern(size + misalign, static_cast<int>(size));
+      vector<uint8_t> dst(size + misalign + 2, 0xAA);
+      ParallelCopy(dst.data() + 1 + misalign, src.data() + misalign, size);
+
+      EXPECT_EQ(0xAA, dst[misalign]);
+      EXPECT_EQ(0xAA, dst[size + misalign + 1]);
+      EXPECT_TRUE(equal(src.begin() + misalign, src.end(), dst.begin() + 1 + misalign)) << "size " << size << " misalign " << misalign;
+    }
+  }
+}
+
+TEST(ParallelCopy, CopiesFromSeveralThreadsAtOnce)
+{
+  static int const NUM_CALLERS = 4;
+  static size_t const SIZE = 8 * 1024 * 1024 + 5;
+  vector<vector<uint8_t>> sources, destinations;
+
+  for(int i = 0; i < NUM_CALLERS; ++i)
+  {
+    sources.push_back(Pattern(SIZE, i));
+    destinations.push_back(vector<uint8_t>(SIZE));
+  }
+
+  vector<thread> callers;
+
+  for(int i = 0; i < NUM_CALLERS; ++i)
+  {
+    callers.push_back(thread([&, i] {
+      for(int repeat = 0; repeat < 10; ++repeat)
+        ParallelCopy(destinations[i].data(), sources[i].data(), SIZE);
+    }));
+  }
+
+  for(auto& caller : callers)
+    caller.join();
+
+  for(int i = 0; i < NUM_CALLERS; ++i)
+    EXPECT_TRUE(sources[i] == destinations[i]);
+}
@@ -0,0 +1,164 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "base/omx_utils/processor_pool.h"
+
+using namespace std;
+
+static void* ToElement(intptr_t value)
+{
+  return reinterpret_cast<void*>(value);
+}
+
+static intptr_t FromElement(void* element)
+{
+  return reinterpret_cast<intptr_t>(element);
+}
+
+TEST(ProcessorStrand, ProcessesTheElementsInOrder)
+{
+  static int const NUM_ELEMENTS = 10000;
+  vector<intptr_t> processed;
+  atomic<int> done { 0 };
+  atomic<int> deleted { 0 };
+  {
+    // the elements are pushed from the pool workers: only the strand serializes them
+    ProcessorStrand strand(make_shared<ProcessorPool>(4),
+                           [&](void* element) { processed.push_back(FromElement(element)); ++done; },
+                           [&](void*) { ++deleted; });
+
+    for(int i = 1; i <= NUM_ELEMENTS; ++i)
+      strand.queue(ToElement(i));
+
+    while(done.load() + deleted.load() < NUM_ELEMENTS)
+      this_thread::yield();
+  }
+
+  EXPECT_EQ(0, deleted.load());
+  ASSERT_EQ(NUM_ELEMENTS, (int)processed.size());
+
+  for(int i = 0; i < NUM_ELEMENTS; ++i)
+    EXPECT_EQ(i + 1, processed[i]);
+}
+
+/* Strands of one pool share its workers, an element of a strand never runs alongside another of the same strand */
+TEST(ProcessorStrand, NeverRunsTwoElementsOfAStrandAtOnce)
+{
+  static int const NUM_STRANDS = 8;
+  static int const NUM_ELEMENTS = 2000;
+  auto pool = make_shared<ProcessorPool>(4);
+  atomic<int> running[NUM_STRANDS];
+  atomic<int> overlaps { 0 };
+  atomic<int> processed { 0 };
+  vector<unique_ptr<ProcessorStrand>> strands;
+
+  for(int s = 0; s < NUM_STRANDS; ++s)
+  {
+    running[s] = 0;
+    strands.emplace_back(new ProcessorStrand(pool, [&, s](void*) {
+      if(running[s].fetch_add(1) != 0)
+        ++overlaps;
+      this_thread::yield();
+      running[s].fetch_sub(1);
+      ++processed;
+    }, [](void*) {}));
+  }
+
+  vector<thread> producers;
+
+  for(int s = 0; s < NUM_STRANDS; ++s)
+  {
+    producers.push_back(thread([&, s] {
+      for(int i = 0; i < NUM_ELEMENTS; ++i)
+        strands[s]->queue(ToElement(i));
+    }));
+  }
+
+  for(auto& producer : producers)
+    producer.join();
+
+  while(processed.load() < NUM_STRANDS * NUM_ELEMENTS)
+    this_thread::yield();
+
+  strands.clear();
+  EXPECT_EQ(0, overlaps.load());
+}
+
+TEST(ProcessorStrand, DeletesThePendingElementsWhenDestroyed)
+{
+  static int const NUM_ELEMENTS = 100;
+  atomic<int> processed { 0 };
+  atomic<int> deleted { 0 };
+  atomic<bool> started { false };
+  atomic<bool> release { false };
+  thread releaser;
+  {
+    ProcessorStrand strand(make_shared<ProcessorPool>(1), [&](void*) {
+      // hold the worker until the destructor started
+      started = true;
+
+      while(!release.load())
+        this_thread::yield();
+      ++processed;
+    }, [&](void*) { ++deleted; });
+
+    for(int i = 0; i < NUM_ELEMENTS; ++i)
+      strand.queue(ToElement(i));
+
+    while(!started.load())
+      this_thread::yield();
+
+    releaser = thread([&] {
+      this_thread::sleep_for(chrono::milliseconds(20));
+      release = true;
+    });
+  }
+
+  releaser.join();
+
+  // the element already running finishes, the others are deleted instead of processed
+  EXPECT_EQ(1, processed.load());
+  EXPECT_EQ(NUM_ELEMENTS - 1, deleted.load());
+}
@@ -0,0 +1,212 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "base/omx_utils/slot_registry.h"
+#include "base/omx_utils/threadsafe_map.h"
+#include "base/omx_utils/flat_map.h"
+
+using namespace std;
+
+struct Record
+{
+  atomic<void*> inFlight;
+  atomic<void*> used;
+};
+
+TEST(SlotRegistry, GivesBackSlotsForReuse)
+{
+  SlotRegistry<Record> slots;
+  set<int> acquired;
+
+  for(int i = 0; i < 100; ++i)
+    EXPECT_TRUE(acquired.insert(slots.Acquire()).second);
+
+  EXPECT_EQ(0, *acquired.begin());
+  EXPECT_EQ(99, *acquired.rbegin());
+
+  slots.Release(42);
+  EXPECT_EQ(42, slots.Acquire());
+  EXPECT_EQ(100, slots.Acquire());
+}
+
+TEST(SlotRegistry, ForEachVisitsTheAcquiredSlots)
+{
+  SlotRegistry<Record> slots;
+
+  for(int i = 0; i < 10; ++i)
+    slots.Acquire();
+
+  slots.Release(3);
+  slots.Release(7);
+
+  vector<int> visited;
+  slots.ForEach([&](int slot, Record&) {
+    visited.push_back(slot);
+  });
+
+  EXPECT_EQ(vector<int>({ 0, 1, 2, 4, 5, 6, 8, 9 }), visited);
+}
+
+TEST(SlotRegistry, ForEachWhileSlotsAreAddedAndReleased)
+{
+  SlotRegistry<Record> slots;
+  atomic<bool> done { false };
+
+  /* each round hands out a new slot that goes straight back to the free list */
+  thread churn([&] {
+    for(int i = 0; i < 2000; ++i)
+    {
+      int first = slots.Acquire();
+      int second = slots.Acquire();
+      slots.Release(second);
+      slots.Release(first);
+      slots.Acquire();
+    }
+
+    done = true;
+  });
+
+  while(!done)
+  {
+    slots.ForEach([&](int slot, Record&) {
+      ASSERT_TRUE(slots.IsValid(slot));
+    });
+  }
+
+  churn.join();
+}
+
+TEST(SlotRegistry, RecordsDoNotMoveWhenSlotsAreAdded)
+{
+  SlotRegistry<Record> slots;
+  auto first = slots.Acquire();
+  auto record = &slots[first];
+  atomic<bool> isDone { false };
+  atomic<int> mismatches { 0 };
+
+  thread reader([&] {
+    while(!isDone.load())
+    {
+      if(&slots[first] != record)
+        ++mismatches;
+    }
+  });
+
+  for(int i = 0; i < 10 * SlotRegistry<Record>::CHUNK_SIZE; ++i)
+    slots.Acquire();
+
+  isDone = true;
+  reader.join();
+  EXPECT_EQ(0, mismatches.load());
+}
+
+static int const NUM_BUFFERS = 16;
+static int const NUM_FRAMES = 1000000;
+
+/* One frame of the encoder bookkeeping: the buffer is used, queued to the encoder,
+ * looked up twice by the callbacks then released */
+template<typename Frame>
+static double MeasureFrames(Frame frame)
+{
+  auto start = chrono::steady_clock::now();
+
+  for(int i = 0; i < NUM_FRAMES; ++i)
+    frame(i % NUM_BUFFERS);
+
+  chrono::duration<double, nano> elapsed = chrono::steady_clock::now() - start;
+  return elapsed.count() / NUM_FRAMES;
+}
+
+TEST(SlotRegistryBenchmark, AgainstPointerKeyedMaps)
+{
+  vector<uint64_t> buffers(NUM_BUFFERS);
+  vector<uint64_t> handles(NUM_BUFFERS);
+  uintptr_t checksum = 0;
+
+  ThreadSafeMap<void*, void*> lockedUsed, lockedInFlight;
+  auto lockedTime = MeasureFrames([&](int i) {
+    lockedUsed.Add(&handles[i], &buffers[i]);
+    auto buffer = lockedUsed.Get(&handles[i]);
+    lockedInFlight.Add(buffer, &handles[i]);
+    checksum += (uintptr_t)lockedInFlight.Get(buffer);
+    auto handle = lockedInFlight.Pop(buffer);
+    checksum += (uintptr_t)lockedUsed.Pop(handle);
+  });
+
+  FlatMap<void*, void*> flatUsed, flatInFlight;
+  auto flatTime = MeasureFrames([&](int i) {
+    flatUsed.Add(&handles[i], &buffers[i]);
+    auto buffer = flatUsed.Get(&handles[i]);
+    flatInFlight.Add(buffer, &handles[i]);
+    checksum += (uintptr_t)flatInFlight.Get(buffer);
+    auto handle = flatInFlight.Pop(buffer);
+    checksum += (uintptr_t)flatUsed.Pop(handle);
+  });
+
+  SlotRegistry<Record> slots;
+  slots.Reserve(NUM_BUFFERS);
+
+  for(int i = 0; i < NUM_BUFFERS; ++i)
+    slots.Acquire();
+
+  auto slotTime = MeasureFrames([&](int i) {
+    auto& record = slots[i];
+    record.used.store(&buffers[i], memory_order_release);
+    auto buffer = record.used.load(memory_order_acquire);
+    record.inFlight.store(&handles[i], memory_order_release);
+    checksum += (uintptr_t)record.inFlight.load(memory_order_acquire) + (uintptr_t)buffer;
+    record.inFlight.exchange(nullptr, memory_order_acq_rel);
+    checksum += (uintptr_t)record.used.exchange(nullptr, memory_order_acq_rel);
+  });
+
+  cout << "per frame: ThreadSafeMap " << lockedTime << " ns, FlatMap " << flatTime << " ns, SlotRegistry " << slotTime << " ns" << endl;
+
+  RecordProperty("frame_threadsafe_map_ps", static_cast<int>(lockedTime * 1000));
+  RecordProperty("frame_flat_map_ps", static_cast<int>(flatTime * 1000));
+  RecordProperty("frame_slot_registry_ps", static_cast<int>(slotTime * 1000));
+  EXPECT_NE(0u, checksum);
+}
@@ -0,0 +1,210 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include "AsyncWriter.h"
+#include "helpers.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+static size_t constexpr BLOCK_ALIGNMENT = 4096;
+
+AsyncWriter::AsyncWriter(string const& path, bool useDMA, bool useDirectIO, function<void(OMX_BUFFERHEADERTYPE*)> release) :
+  fd{-1},
+  useDMA{useDMA},
+  isDirectIO{false},
+  release{release},
+  block{nullptr},
+  blockFilled{0}
+{
+  auto flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+
+  /* not every filesystem takes O_DIRECT */
+  if(useDirectIO)
+  {
+    fd = open(path.c_str(), flags | O_DIRECT, 0666);
+    isDirectIO = (fd != -1);
+  }
+
+  if(fd == -1)
+    fd = open(path.c_str(), flags, 0666);
+
+  if(fd == -1)
+    return;
+
+  void* data;
+
+  if(posix_memalign(&data, BLOCK_ALIGNMENT, BLOCK_SIZE) != 0)
+  {
+    ::close(fd);
+    fd = -1;
+    return;
+  }
+
+  block = static_cast<char*>(data);
+  writer = thread(&AsyncWriter::run, this);
+}
+
+AsyncWriter::~AsyncWriter()
+{
+  close();
+}
+
+bool AsyncWriter::isOpen() const
+{
+  return fd != -1;
+}
+
+void AsyncWriter::write(OMX_BUFFERHEADERTYPE* header, WriterRows const& rows)
+{
+  assert(header);
+  jobs.push({ header, { rows, {} }, 1 });
+}
+
+void AsyncWriter::write(OMX_BUFFERHEADERTYPE* header, WriterRows const& luma, WriterRows const& chroma)
+{
+  assert(header);
+  jobs.push({ header, { luma, chroma }, 2 });
+}
+
+void AsyncWriter::close()
+{
+  if(!writer.joinable())
+    return;
+
+  jobs.push({ nullptr, {}, 0 });
+  writer.join();
+
+  for(auto& mapping : mappings)
+    Buffer_UnmapData(mapping.second, mapping.first->nAllocLen, useDMA);
+
+  mappings.clear();
+
+  /* the tail of the file is not a whole block */
+  if(isDirectIO && blockFilled)
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_DIRECT);
+
+  writeBlock(blockFilled);
+  free(block);
+  block = nullptr;
+  ::close(fd);
+  fd = -1;
+}
+
+char* AsyncWriter::map(OMX_BUFFERHEADERTYPE* header)
+{
+  if(!useDMA)
+    return (char*)header->pBuffer;
+
+  auto mapping = mappings.find(header);
+
+  if(mapping != mappings.end())
+    return mapping->second;
+
+  auto data = Buffer_MapData((char*)header->pBuffer, header->nAllocLen, useDMA);
+
+  if(data)
+    mappings[header] = data;
+
+  return data;
+}
+
+void AsyncWriter::run()
+{
+  while(true)
+  {
+    auto job = jobs.pop();
+
+    if(!job.header)
+      break;
+
+    auto data = map(job.header);
+    assert(data);
+
+    for(auto plane = 0; plane < job.numPlanes && data; ++plane)
+    {
+      auto& rows = job.planes[plane];
+
+      for(auto h = 0; h < rows.numRows; ++h)
+        append(data + job.header->nOffset + rows.offset + h * rows.stride, rows.rowSize);
+    }
+
+    release(job.header);
+  }
+}
+
+void AsyncWriter::append(char const* data, size_t size)
+{
+  while(size > 0)
+  {
+    auto chunk = min(size, BLOCK_SIZE - blockFilled);
+    memcpy(block + blockFilled, data, chunk);
+    blockFilled += chunk;
+    data += chunk;
+    size -= chunk;
+
+    if(blockFilled == BLOCK_SIZE)
+      writeBlock(BLOCK_SIZE);
+  }
+}
+
+void AsyncWriter::writeBlock(size_t size)
+{
+  size_t written = 0;
+
+  while(written < size)
+  {
+    auto ret = ::write(fd, block + written, size - written);
+
+    if(ret <= 0)
+    {
+      cerr << "Error while writing the output file" << endl;
+      break;
+    }
+
+    written += ret;
+  }
+
+  blockFilled = 0;
+}
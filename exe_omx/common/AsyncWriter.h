@@ -0,0 +1,103 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include <OMX_Core.h>
+
+#include "base/omx_utils/locked_queue.h"
+
+/* numRows rows of rowSize bytes, stride bytes apart, from offset in the buffer */
+struct WriterRows
+{
+  size_t offset;
+  size_t rowSize;
+  size_t stride;
+  int numRows;
+};
+
+/* Output file written on its own thread so that the OMX callbacks return at once.
+ * The rows of the queued buffers are gathered in large aligned blocks, a buffer is released once its rows are copied.
+ * dmabufs stay mapped until close. */
+class AsyncWriter
+{
+public:
+  static size_t constexpr BLOCK_SIZE = 4 * 1024 * 1024;
+
+  AsyncWriter(std::string const& path, bool useDMA, bool useDirectIO, std::function<void(OMX_BUFFERHEADERTYPE*)> release);
+  ~AsyncWriter();
+
+  bool isOpen() const;
+
+  /* buffers are released in the order they are queued, even the ones without rows */
+  void write(OMX_BUFFERHEADERTYPE* header, WriterRows const& rows);
+  void write(OMX_BUFFERHEADERTYPE* header, WriterRows const& luma, WriterRows const& chroma);
+
+  /* write what is queued and unmap the buffers, before they are freed */
+  void close();
+
+private:
+  struct Job
+  {
+    OMX_BUFFERHEADERTYPE* header;
+    WriterRows planes[2];
+    int numPlanes;
+  };
+
+  int fd;
+  bool const useDMA;
+  bool isDirectIO;
+  std::function<void(OMX_BUFFERHEADERTYPE*)> const release;
+
+  locked_queue<Job> jobs;
+  std::thread writer;
+
+  char* block;
+  size_t blockFilled;
+  std::unordered_map<OMX_BUFFERHEADERTYPE*, char*> mappings;
+
+  void run();
+  char* map(OMX_BUFFERHEADERTYPE* header);
+  void append(char const* data, size_t size);
+  void writeBlock(size_t size);
+};
@@ -1,7 +1,13 @@
-THIS.exe_omx_common=$(call get-my-dir)
+THIS.exe_omx_common:=$(call get-my-dir)
 
 EXE_OMX_COMMON_SRCS+=\
 	$(THIS.exe_omx_common)/getters.cpp\
 	$(THIS.exe_omx_common)/setters.cpp\
 	$(THIS.exe_omx_common)/helpers.cpp\
+	$(THIS.exe_omx_common)/AsyncWriter.cpp\
 
+UNITTESTS+=\
+	$(THIS.exe_omx_common)/helpers.cpp\
+	$(THIS.exe_omx_common)/AsyncWriter.cpp\
+
+UNITTESTS+=$(shell find $(THIS.exe_omx_common)/unittests -name "*.cpp")
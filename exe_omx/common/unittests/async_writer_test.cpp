@@ -0,0 +1,195 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "exe_omx/common/AsyncWriter.h"
+
+using namespace std;
+
+/* A host buffer holding a strided two-plane frame behind an offset, like the decoder outputs */
+struct Frame
+{
+  Frame(int index, size_t width, size_t stride, int height) :
+    data(64 + stride * height * 2),
+    header {},
+    luma { 0, width, stride, height },
+    chroma { stride * height + stride / 2, width, stride, height / 2 }
+  {
+    mt19937 random(index);
+
+    for(auto& byte : data)
+      byte = static_cast<char>(random());
+
+    header.nSize = sizeof(header);
+    header.pBuffer = reinterpret_cast<OMX_U8*>(data.data());
+    header.nAllocLen = data.size();
+    header.nOffset = 64;
+    header.nFilledLen = data.size() - header.nOffset;
+  }
+
+  /* the bytes the writer has to gather */
+  string Expected() const
+  {
+    string expected;
+
+    for(auto planeRows : { luma, chroma })
+    {
+      for(int h = 0; h < planeRows.numRows; ++h)
+        expected.append(data.data() + header.nOffset + planeRows.offset + h * planeRows.stride, planeRows.rowSize);
+    }
+
+    return expected;
+  }
+
+  vector<char> data;
+  OMX_BUFFERHEADERTYPE header;
+  WriterRows luma;
+  WriterRows chroma;
+};
+
+static string ReadFile(string const& path)
+{
+  ifstream file(path, ios::binary);
+  return string(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+}
+
+struct Released
+{
+  mutex lock;
+  vector<OMX_BUFFERHEADERTYPE*> headers;
+
+  function<void(OMX_BUFFERHEADERTYPE*)> Callback()
+  {
+    return [this](OMX_BUFFERHEADERTYPE* header)
+           {
+             lock_guard<mutex> guard(lock);
+             headers.push_back(header);
+           };
+  }
+};
+
+/* frames, a buffer without rows in the middle, then the end of stream */
+static void WriteFrames(bool useDirectIO, size_t width, size_t stride, int height, int numFrames)
+{
+  auto path = testing::TempDir() + (useDirectIO ? "async_writer_test_direct.yuv" : "async_writer_test.yuv");
+  vector<unique_ptr<Frame>> frames;
+  vector<char> nothing(16);
+  OMX_BUFFERHEADERTYPE empty {};
+  OMX_BUFFERHEADERTYPE eos {};
+  empty.pBuffer = eos.pBuffer = reinterpret_cast<OMX_U8*>(nothing.data());
+  empty.nAllocLen = eos.nAllocLen = nothing.size();
+  eos.nFlags = OMX_BUFFERFLAG_EOS;
+  vector<OMX_BUFFERHEADERTYPE*> queued;
+  string expected;
+  Released released;
+
+  for(int i = 0; i < numFrames; ++i)
+    frames.emplace_back(new Frame(i, width, stride, height));
+
+  {
+    AsyncWriter writer(path, false, useDirectIO, released.Callback());
+    ASSERT_TRUE(writer.isOpen());
+
+    for(int i = 0; i < numFrames; ++i)
+    {
+      auto& frame = *frames[i];
+      writer.write(&frame.header, frame.luma, frame.chroma);
+      queued.push_back(&frame.header);
+      expected += frame.Expected();
+
+      if(i == numFrames / 2)
+      {
+        writer.write(&empty, { 0, 0, 0, 0 });
+        queued.push_back(&empty);
+      }
+    }
+
+    writer.write(&eos, { 0, 0, 0, 1 });
+    queued.push_back(&eos);
+    writer.close();
+
+    EXPECT_FALSE(writer.isOpen());
+  }
+
+  EXPECT_EQ(queued, released.headers);
+
+  auto written = ReadFile(path);
+  ASSERT_EQ(expected.size(), written.size());
+  EXPECT_TRUE(expected == written);
+  remove(path.c_str());
+}
+
+TEST(AsyncWriter, GathersTheStridedPlanesInQueueOrder)
+{
+  WriteFrames(false, 1001, 1024, 37, 6);
+}
+
+/* more than a block, and a tail that isn't a whole block */
+TEST(AsyncWriter, DirectIOWritesTheTail)
+{
+  ASSERT_NE(0u, (1918 * 1080 * 3 / 2 * 3) % 512);
+  WriteFrames(true, 1918, 2048, 1080, 3);
+}
+
+TEST(AsyncWriter, SmallerThanABlockWithDirectIO)
+{
+  WriteFrames(true, 1001, 1024, 37, 2);
+}
+
+TEST(AsyncWriter, CloseWithNothingQueued)
+{
+  auto path = testing::TempDir() + "async_writer_test_empty.yuv";
+  Released released;
+
+  {
+    AsyncWriter writer(path, false, true, released.Callback());
+    ASSERT_TRUE(writer.isOpen());
+  }
+
+  EXPECT_TRUE(released.headers.empty());
+  EXPECT_EQ("", ReadFile(path));
+  remove(path.c_str());
+}
@@ -73,6 +73,7 @@ extern "C"
 #include "../common/helpers.h"
 #include "../common/setters.h"
 #include "../common/CommandLineParser.h"
+#include "../common/AsyncWriter.h"
 
 extern "C"
 {
@@ -99,6 +100,7 @@ enum DecCodec
 #include <thread>
 #include <mutex>
 #include <condition_variable>
+#include <atomic>
 
 #include <functional>
 
@@ -217,6 +219,7 @@ struct Settings
   OMX_U32 framerate = 1 << 16;
   OMX_ALG_SEQUENCE_PICTURE_MODE sequencePicture = OMX_ALG_SEQUENCE_PICTURE_FRAME;
   bool hasPrealloc = false;
+  bool bDirectIO = false;
 };
 
 struct Application
@@ -240,7 +243,7 @@ struct Application
 string input_file;
 string output_file;
 ifstream infile;
-ofstream outfile;
+unique_ptr<AsyncWriter> writer;
 
 static OMX_PARAM_PORTDEFINITIONTYPE paramPort;
 
@@ -362,6 +365,7 @@ void parseCommandLine(int argc, char** argv, Application& app)
     settings.bDMAOut = true;
     settings.eDMAOut = OMX_ALG_BUF_DMA;
   }, "use dmabufs for output port");
+  opt.addFlag("--direct-io,-direct-io", &settings.bDirectIO, "Write the output file with O_DIRECT");
   string prealloc_args = "";
   opt.addString("--prealloc-args", &prealloc_args, "Specify the stream dimension: 1920x1080:unkwn:nv12:omx-profile-value:omx-level-value");
 
@@ -676,65 +680,56 @@ OMX_ERRORTYPE onInputBufferAvailable(OMX_HANDLETYPE /*hComponent*/, OMX_PTR pApp
   return OMX_ErrorNone;
 }
 
-OMX_ERRORTYPE onOutputBufferAvailable(OMX_HANDLETYPE hComponent, OMX_PTR pAppData, OMX_BUFFERHEADERTYPE* pBuffer)
+static atomic<bool> isEndOfStream(false);
+
+OMX_ERRORTYPE onOutputBufferAvailable(OMX_HANDLETYPE /*hComponent*/, OMX_PTR pAppData, OMX_BUFFERHEADERTYPE* pBuffer)
 {
-  static bool end = false;
   auto app = static_cast<Application*>(pAppData);
 
   LOGV("one output buffer is available");
 
-  if(end)
+  if(isEndOfStream)
     return OMX_ErrorNone;
 
   if(!pBuffer)
     return OMX_ErrorBadParameter;
 
-  if(pBuffer->nFilledLen)
+  if(!pBuffer->nFilledLen)
   {
-    auto data = Buffer_MapData((char*)(pBuffer->pBuffer + pBuffer->nOffset), pBuffer->nAllocLen, app->settings.bDMAOut);
+    writer->write(pBuffer, { 0, 0, 0, 0 });
+    return OMX_ErrorNone;
+  }
 
-    if(data)
-    {
-      OMX_PARAM_PORTDEFINITIONTYPE param;
-
-      initHeader(param);
-      param.nPortIndex = 1;
-      OMX_CALL(OMX_GetParameter(app->hDecoder, OMX_IndexParamPortDefinition, &param));
-      auto videoDef = param.format.video;
-      auto stride = videoDef.nStride;
-      auto sliceHeight = videoDef.nSliceHeight;
-      auto coef = is422(videoDef.eColorFormat) ? 1 : 2;
-      auto height = videoDef.nFrameHeight;
-      auto row_size = is10bits(videoDef.eColorFormat) ? (((videoDef.nFrameWidth + 2) / 3) * 4) : videoDef.nFrameWidth;
-
-      /* luma */
-      for(auto h = 0; h < (int)height; h++)
-        outfile.write(&data[h * stride], row_size);
-
-      /* chroma */
-      for(auto h = sliceHeight; h < sliceHeight + height / coef; h++)
-        outfile.write(&data[h * stride], row_size);
-
-      outfile.flush();
-    }
-    else
-      assert(0);
+  OMX_PARAM_PORTDEFINITIONTYPE param;
 
-    Buffer_UnmapData(data, pBuffer->nAllocLen, app->settings.bDMAOut);
-  }
+  initHeader(param);
+  param.nPortIndex = 1;
+  OMX_CALL(OMX_GetParameter(app->hDecoder, OMX_IndexParamPortDefinition, &param));
+  auto videoDef = param.format.video;
+  size_t stride = videoDef.nStride;
+  size_t sliceHeight = videoDef.nSliceHeight;
+  auto coef = is422(videoDef.eColorFormat) ? 1 : 2;
+  auto height = (int)videoDef.nFrameHeight;
+  size_t row_size = is10bits(videoDef.eColorFormat) ? (((videoDef.nFrameWidth + 2) / 3) * 4) : videoDef.nFrameWidth;
+
+  writer->write(pBuffer, { 0, row_size, stride, height }, { sliceHeight * stride, row_size, stride, height / coef });
+
+  return OMX_ErrorNone;
+}
 
+/* writer thread: the picture was copied */
+static void onOutputBufferWritten(Application& app, OMX_BUFFERHEADERTYPE* pBuffer)
+{
   pBuffer->nFilledLen = 0;
   bool wasEos = pBuffer->nFlags == OMX_BUFFERFLAG_EOS;
 
-  OMX_CALL(OMX_FillThisBuffer(hComponent, pBuffer));
+  OMX_FillThisBuffer(app.hDecoder, pBuffer);
 
   if(wasEos)
   {
-    end = true;
-    app->eventBus.queueEvent({ eosEvent, nullptr });
+    isEndOfStream = true;
+    app.eventBus.queueEvent({ eosEvent, nullptr });
   }
-
-  return OMX_ErrorNone;
 }
 
 static bool readFrame(OMX_BUFFERHEADERTYPE* pInputBuf, Application& app)
@@ -1047,6 +1042,7 @@ void deletePipeline(Application* app)
   if(err != OMX_ErrorNone)
     app->eventBus.queueEvent({ errorEvent, make_shared<ErrorEventData>(err) });
 
+  writer->close();
   freeBuffers(inportIndex, *app);
   freeBuffers(outportIndex, *app);
 
@@ -1101,9 +1097,11 @@ OMX_ERRORTYPE safeMain(int argc, char** argv)
     return OMX_ErrorUndefined;
   }
 
-  outfile.open(output_file, ios::binary);
+  writer.reset(new AsyncWriter(output_file, app.settings.bDMAOut, app.settings.bDirectIO, [&app](OMX_BUFFERHEADERTYPE* pBuffer) {
+    onOutputBufferWritten(app, pBuffer);
+  }));
 
-  if(!outfile.is_open())
+  if(!writer->isOpen())
   {
     cerr << "Error in opening output file '" << output_file << "'" << endl;
     return OMX_ErrorUndefined;
@@ -1161,7 +1159,7 @@ OMX_ERRORTYPE safeMain(int argc, char** argv)
 
   cerr.flush();
   infile.close();
-  outfile.close();
+  writer.reset();
   return OMX_ErrorNone;
 }
 
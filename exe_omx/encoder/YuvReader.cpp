@@ -0,0 +1,221 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include "YuvReader.h"
+
+#include <cassert>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+YuvReader::YuvReader(string const& path) :
+  fd{open(path.c_str(), O_RDONLY | O_CLOEXEC)},
+  mapping{nullptr},
+  mappingSize{0},
+  frameSize{0},
+  firstFrame{0},
+  numFrames{-1},
+  produced{0},
+  consumed{0},
+  isHandedOut{false},
+  isFinished{false},
+  quit{false}
+{
+  if(fd == -1)
+    return;
+
+  struct stat info;
+
+  if(fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size == 0)
+    return;
+
+  auto data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+  if(data == MAP_FAILED)
+    return;
+
+  mapping = static_cast<uint8_t*>(data);
+  mappingSize = info.st_size;
+  madvise(mapping, mappingSize, MADV_SEQUENTIAL);
+}
+
+YuvReader::~YuvReader()
+{
+  unique_lock<std::mutex> lock(mutex);
+  quit = true;
+  cv.notify_all();
+  lock.unlock();
+
+  if(prefetcher.joinable())
+    prefetcher.join();
+
+  if(mapping)
+    munmap(mapping, mappingSize);
+
+  if(fd != -1)
+    close(fd);
+}
+
+bool YuvReader::isOpen() const
+{
+  return fd != -1;
+}
+
+void YuvReader::start(size_t frameSize, int firstFrame, int numFrames)
+{
+  assert(isOpen());
+  assert(!prefetcher.joinable());
+  assert(frameSize > 0);
+  this->frameSize = frameSize;
+  this->firstFrame = firstFrame;
+  this->numFrames = numFrames;
+
+  if(!mapping)
+    ring.assign(PREFETCH_FRAMES, vector<uint8_t>(frameSize));
+
+  prefetcher = thread(&YuvReader::prefetch, this);
+}
+
+uint8_t const* YuvReader::next()
+{
+  unique_lock<std::mutex> lock(mutex);
+
+  if(isHandedOut)
+  {
+    isHandedOut = false;
+    ++consumed;
+    cv.notify_all();
+  }
+
+  cv.wait(lock, [&] { return produced > consumed || isFinished; });
+
+  if(produced == consumed)
+    return nullptr;
+
+  isHandedOut = true;
+
+  if(mapping)
+    return mapping + (firstFrame + consumed) * frameSize;
+
+  return ring[consumed % PREFETCH_FRAMES].data();
+}
+
+static bool readFully(int fd, uint8_t* data, size_t size)
+{
+  while(size > 0)
+  {
+    auto ret = read(fd, data, size);
+
+    if(ret <= 0)
+      return false;
+
+    data += ret;
+    size -= ret;
+  }
+
+  return true;
+}
+
+/* regular files are seeked, the frames before the first one are read and dropped otherwise */
+static bool skipFrames(int fd, size_t frameSize, int numFrames, vector<uint8_t>& scratch)
+{
+  if(lseek(fd, static_cast<off_t>(frameSize) * numFrames, SEEK_SET) != -1)
+    return true;
+
+  for(auto i = 0; i < numFrames; ++i)
+  {
+    if(!readFully(fd, scratch.data(), frameSize))
+      return false;
+  }
+
+  return true;
+}
+
+bool YuvReader::prefetchFrame(int frame)
+{
+  if(!mapping)
+    return readFully(fd, ring[frame % PREFETCH_FRAMES].data(), frameSize);
+
+  auto offset = (firstFrame + frame) * frameSize;
+
+  if(offset + frameSize > mappingSize)
+    return false;
+
+  size_t pageSize = getpagesize();
+  auto data = mapping + offset;
+  auto misalignment = offset % pageSize;
+  madvise(data - misalignment, frameSize + misalignment, MADV_WILLNEED);
+
+  /* fault the pages in here so that the encoder callbacks never wait for the disk */
+  uint8_t sum = 0;
+
+  for(size_t i = 0; i < frameSize; i += pageSize)
+    sum += *(volatile uint8_t*)&data[i];
+
+  (void)sum;
+  return true;
+}
+
+void YuvReader::prefetch()
+{
+  auto isReadable = mapping || skipFrames(fd, frameSize, firstFrame, ring[0]);
+
+  for(auto frame = 0; isReadable && (numFrames < 0 || frame < numFrames); ++frame)
+  {
+    unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [&] { return frame - consumed < PREFETCH_FRAMES || quit; });
+
+    if(quit)
+      return;
+
+    lock.unlock();
+
+    if(!prefetchFrame(frame))
+      break;
+
+    lock.lock();
+    ++produced;
+    cv.notify_all();
+  }
+
+  lock_guard<std::mutex> lock(mutex);
+  isFinished = true;
+  cv.notify_all();
+}
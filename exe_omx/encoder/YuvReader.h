@@ -0,0 +1,88 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/* Input frames of a raw yuv file, read ahead of the encoder on a thread.
+ * Regular files are mapped: the thread faults the next frames in and the frames are handed from the mapping.
+ * Pipes and devices are read into a ring of frames. */
+class YuvReader
+{
+public:
+  static int constexpr PREFETCH_FRAMES = 4;
+
+  explicit YuvReader(std::string const& path);
+  ~YuvReader();
+
+  bool isOpen() const;
+
+  /* frames of frameSize bytes from firstFrame, all the input when numFrames is negative */
+  void start(size_t frameSize, int firstFrame, int numFrames);
+
+  /* next frame or nullptr at the end of the input, valid until the next call */
+  uint8_t const* next();
+
+private:
+  int fd;
+  uint8_t* mapping;
+  size_t mappingSize;
+
+  size_t frameSize;
+  int firstFrame;
+  int numFrames;
+  std::vector<std::vector<uint8_t>> ring;
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  int produced;
+  int consumed;
+  bool isHandedOut;
+  bool isFinished;
+  bool quit;
+  std::thread prefetcher;
+
+  void prefetch();
+  bool prefetchFrame(int frame);
+};
@@ -50,6 +50,9 @@
 #include <fstream>
 #include <vector>
 #include <atomic>
+#include <thread>
+#include <memory>
+#include <algorithm>
 #include <unistd.h>
 
 #if __ANDROID_API__
@@ -76,6 +79,7 @@ extern "C"
 
 #include "CommandsSender.h"
 #include "EncCmdMngr.h"
+#include "YuvReader.h"
 
 #include "base/omx_utils/locked_queue.h"
 #include "base/omx_utils/semaphore.h"
@@ -86,6 +90,11 @@ extern "C"
 #include "../common/setters.h"
 #include "../common/getters.h"
 #include "../common/CommandLineParser.h"
+#include "../common/AsyncWriter.h"
+
+#if AL_ENABLE_TWOPASS
+#include "base/omx_module/TwoPassMngr.h"
+#endif
 
 extern "C"
 {
@@ -123,6 +132,7 @@ struct Settings
   EncCodec codec;
   OMX_COLOR_FORMATTYPE format;
   int lookahead;
+  bool sceneChangeDetection;
 };
 
 struct Application
@@ -144,6 +154,15 @@ struct Application
 
   CEncCmdMngr* encCmd;
   CommandsSender* cmdSender;
+
+  unique_ptr<YuvReader> reader;
+  unique_ptr<AsyncWriter> writer;
+  OMX_PARAM_PORTDEFINITIONTYPE paramPort;
+
+  /* frames of the input to encode, all the input when numFrames is negative */
+  int firstFrame;
+  int numFrames;
+  int frame;
 };
 
 static inline void SetDefaultSettings(Settings& settings)
@@ -154,6 +173,7 @@ static inline void SetDefaultSettings(Settings& settings)
   settings.codec = HEVC;
   settings.format = OMX_COLOR_FormatYUV420SemiPlanar;
   settings.lookahead = 0;
+  settings.sceneChangeDetection = false;
 }
 
 static inline void SetDefaultApplication(Application& app)
@@ -169,6 +189,9 @@ static inline void SetDefaultApplication(Application& app)
   app.output.isFlushing = false;
   app.output.isEOS = false;
   app.read = false;
+  app.firstFrame = 0;
+  app.numFrames = -1;
+  app.frame = 0;
 }
 
 static inline int RoundUp(int iVal, int iRnd)
@@ -179,12 +202,12 @@ static inline int RoundUp(int iVal, int iRnd)
 static string input_file;
 static string output_file;
 static string cmd_file;
+static string twopass_log;
 
-static ifstream infile;
-static ofstream outfile;
 static int user_slice = 0;
-
-static OMX_PARAM_PORTDEFINITIONTYPE paramPort;
+static bool no_copy = false;
+static bool direct_io = false;
+static int num_segments = 1;
 
 static OMX_ERRORTYPE setEnableLongTerm(Application& app)
 {
@@ -209,16 +232,16 @@ static OMX_ERRORTYPE setPortParameters(Application& app)
 
   OMX_CALL(OMX_SetParameter(app.hEncoder, OMX_IndexParamVideoPortFormat, &inParamFormat));
 
-  initHeader(paramPort);
-  paramPort.nPortIndex = 0;
-  OMX_CALL(OMX_GetParameter(app.hEncoder, OMX_IndexParamPortDefinition, &paramPort));
-  paramPort.format.video.nFrameWidth = app.settings.width;
-  paramPort.format.video.nFrameHeight = app.settings.height;
-  paramPort.format.video.nStride = is10bits(app.settings.format) ? ((app.settings.width + 2) / 3) * 4 : app.settings.width;
-  paramPort.format.video.nSliceHeight = RoundUp(app.settings.height, 8);
+  initHeader(app.paramPort);
+  app.paramPort.nPortIndex = 0;
+  OMX_CALL(OMX_GetParameter(app.hEncoder, OMX_IndexParamPortDefinition, &app.paramPort));
+  app.paramPort.format.video.nFrameWidth = app.settings.width;
+  app.paramPort.format.video.nFrameHeight = app.settings.height;
+  app.paramPort.format.video.nStride = is10bits(app.settings.format) ? ((app.settings.width + 2) / 3) * 4 : app.settings.width;
+  app.paramPort.format.video.nSliceHeight = RoundUp(app.settings.height, 8);
 
-  OMX_CALL(OMX_SetParameter(app.hEncoder, OMX_IndexParamPortDefinition, &paramPort));
-  OMX_CALL(OMX_GetParameter(app.hEncoder, OMX_IndexParamPortDefinition, &paramPort));
+  OMX_CALL(OMX_SetParameter(app.hEncoder, OMX_IndexParamPortDefinition, &app.paramPort));
+  OMX_CALL(OMX_GetParameter(app.hEncoder, OMX_IndexParamPortDefinition, &app.paramPort));
 
   Setters setter(&app.hEncoder);
   auto isBufModeSetted = setter.SetBufferMode(app.input.index, GetBufferMode(app.input.isDMA));
@@ -253,6 +276,15 @@ static OMX_ERRORTYPE setPortParameters(Application& app)
   }
 #endif
 
+  if(app.settings.sceneChangeDetection)
+  {
+    OMX_ALG_VIDEO_PARAM_SCENE_CHANGE_DETECTION scd;
+    initHeader(scd);
+    scd.nPortIndex = 1;
+    scd.bEnableSceneChangeDetection = OMX_TRUE;
+    OMX_SetParameter(app.hEncoder, static_cast<OMX_INDEXTYPE>(OMX_ALG_IndexParamVideoSceneChangeDetection), &scd);
+  }
+
   OMX_PARAM_PORTDEFINITIONTYPE paramPortForActual;
   initHeader(paramPortForActual);
   paramPortForActual.nPortIndex = 0;
@@ -263,7 +295,7 @@ static OMX_ERRORTYPE setPortParameters(Application& app)
   OMX_CALL(OMX_GetParameter(app.hEncoder, OMX_IndexParamPortDefinition, &paramPortForActual));
   paramPortForActual.nBufferCountActual = paramPortForActual.nBufferCountMin + 4; // alloc max for b frames
   OMX_CALL(OMX_SetParameter(app.hEncoder, OMX_IndexParamPortDefinition, &paramPortForActual));
-  OMX_CALL(OMX_GetParameter(app.hEncoder, OMX_IndexParamPortDefinition, &paramPort));
+  OMX_CALL(OMX_GetParameter(app.hEncoder, OMX_IndexParamPortDefinition, &app.paramPort));
 
   setEnableLongTerm(app);
 
@@ -307,8 +339,13 @@ static void parseCommandLine(int argc, char** argv, Application& app)
   opt.addFlag("--dma-out", &app.output.isDMA, "Use dmabufs on output port");
   opt.addInt("--subframe", &user_slice, "<4 || 8 || 16>: activate subframe latency '(0)'");
   opt.addString("--cmd-file", &cmd_file, "File to precise for dynamic cmd");
+  opt.addFlag("--direct-io", &direct_io, "Write the output file with O_DIRECT");
+  opt.addFlag("--no-copy", &no_copy, "Input file frames are already laid out with the input port stride and slice height");
+  opt.addFlag("--scene-change-detection", &settings.sceneChangeDetection, "Look for scene changes in the 8 bits input frames");
 #if AL_ENABLE_TWOPASS
   opt.addInt("--lookahead", &settings.lookahead, "<0 || above 2>: activate lookahead mode '(0)'");
+  opt.addString("--twopass-log", &twopass_log, "First pass logfile, the input is cut at its scene changes");
+  opt.addInt("--segments", &num_segments, "Number of segments encoded concurrently, needs --twopass-log '(1)'");
 #endif
 
   opt.parse(argc, argv);
@@ -351,6 +388,13 @@ static void parseCommandLine(int argc, char** argv, Application& app)
     exit(1);
   }
 
+  if(num_segments < 1 || (num_segments > 1 && (twopass_log == "" || cmd_file != "")))
+  {
+    Usage(opt, argv[0]);
+    cerr << "[Error] segments need a first pass logfile and no cmd file" << endl;
+    exit(1);
+  }
+
   if(input_file == "")
   {
     Usage(opt, argv[0]);
@@ -382,41 +426,75 @@ static void parseCommandLine(int argc, char** argv, Application& app)
   }
 }
 
-static bool readOneYuvFrame(OMX_BUFFERHEADERTYPE* pBufferHdr, Application const& app)
+static int getYuvFrameSize(Settings const& settings)
 {
-  if(infile.peek() == EOF)
-    return false;
-
-  auto width = paramPort.format.video.nFrameWidth;
-  auto height = paramPort.format.video.nFrameHeight;
+  auto color = settings.format;
+  auto row_size = is10bits(color) ? (((settings.width + 2) / 3) * 4) : settings.width;
+  auto coef = is422(color) ? 1 : 2;
+  auto column_size = is400(color) ? settings.height : settings.height + settings.height / coef;
+  return row_size * column_size;
+}
 
-  static int input_frame_count;
-  LOGV("Reading input frame %i", input_frame_count);
-  auto stride = paramPort.format.video.nStride;
-  auto sliceHeight = paramPort.format.video.nSliceHeight;
-  LOGV("%dx%d, stride %d, sliceHeight %d", (int)width, (int)height, (int)stride, (int)sliceHeight);
-  input_frame_count++;
+/* --no-copy: the frames of the input file have the layout of the input port buffers */
+static int getInputFrameSize(Application const& app)
+{
+  if(!no_copy)
+    return getYuvFrameSize(app.settings);
 
   auto color = app.settings.format;
-  auto row_size = is10bits(color) ? (((width + 2) / 3) * 4) : width;
+  auto stride = app.paramPort.format.video.nStride;
+  auto sliceHeight = app.paramPort.format.video.nSliceHeight;
   auto coef = is422(color) ? 1 : 2;
-  auto column_size = is400(color) ? height : height + height / coef;
-  auto size = row_size * column_size;
-  vector<uint8_t> frame(size);
+  return is400(color) ? stride * sliceHeight : stride * (sliceHeight + sliceHeight / coef);
+}
 
-  infile.read((char*)frame.data(), frame.size());
+static void copyRows(char* dst, int dstStride, uint8_t const* src, int srcStride, int rowSize, int numRows)
+{
+  if(dstStride == srcStride && numRows > 0)
+  {
+    memcpy(dst, src, srcStride * (numRows - 1) + rowSize);
+    return;
+  }
 
-  auto dst = Buffer_MapData((char*)(pBufferHdr->pBuffer + pBufferHdr->nOffset), pBufferHdr->nAllocLen, app.input.isDMA);
+  for(auto h = 0; h < numRows; h++)
+    memcpy(&dst[h * dstStride], &src[h * srcStride], rowSize);
+}
 
-  /* luma */
-  for(auto h = 0; h < (int)height; h++)
-    memcpy(&dst[h * stride], &frame.data()[h * row_size], row_size);
+static bool readOneYuvFrame(OMX_BUFFERHEADERTYPE* pBufferHdr, Application& app)
+{
+  auto frame = app.reader->next();
 
-  /* chroma */
-  if(!is400(color))
+  if(!frame)
+    return false;
+
+  auto width = app.paramPort.format.video.nFrameWidth;
+  auto height = app.paramPort.format.video.nFrameHeight;
+
+  LOGV("Reading input frame %i", app.firstFrame + app.frame);
+  auto stride = app.paramPort.format.video.nStride;
+  auto sliceHeight = app.paramPort.format.video.nSliceHeight;
+  LOGV("%dx%d, stride %d, sliceHeight %d", (int)width, (int)height, (int)stride, (int)sliceHeight);
+
+  auto dst = Buffer_MapData((char*)(pBufferHdr->pBuffer + pBufferHdr->nOffset), pBufferHdr->nAllocLen, app.input.isDMA);
+
+  if(no_copy)
   {
-    for(struct { long unsigned int sh; long unsigned int h; } v { sliceHeight, height }; v.sh < sliceHeight + height / coef; v.sh++, v.h++)
-      memcpy(&dst[v.sh * stride], &frame.data()[v.h * row_size], row_size);
+    auto size = getInputFrameSize(app);
+    assert(size <= (int)pBufferHdr->nAllocLen);
+    memcpy(dst, frame, size);
+  }
+  else
+  {
+    auto color = app.settings.format;
+    auto row_size = is10bits(color) ? (((width + 2) / 3) * 4) : width;
+    auto coef = is422(color) ? 1 : 2;
+
+    /* luma */
+    copyRows(dst, stride, frame, row_size, row_size, height);
+
+    /* chroma */
+    if(!is400(color))
+      copyRows(&dst[sliceHeight * stride], stride, &frame[height * row_size], row_size, row_size, height / coef);
   }
 
   pBufferHdr->nFilledLen = pBufferHdr->nAllocLen;
@@ -488,9 +566,8 @@ static OMX_ERRORTYPE onComponentEvent(OMX_HANDLETYPE hComponent, OMX_PTR pAppDat
 
 static void Read(OMX_BUFFERHEADERTYPE* pBuffer, Application& app)
 {
-  static int frame = 0;
   pBuffer->nFlags = 0; // clear flags;
-  auto eos = (readOneYuvFrame(pBuffer, app) == false);
+  auto eos = (app.numFrames >= 0 && app.frame >= app.numFrames) || (readOneYuvFrame(pBuffer, app) == false);
   pBuffer->nFlags |= OMX_BUFFERFLAG_ENDOFFRAME;
 
   if(eos)
@@ -501,8 +578,8 @@ static void Read(OMX_BUFFERHEADERTYPE* pBuffer, Application& app)
     return;
   }
 
-  app.encCmd->Process(app.cmdSender, frame);
-  frame++;
+  app.encCmd->Process(app.cmdSender, app.frame);
+  app.frame++;
 }
 
 static OMX_ERRORTYPE onInputBufferAvailable(OMX_HANDLETYPE hComponent, OMX_PTR pAppData, OMX_BUFFERHEADERTYPE* pBuffer)
@@ -541,31 +618,22 @@ static OMX_ERRORTYPE onOutputBufferAvailable(OMX_HANDLETYPE hComponent, OMX_PTR
   if(!pBufferHdr)
     assert(0);
 
-  auto zMapSize = pBufferHdr->nAllocLen;
-
-  if(zMapSize)
-  {
-    auto data = Buffer_MapData((char*)(pBufferHdr->pBuffer + pBufferHdr->nOffset), zMapSize, app->output.isDMA);
-
-    if(data)
-    {
-      outfile.write((char*)data, pBufferHdr->nFilledLen);
-      outfile.flush();
-    }
+  app->writer->write(pBufferHdr, { 0, pBufferHdr->nFilledLen, pBufferHdr->nFilledLen, 1 });
 
-    Buffer_UnmapData(data, zMapSize, app->output.isDMA);
-  }
+  return OMX_ErrorNone;
+}
 
+/* writer thread: the buffer was copied */
+static void onOutputBufferWritten(Application& app, OMX_BUFFERHEADERTYPE* pBufferHdr)
+{
   if(pBufferHdr->nFlags & OMX_BUFFERFLAG_EOS)
   {
-    app->eof.notify();
-    app->output.isEOS = true;
+    app.output.isEOS = true;
+    app.eof.notify();
   }
   pBufferHdr->nFilledLen = 0;
   pBufferHdr->nFlags = 0;
-  OMX_CALL(OMX_FillThisBuffer(hComponent, pBufferHdr));
-
-  return OMX_ErrorNone;
+  OMX_FillThisBuffer(app.hEncoder, pBufferHdr);
 }
 
 static void useBuffers(OMX_U32 nPortIndex, bool use_dmabuf, Application& app)
@@ -682,37 +750,36 @@ static OMX_ERRORTYPE showComponentVersion(Application& app)
   return OMX_ErrorNone;
 }
 
-static OMX_ERRORTYPE safeMain(int argc, char** argv)
+static OMX_ERRORTYPE openFiles(Application& app, string const& output)
 {
-  Application app;
-  SetDefaultApplication(app);
-  parseCommandLine(argc, argv, app);
-
-  infile.open(input_file, ios::binary);
+  app.reader.reset(new YuvReader(input_file));
 
-  if(!infile.is_open())
+  if(!app.reader->isOpen())
   {
     cerr << "Error in opening input file '" << input_file.c_str() << "'" << endl;
     return OMX_ErrorUndefined;
   }
 
-  outfile.open(output_file, ios::binary);
+  app.writer.reset(new AsyncWriter(output, app.output.isDMA, direct_io, [&app](OMX_BUFFERHEADERTYPE* pBufferHdr) {
+    onOutputBufferWritten(app, pBufferHdr);
+  }));
 
-  if(!outfile.is_open())
+  if(!app.writer->isOpen())
   {
-    cerr << "Error in opening output file '" << output_file.c_str() << "'" << endl;
+    cerr << "Error in opening output file '" << output.c_str() << "'" << endl;
     return OMX_ErrorUndefined;
   }
 
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE encode(Application& app)
+{
   LOGI("cmd file = %s\n", cmd_file.c_str());
   ifstream cmdfile(cmd_file != "" ? cmd_file.c_str() : "/dev/null");
   auto encCmd = CEncCmdMngr(cmdfile, 3, -1);
   app.encCmd = &encCmd;
 
-  OMX_CALL(OMX_Init());
-  auto scopeOMX = scopeExit([]() {
-    OMX_Deinit();
-  });
   auto component = chooseComponent(app.settings.codec);
 
   OMX_CALLBACKTYPE videoEncoderCallbacks;
@@ -731,6 +798,8 @@ static OMX_ERRORTYPE safeMain(int argc, char** argv)
   if(ret != OMX_ErrorNone)
     return ret;
 
+  app.reader->start(getInputFrameSize(app), app.firstFrame, app.numFrames);
+
   app.pAllocator = nullptr;
 
   if(app.input.isDMA || app.output.isDMA)
@@ -803,6 +872,7 @@ static OMX_ERRORTYPE safeMain(int argc, char** argv)
 
   app.eof.wait();
   LOGV("EOS received");
+  app.writer->close();
 
   /** send flush in input port */
   app.input.isFlushing = true;
@@ -829,13 +899,177 @@ static OMX_ERRORTYPE safeMain(int argc, char** argv)
 
   app.encoderEventState.wait();
 
-  infile.close();
-  outfile.close();
+  app.reader.reset();
   cmdfile.close();
 
   return OMX_ErrorNone;
 }
 
+#if AL_ENABLE_TWOPASS
+struct Segment
+{
+  int firstFrame;
+  int numFrames;
+};
+
+/* Cuts the input in segments of about the same length, each cut is moved to the closest scene change
+ * of the first pass when there is one within half a segment: the encoder of a segment starts with an IDR */
+static vector<Segment> chooseSegments(string const& logFile, int numSegments)
+{
+  TwoPassMngr log(logFile, 2);
+  auto numFrames = log.GetNumFrames();
+  vector<int> sceneChanges;
+
+  for(auto i = 0; i < numFrames; i++)
+  {
+    AL_TLookAheadMetaData meta;
+    log.GetFrame(&meta);
+
+    if(meta.bNextSceneChange)
+      sceneChanges.push_back(i + 1);
+  }
+
+  numSegments = max(1, min(numSegments, numFrames));
+  auto range = numFrames / numSegments / 2;
+  vector<int> cuts { 0 };
+
+  for(auto i = 1; i < numSegments; i++)
+  {
+    auto target = static_cast<int>(static_cast<int64_t>(i) * numFrames / numSegments);
+    auto cut = target;
+    auto distance = range + 1;
+    auto next = lower_bound(sceneChanges.begin(), sceneChanges.end(), target);
+
+    if(next != sceneChanges.end() && *next - target < distance)
+    {
+      cut = *next;
+      distance = *next - target;
+    }
+
+    if(next != sceneChanges.begin() && target - *(next - 1) < distance && *(next - 1) > cuts.back())
+      cut = *(next - 1);
+
+    if(cut > cuts.back())
+      cuts.push_back(cut);
+  }
+
+  vector<Segment> segments;
+
+  for(size_t i = 0; i < cuts.size(); i++)
+  {
+    auto isLast = (i + 1 == cuts.size());
+    segments.push_back({ cuts[i], isLast ? -1 : cuts[i + 1] - cuts[i] });
+    LOGI("Segment %zu : from frame %d (%d frames)\n", i, cuts[i], isLast ? numFrames - cuts[i] : cuts[i + 1] - cuts[i]);
+  }
+
+  return segments;
+}
+
+static string getSegmentFile(size_t segment)
+{
+  return output_file + ".segment" + to_string(segment);
+}
+
+/* One encoder component per segment, all running at the same time, the streams are then joined in order */
+static OMX_ERRORTYPE encodeSegments(Application const& app, vector<Segment> const& segments)
+{
+  vector<unique_ptr<Application>> apps;
+
+  for(size_t i = 0; i < segments.size(); i++)
+  {
+    auto segment = new Application;
+    apps.push_back(unique_ptr<Application>(segment));
+    SetDefaultApplication(*segment);
+    segment->settings = app.settings;
+    segment->input.isDMA = app.input.isDMA;
+    segment->output.isDMA = app.output.isDMA;
+    segment->firstFrame = segments[i].firstFrame;
+    segment->numFrames = segments[i].numFrames;
+
+    auto ret = openFiles(*segment, getSegmentFile(i));
+
+    if(ret != OMX_ErrorNone)
+      return ret;
+  }
+
+  vector<OMX_ERRORTYPE> errors(apps.size(), OMX_ErrorNone);
+  vector<thread> threads;
+
+  for(size_t i = 0; i < apps.size(); i++)
+  {
+    threads.push_back(thread([&, i]() {
+      try
+      {
+        errors[i] = encode(*apps[i]);
+      }
+      catch(runtime_error const& error)
+      {
+        cerr << "Segment " << i << ": " << error.what() << endl;
+        errors[i] = OMX_ErrorUndefined;
+      }
+    }));
+  }
+
+  for(auto& t: threads)
+    t.join();
+
+  for(auto error: errors)
+  {
+    if(error != OMX_ErrorNone)
+      return error;
+  }
+
+  ofstream outfile(output_file, ios::binary);
+
+  if(!outfile.is_open())
+  {
+    cerr << "Error in opening output file '" << output_file.c_str() << "'" << endl;
+    return OMX_ErrorUndefined;
+  }
+
+  // every segment starts with its parameter sets and an IDR, the elementary streams are simply concatenated
+  for(size_t i = 0; i < apps.size(); i++)
+  {
+    apps[i]->writer.reset();
+    ifstream stream(getSegmentFile(i), ios::binary);
+
+    if(stream.peek() != EOF)
+      outfile << stream.rdbuf();
+
+    stream.close();
+    remove(getSegmentFile(i).c_str());
+  }
+
+  return OMX_ErrorNone;
+}
+
+#endif
+
+static OMX_ERRORTYPE safeMain(int argc, char** argv)
+{
+  Application app;
+  SetDefaultApplication(app);
+  parseCommandLine(argc, argv, app);
+
+  OMX_CALL(OMX_Init());
+  auto scopeOMX = scopeExit([]() {
+    OMX_Deinit();
+  });
+
+#if AL_ENABLE_TWOPASS
+
+  if(num_segments > 1)
+    return encodeSegments(app, chooseSegments(twopass_log, num_segments));
+#endif
+
+  auto ret = openFiles(app, output_file);
+
+  if(ret != OMX_ErrorNone)
+    return ret;
+
+  return encode(app);
+}
+
 int main(int argc, char** argv)
 {
   OMX_ERRORTYPE ret;
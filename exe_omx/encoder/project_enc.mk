@@ -4,3 +4,7 @@ EXE_OMX_ENCODER_SRCS:=\
 	$(THIS.exe_omx_encoder)/main.cpp\
 	$(THIS.exe_omx_encoder)/CommandsSender.cpp\
 	$(THIS.exe_omx_encoder)/EncCmdMngr.cpp\
+	$(THIS.exe_omx_encoder)/YuvReader.cpp\
+
+UNITTESTS+=$(THIS.exe_omx_encoder)/YuvReader.cpp
+UNITTESTS+=$(shell find $(THIS.exe_omx_encoder)/unittests -name "*.cpp")
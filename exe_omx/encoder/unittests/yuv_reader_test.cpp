@@ -0,0 +1,173 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fcntl.h>
+#include <random>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "exe_omx/encoder/YuvReader.h"
+
+using namespace std;
+
+/* numFrames whole frames then half a frame */
+static vector<uint8_t> RandomInput(size_t frameSize, int numFrames)
+{
+  mt19937 random(static_cast<unsigned>(frameSize));
+  vector<uint8_t> input(frameSize * numFrames + frameSize / 2);
+
+  for(auto& byte : input)
+    byte = static_cast<uint8_t>(random());
+
+  return input;
+}
+
+static void WriteFully(int fd, vector<uint8_t> const& input, size_t chunkSize)
+{
+  for(size_t written = 0; written < input.size();)
+  {
+    auto ret = write(fd, input.data() + written, min(chunkSize, input.size() - written));
+
+    if(ret <= 0)
+      return;
+
+    written += ret;
+  }
+}
+
+/* the frames the reader hands out, compared byte per byte with the input */
+static void ExpectFrames(YuvReader& reader, vector<uint8_t> const& input, size_t frameSize, int firstFrame, int numFrames)
+{
+  auto numWholeFrames = static_cast<int>(input.size() / frameSize);
+  auto lastFrame = numFrames < 0 ? numWholeFrames : min(numWholeFrames, firstFrame + numFrames);
+
+  for(int frame = firstFrame; frame < lastFrame; ++frame)
+  {
+    auto data = reader.next();
+    ASSERT_NE(nullptr, data) << "frame " << frame;
+    ASSERT_TRUE(equal(data, data + frameSize, input.begin() + frame * frameSize)) << "frame " << frame;
+  }
+
+  // the partial last frame is dropped
+  EXPECT_EQ(nullptr, reader.next());
+  EXPECT_EQ(nullptr, reader.next());
+}
+
+struct Limits
+{
+  int firstFrame;
+  int numFrames;
+};
+
+static vector<Limits> const LIMITS =
+{
+  { 0, -1 }, { 0, 3 }, { 3, 4 }, { 8, -1 }, { 8, 5 }, { 10, -1 }, { 12, 2 }
+};
+
+/* larger than a page and not aligned on one */
+TEST(YuvReader, MappedFile)
+{
+  size_t const frameSize = 3 * 4096 + 17;
+  auto input = RandomInput(frameSize, 10);
+  auto path = testing::TempDir() + "yuv_reader_test.yuv";
+
+  {
+    auto file = fopen(path.c_str(), "wb");
+    ASSERT_NE(nullptr, file);
+    fwrite(input.data(), 1, input.size(), file);
+    fclose(file);
+  }
+
+  for(auto limits : LIMITS)
+  {
+    SCOPED_TRACE(testing::Message() << "first frame " << limits.firstFrame << ", " << limits.numFrames << " frames");
+    YuvReader reader(path);
+    ASSERT_TRUE(reader.isOpen());
+    reader.start(frameSize, limits.firstFrame, limits.numFrames);
+    ExpectFrames(reader, input, frameSize, limits.firstFrame, limits.numFrames);
+  }
+
+  remove(path.c_str());
+}
+
+/* the frames before the first one are read and dropped, the writes don't match the frames */
+TEST(YuvReader, Pipe)
+{
+  size_t const frameSize = 999;
+  auto input = RandomInput(frameSize, 10);
+  auto path = testing::TempDir() + "yuv_reader_test.fifo";
+  remove(path.c_str());
+  ASSERT_EQ(0, mkfifo(path.c_str(), 0600));
+
+  for(auto limits : LIMITS)
+  {
+    SCOPED_TRACE(testing::Message() << "first frame " << limits.firstFrame << ", " << limits.numFrames << " frames");
+
+    // the input fits in the pipe: the producer is done even if the reader stops early
+    thread producer([&]
+    {
+      auto fd = open(path.c_str(), O_WRONLY);
+
+      if(fd == -1)
+        return;
+      WriteFully(fd, input, 333);
+      close(fd);
+    });
+
+    {
+      YuvReader reader(path);
+      EXPECT_TRUE(reader.isOpen());
+
+      if(reader.isOpen())
+      {
+        reader.start(frameSize, limits.firstFrame, limits.numFrames);
+        ExpectFrames(reader, input, frameSize, limits.firstFrame, limits.numFrames);
+      }
+    }
+
+    producer.join();
+  }
+
+  remove(path.c_str());
+}
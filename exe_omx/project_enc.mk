@@ -6,6 +6,8 @@ include $(THIS.exe_omx_enc)/encoder/project_enc.mk
 
 EXE_OMX_ENCODER_OBJ:=$(EXE_OMX_COMMON_OBJ)
 EXE_OMX_ENCODER_OBJ+=$(EXE_OMX_ENCODER_SRCS:%=$(BIN)/%.o)
+# the segmented two-pass driver reads the first pass logfile: the object is shared with the encoder library, so it is built position independent
+EXE_OMX_ENCODER_OBJ+=$(filter %/TwoPassMngr.cpp.o,$(OMX_MODULE_ENC_SRCS:%=$(BIN)/%.o))
 
 ifneq ($(LINK_SHARED_CTRLSW), 1)
 $(BIN)/$(EXE_NAME_ENC): $(EXE_OMX_ENCODER_OBJ) $(LIBS_ENCODE) $(LIB_OMX_CORE)
@@ -14,6 +16,9 @@ LDFLAGS+=-lallegro_encode
 $(BIN)/$(EXE_NAME_ENC): $(EXE_OMX_ENCODER_OBJ) $(LIB_OMX_CORE)
 endif
 
+$(BIN)/$(EXE_NAME_ENC): CFLAGS+=-fPIC
+$(BIN)/$(EXE_NAME_ENC): LDFLAGS+=-lpthread
+
 omx_encoder: $(BIN)/$(EXE_NAME_ENC)
 
 .PHONY: omx_encoder
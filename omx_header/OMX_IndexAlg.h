@@ -83,6 +83,7 @@ typedef enum OMX_ALG_INDEXTYPE
   OMX_ALG_IndexParamVideoInterlaceFormatCurrent,      /**< reference: OMX_INTERLACEFORMATTYPE */
   OMX_ALG_IndexParamVideoLongTerm,                    /**< reference: OMX_ALG_VIDEO_PARAM_LONG_TERM */
   OMX_ALG_IndexParamVideoLookAhead,                    /**< reference: OMX_ALG_VIDEO_PARAM_LOOKAHEAD */
+  OMX_ALG_IndexParamVideoSceneChangeDetection,        /**< reference: OMX_ALG_VIDEO_PARAM_SCENE_CHANGE_DETECTION */
 
   /* Vendor Video configrations */
   OMX_ALG_IndexConfigVendorVideoStartUnused = OMX_IndexVendorStartUnused + 0x00380000,
@@ -92,6 +93,7 @@ typedef enum OMX_ALG_INDEXTYPE
   OMX_ALG_IndexConfigVideoNotifySceneChange,                  /**< reference: OMX_ALG_VIDEO_CONFIG_NOTIFY_SCENE_CHANGE */
   OMX_ALG_IndexConfigVideoInsertLongTerm,                     /**< reference: OMX_ALG_VIDEO_CONFIG_INSERT */
   OMX_ALG_IndexConfigVideoUseLongTerm,                        /**< reference: OMX_ALG_VIDEO_CONFIG_INSERT */
+  OMX_ALG_IndexConfigVideoQuantizationParameterTable,         /**< reference: OMX_ALG_VIDEO_CONFIG_QUANTIZATION_PARAMETER_TABLE */
 
   /* Vender Image & Video common configurations */
   OMX_ALG_IndexVendorCommonStartUnused = OMX_IndexVendorStartUnused + 0x00700000,
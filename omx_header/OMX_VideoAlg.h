@@ -279,6 +279,24 @@ typedef struct OMX_ALG_VIDEO_PARAM_LOOKAHEAD
   OMX_U32 nLookAhead;
 }OMX_ALG_VIDEO_PARAM_LOOKAHEAD;
 
+/**
+ * Scene change detection parameters
+ *
+ * STRUCT MEMBERS:
+ *  nSize                       : Size of the structure in bytes
+ *  nVersion                    : OMX specification version information
+ *  nPortIndex                  : Port that this structure applies to
+ *  bEnableSceneChangeDetection : Indicate if the component should look for scene changes in the input frames
+ *                                (8 bits input without lookahead only)
+ */
+typedef struct OMX_ALG_VIDEO_PARAM_SCENE_CHANGE_DETECTION
+{
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_U32 nPortIndex;
+  OMX_BOOL bEnableSceneChangeDetection;
+}OMX_ALG_VIDEO_PARAM_SCENE_CHANGE_DETECTION;
+
 /**
  * Scene change resilience parameters
  *
@@ -719,6 +737,37 @@ typedef struct OMX_ALG_VIDEO_CONFIG_NOTIFY_SCENE_CHANGE
   OMX_U32 nLookAhead;
 }OMX_ALG_VIDEO_CONFIG_NOTIFY_SCENE_CHANGE;
 
+/**
+ * Structure for attaching a precomputed QP table to an input buffer,
+ * used instead of the regions of interest for this frame
+ *
+ * STRUCT MEMBERS:
+ *  nSize         : Size of the structure in bytes
+ *  nVersion      : OMX specification version information
+ *  nPortIndex    : Port that this structure applies to
+ *  pBufferHeader : Input buffer the table applies to, NULL for the next one emptied
+ *  pTable        : One QP delta per LCU in raster order, copied before SetConfig returns
+ *  nFilledLen    : Size of pTable in bytes (GetConfig: number of LCUs)
+ *  bUseFd        : Take the table from nFd instead of pTable
+ *  nFd           : Dmabuf holding the table in the encoder layout, used without copy when bUseFd is set.
+ *                  It must stay valid until the input buffer is returned
+ *  nAllocLen     : GetConfig only: size of the encoder layout
+ *  nOffset       : GetConfig only: offset of the table in the encoder layout
+ */
+typedef struct OMX_ALG_VIDEO_CONFIG_QUANTIZATION_PARAMETER_TABLE
+{
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_U32 nPortIndex;
+  OMX_BUFFERHEADERTYPE* pBufferHeader;
+  OMX_U8* pTable;
+  OMX_U32 nFilledLen;
+  OMX_BOOL bUseFd;
+  OMX_S32 nFd;
+  OMX_U32 nAllocLen;
+  OMX_U32 nOffset;
+}OMX_ALG_VIDEO_CONFIG_QUANTIZATION_PARAMETER_TABLE;
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */